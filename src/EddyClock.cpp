@@ -6,90 +6,478 @@
 
 #include <chrono>
 #include <cstdio>
+#include <cstring>
 
 #include "rv3028.h"
+#include "asset_pack.h"
+#include "chime.h"
 #include "hardware/gpio.h"
 #include "hardware/i2c.h"
+#include "hardware/watchdog.h"
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include "event_log.h"
+#include "i2c_bus.h"
+#include "power.h"
+#include "rtc_calibration.h"
+#include "trace.h"
+#include "tz.h"
+extern "C" {
+#include "oled_animations.h"
+#include "oled_static_data.h"
+}
 
 #define WAKEUP_HOURS_REGISTER 0x00
 #define WAKEUP_MINUTES_REGISTER 0x01
 #define GOTOSLEEP_HOURS_REGISTER 0x02
 #define GOTOSLEEP_MINUTES_REGISTER 0x03
+// RTC user RAM, the user EEPROM is full
+#define THEME_USER_RAM 0
+
+// Time zone as a POSIX TZ rule. The RTC runs in UTC, the display, the schedule and the event log
+// in local time. E.g. "CET-1CEST,M3.5.0,M10.5.0/3", "EST5EDT,M3.2.0,M11.1.0" or
+// "AEST-10AEDT,M10.1.0,M4.1.0/3"; with "UTC0" the RTC's time is shown as it is.
+#define TIMEZONE                   "UTC0"
+
+// Night power profile, applied while in goto sleep mode
+#define NIGHT_DISPLAY_OFF          0  // 1 = panel stays off at night until a button is pressed
+#define NIGHT_WAKE_SECONDS         10 // how long a button press turns the panel on at night
+#define NIGHT_BAND_PAGE_START      0  // first page (8 rows) driven at night
+#define NIGHT_BAND_PAGES           8  // pages driven at night, 8 = whole panel
+
+// Clock profiles (power.h): the day and night profiles run the chip slower, the fast one is kept
+// for this long after a button, a command, a mode change or the chime
+#define POWER_INTERACTIVE_SECONDS  10
+
+// Let the stars on the moon twinkle while it is shown
+#define MOON_TWINKLE               1
+
+// Show the moon with a soft glow in four gray levels instead, this keeps the bus busy
+// with a plane every few milliseconds for as long as the moon is up and replaces the twinkle
+#define MOON_GLOW                  0
+
+// Show how much of the night has passed as a bar under the time, updated once a minute
+#define SLEEP_PROGRESS_BAR         1
+
+// Seconds during the day, never at night. Measured bus cost, address bytes included:
+//   SECONDS_DIGITS       two small digits next to am/pm, 28 bytes a second, 56 when the tens change,
+//                        31 bytes/s on average
+//   SECONDS_BLINK_COLON  the colon blinks, 26 bytes/s
+// The measured average is traced once a minute.
+#define SECONDS_OFF                0
+#define SECONDS_DIGITS             1
+#define SECONDS_BLINK_COLON        2
+#define SECONDS_DISPLAY            SECONDS_OFF
+
+// RTC calibration, started by holding the hours and minutes buttons at power up. The RV3028
+// clock output must be wired to CALIBRATION_CLKOUT_PIN, a PWM B input. The timer resolution
+// over the window is far below the 0.95 ppm offset step, the reference crystal is the limit:
+// set CALIBRATION_REF_PPM to its error when that is known, positive when it runs fast.
+#define CALIBRATION_CLKOUT_PIN     13
+#define CALIBRATION_SECONDS        60
+#define CALIBRATION_REF_PPM        0.0
+
+// Soft chime when wakeup mode starts, fading in from silence, any button stops it. Needs a
+// speaker or piezo on CHIME_PIN behind an RC low pass; the other pin of its PWM slice can't be
+// used for PWM then.
+#define WAKEUP_CHIME               0
+#define CHIME_PIN                  14
+
+// Burn-in protection, the image moves by a pixel every few minutes
+#define PIXEL_SHIFT_MINUTES        5
+
+// A main loop pass that takes longer than this resets the clock, which comes back through the
+// warm start path. The slowest pass, setting an alarm time, waits on two EEPROM writes.
+#define WATCHDOG_TIMEOUT_MS        500
+
+// Diagnostics page, shown while both alarm buttons are held, the hours button pages through
+// the rows and the minutes button switches to last night's summary from the event log. The
+// stats command prints the full counters, the log command the events.
+#define DIAGNOSTICS_OFF            0xFF
+
+// How long the selftest command lights every pixel
+#define SELFTEST_MS                2000
+
+// Characters received on stdio are collected from its interrupt, so a long configuration line
+// isn't lost while the main loop waits on the bus or the EEPROM
+#define CONFIG_RX_BUFFER           512
+static char config_rx[CONFIG_RX_BUFFER];
+static volatile uint32_t config_rx_head = 0;
+static volatile uint32_t config_rx_tail = 0;
+
+// The trace shares the uart with the commands and waits while one is coming in, but not for
+// a command somebody started typing and left
+#define CONFIG_TRACE_HOLD_MS       5000
+static absolute_time_t config_rx_last;
 
-EddyClock::EddyClock(i2c_inst_t * i2c) :
+static void configRxAvailable(void *)
+{
+    int c;
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT)
+    {
+        // a full buffer drops the rest, the parser then reports a broken command
+        if (config_rx_head - config_rx_tail < CONFIG_RX_BUFFER)
+        {
+            config_rx[config_rx_head % CONFIG_RX_BUFFER] = (char)c;
+            config_rx_head = config_rx_head + 1;
+        }
+    }
+}
+
+EddyClock::EddyClock(i2c_inst_t * i2c, i2c_inst_t * display_i2c, const warm_state_t * warm) :
     rv(i2c),
     button_hours(9),
     button_minutes(10),
     button_wakeup(11),
     button_sleep(12),
-    oled(false)
+    oled(display_i2c, false, warm != nullptr),
+    animator(oled)
 {
-    auto t = rv.getTime();
+    // GPIO 9-12
+    if (!button::startDebounce(9, 4))
+        printf("no PIO state machine for the buttons, reading them undebounced\r\n");
+    if (WAKEUP_CHIME && !chime_init(CHIME_PIN))
+        printf("no DMA channels for the chime\r\n");
+
+    night_wake_until = get_absolute_time();
+    interactive_until = get_absolute_time();
+    power_pinned = POWER_PROFILES;
+    last_second = 0xFF;
+    seconds_bytes = 0;
+    seconds_ticks = 0;
+    loop_passes = 0;
+    loop_worst_us = 0;
+    loop_busy_us = 0;
+    loop_idle_us = 0;
+    diagnostics_first = DIAGNOSTICS_OFF;
+    diagnostics_second = 0xFF;
+    diagnostics_night = false;
+    buttons_down = 0;
+    selftest_on = false;
+    selftest_until = get_absolute_time();
+
+    tz_rule_t rule;
+    if (!tz_parse(TIMEZONE, rule))
+    {
+        printf("time zone %s not understood, using UTC\r\n", TIMEZONE);
+        tz_parse("UTC0", rule);
+    }
+    tz_init(tz, rule);
+    restoreState(warm);
+
+    if (button_hours.isHeld() && button_minutes.isHeld())
+        calibrateRtc();
+}
+
+uint16_t timeToMinutes(rv3028::rv3028_time_t t)
+{
+    return t.hours * 60 + t.minutes;
+}
+
+rv3028::rv3028_time_t minutesToTime(uint16_t m)
+{
+    rv3028::rv3028_time_t t;
+    t.hours = m / 60;
+    t.minutes = m % 60;
+    t.seconds = 0;
+    return t;
+}
+
+bool isWakeupTime(rv3028::rv3028_time_t time, rv3028::rv3028_time_t wakeupTime, rv3028::rv3028_time_t gotoSleepTime)
+{
+    return Schedule::isWakeup(timeToMinutes(time), {timeToMinutes(wakeupTime), timeToMinutes(gotoSleepTime)});
+}
+
+void sleepProgress(rv3028::rv3028_time_t time, rv3028::rv3028_time_t wakeupTime, rv3028::rv3028_time_t gotoSleepTime,
+                   uint16_t & done, uint16_t & total)
+{
+    Schedule::sleepProgress(timeToMinutes(time), {timeToMinutes(wakeupTime), timeToMinutes(gotoSleepTime)}, done, total);
+}
+
+void EddyClock::calibrateRtc()
+{
+    printf("RTC calibration, %u s on GPIO %u\r\n", CALIBRATION_SECONDS, CALIBRATION_CLKOUT_PIN);
+    oled.renderIcon(Display::SUN);
+    oled.renderProgress(0, CALIBRATION_SECONDS);
+
+    uint32_t edges = 0;
+    uint64_t elapsed_us = 0;
+    bool ok = rv.startCalibrationClock();
+    ok = ok && rtc_calibration_measure(CALIBRATION_CLKOUT_PIN, CALIBRATION_SECONDS, edges, elapsed_us,
+            [](uint32_t done, uint32_t total, void * ctx) {
+                static_cast<Display *>(ctx)->renderProgress(done, total);
+            }, &oled);
+    rv.stopCalibrationClock();
+
+    if (ok)
+    {
+        // the clock output runs before the offset correction, so this is the crystal's own
+        // error and the old offset doesn't matter
+        double ppm = rtc_calibration_ppm(edges, elapsed_us, rv3028::CALIBRATION_CLOCK_HZ, CALIBRATION_REF_PPM);
+        int16_t steps = rtc_calibration_steps(ppm);
+        int16_t old_steps = rv.getOffset();
+        printf("%lu edges in %llu us, %.2f ppm, offset %d -> %d\r\n", (unsigned long)edges,
+               (unsigned long long)elapsed_us, ppm, old_steps, steps);
+        if (steps != old_steps && !rv.setOffset(steps))
+            printf("writing the offset failed\r\n");
+    }
+    else
+    {
+        printf("no clock on GPIO %u, offset unchanged\r\n", CALIBRATION_CLKOUT_PIN);
+    }
+    oled.hideProgress();
+
+    // the held buttons must not count as presses once the clock runs
+    while (button_hours.isHeld() || button_minutes.isHeld())
+        sleep_ms(10);
+}
+
+void EddyClock::restoreState(const warm_state_t * warm)
+{
+    // firmware before the clock ran in UTC left the UNIX time counter counting from the RTC's
+    // power up, the calendar has the time
+    if (!warm && rv.getUnixTime() < TZ_UNIX_2000)
+        rv.setUnixTime(tz_unix(rv.getDate(), rv.getTime()));
+
+    rv3028::rv3028_time_t t;
+    readLocal(today, t);
     last_time = t;
-    wakeup_time = getWakeupTime();
-    wakeup_time.seconds = 0;
-    gotosleep_time = getGotoSleepTime();
-    gotosleep_time.seconds = 0;
+    schedule_loaded = false;
+    // before anything is drawn, a theme the pack no longer has falls back to the built-in one
+    asset_theme_load(warm ? warm->theme : rv.getUserRam(THEME_USER_RAM));
+
+    if (warm)
+    {
+        // no EEPROM reads, the schedule table is only loaded once it is needed again
+        wakeup_time = minutesToTime(warm->wakeup);
+        gotosleep_time = minutesToTime(warm->gotosleep);
+        wakeup_today = minutesToTime(warm->wakeup_today);
+        gotosleep_today = minutesToTime(warm->gotosleep_today);
+        if (warm->month != today.month || warm->date != today.date)
+            resolveToday();
+    }
+    else
+    {
+        wakeup_time = getWakeupTime();
+        wakeup_time.seconds = 0;
+        gotosleep_time = getGotoSleepTime();
+        gotosleep_time.seconds = 0;
+        resolveToday();
+    }
+
+    // straight to the screen for the mode, the main loop carries on from there
+    is_wakeup_time = isWakeupTime(t, wakeup_today, gotosleep_today);
+    applyMode();
+    oled.renderIcon(is_wakeup_time ? Display::SUN : Display::MOON);
     oled.renderTime(t.hours, t.minutes);
-    is_wakeup_time = true;
+    printf("%s start, first pixel after %llu us\r\n", warm ? "warm" : "cold", (unsigned long long)time_us_64());
+
+    // clear whatever else is left of the image from before the reset
+    if (warm)
+        oled.render();
+    updateProgress(t);
+    logBoot(warm != nullptr);
 }
 
-int EddyClock::compareTime(rv3028::rv3028_time_t t1, rv3028::rv3028_time_t t2)
+void EddyClock::logBoot(bool warm)
 {
-    if (t1.hours > t2.hours ||
-        (t1.hours == t2.hours && t1.minutes > t2.minutes) )
-        return 1;
+    event_log_init();
 
-    if (t1.hours == t2.hours && t1.minutes == t2.minutes)
-        return 0;
+    // the RTC ran on its battery while the power was gone, it knows when that began
+    rv3028::rv3028_date_t lost_date;
+    rv3028::rv3028_time_t lost_time;
+    uint8_t switchovers = rv.takePowerLossStamp(lost_date, lost_time);
+    if (switchovers)
+    {
+        tz_civil(tz_local(tz, tz_unix(lost_date, lost_time)), lost_date, lost_time);
+        event_log_add(EVENT_POWER_LOST, 0, switchovers, event_time(lost_date, lost_time));
+    }
 
-    return -1;
+    logEvent(EVENT_RESET, !warm ? 0 : watchdog_enable_caused_reboot() ? 1 : 2, 0);
+    logEvent(EVENT_MODE, is_wakeup_time, 0);
 }
 
-uint16_t timeToMinutes(rv3028::rv3028_time_t t)
+void EddyClock::logEvent(event_type_t type, uint8_t arg, uint16_t value)
 {
-    return t.hours * 60 + t.minutes;
+    rv3028::rv3028_date_t d;
+    rv3028::rv3028_time_t t;
+    readLocal(d, t);
+    event_log_add(type, arg, value, event_time(d, t));
 }
 
-bool isWakeupTime(rv3028::rv3028_time_t time, rv3028::rv3028_time_t wakeupTime, rv3028::rv3028_time_t gotoSleepTime)
+void EddyClock::readLocal(rv3028::rv3028_date_t & date, rv3028::rv3028_time_t & time)
 {
-    auto time_m = timeToMinutes(time);
-    auto wakeupTime_m = timeToMinutes(wakeupTime);
-    auto gotoSleepTime_m = timeToMinutes(gotoSleepTime);
+    // the offset only has to be worked out again at a daylight saving change
+    uint32_t from = tz.from;
+    uint32_t local = tz_local(tz, rv.getUnixTime());
+    if (tz.from != from)
+        TRACE(TRACE_TZ_OFFSET, tz.offset / 60, tz.dst, tz.until);
+    tz_civil(local, date, time);
+}
 
-    if (wakeupTime_m <= gotoSleepTime_m)
+void EddyClock::setLocal(const rv3028::rv3028_date_t & date, const rv3028::rv3028_time_t & time)
+{
+    rv.setUnixTime(tz_utc(tz, tz_unix(date, time)));
+}
+
+void EddyClock::saveState()
+{
+    warm_state_t s = {
+        timeToMinutes(wakeup_time),
+        timeToMinutes(gotosleep_time),
+        timeToMinutes(wakeup_today),
+        timeToMinutes(gotosleep_today),
+        today.month,
+        today.date,
+        asset_theme(),
+    };
+    warm_state_save(s);
+}
+
+void EddyClock::loadSchedule()
+{
+    if (!schedule_loaded)
     {
-        // Normal range (e.g., 08:00–17:00)
-        return time_m >= wakeupTime_m && time_m < gotoSleepTime_m;
+        schedule.load(rv);
+        schedule_loaded = true;
     }
+}
+
+void EddyClock::resolveToday()
+{
+    loadSchedule();
+
+    Schedule::Times defaults = {timeToMinutes(wakeup_time), timeToMinutes(gotosleep_time)};
+    Schedule::Times times = schedule.resolve(today, defaults);
+    wakeup_today = minutesToTime(times.wakeup);
+    gotosleep_today = minutesToTime(times.gotosleep);
+    TRACE(TRACE_TODAY, today.month * 100 + today.date, times.wakeup, times.gotosleep);
+    saveState();
+}
+
+void EddyClock::applyMode()
+{
+    oled.setBrightness(is_wakeup_time ? 0xFF : 0x01);
+    if (is_wakeup_time)
+        oled.setActiveBand(0, 0);
     else
+        oled.setActiveBand(NIGHT_BAND_PAGE_START, NIGHT_BAND_PAGES);
+}
+
+bool EddyClock::updateSeconds(rv3028::rv3028_time_t t)
+{
+    if (SECONDS_DISPLAY == SECONDS_OFF || !is_wakeup_time)
+    {
+        oled.hideSeconds();
+        return false;
+    }
+
+    uint32_t bytes = i2c_bus_tx_bytes();
+    if (SECONDS_DISPLAY == SECONDS_DIGITS)
+        oled.renderSeconds(t.seconds);
+    else
+        oled.blinkColon(t.seconds % 2 == 0);
+    seconds_bytes += i2c_bus_tx_bytes() - bytes;
+
+    if (++seconds_ticks == 60)
     {
-        // Wrap-around range (e.g., 22:00–06:00)
-        return time_m >= wakeupTime_m || time_m <= gotoSleepTime_m;
+        TRACE(TRACE_SECONDS_COST, seconds_bytes / seconds_ticks);
+        seconds_bytes = 0;
+        seconds_ticks = 0;
     }
+    return true;
+}
+
+void EddyClock::updateProgress(rv3028::rv3028_time_t t)
+{
+    if (!SLEEP_PROGRESS_BAR || is_wakeup_time)
+    {
+        oled.hideProgress();
+        return;
+    }
+
+    uint16_t done, total;
+    sleepProgress(t, wakeup_today, gotosleep_today, done, total);
+    oled.renderProgress(done, total);
 }
 
 int EddyClock::run()
 {
+    watchdog_enable(WATCHDOG_TIMEOUT_MS, true);
+    stdio_set_chars_available_callback(configRxAvailable, nullptr);
+    power_init();
+
     while(true)
     {
-        button_hours.update();
-        button_minutes.update();
+        watchdog_update();
+        uint64_t pass_start = time_us_64();
+        uint32_t pass_bytes = i2c_bus_tx_bytes();
+
+        auto hours_state = button_hours.update();
+        auto minutes_state = button_minutes.update();
+        auto wakeup_state = button_wakeup.update();
+        auto sleep_state = button_sleep.update();
+        bool activity = hours_state != button::IDLE || minutes_state != button::IDLE ||
+                        wakeup_state != button::IDLE || sleep_state != button::IDLE;
+        activity |= selftest_on;
 
-        auto current_time = rv.getTime();
+        rv3028::rv3028_date_t d;
+        rv3028::rv3028_time_t current_time;
+        readLocal(d, current_time);
 
-        bool isWakeup = isWakeupTime(current_time, wakeup_time, gotosleep_time);
+        // today's times only change with the date
+        if (d.date != today.date || d.month != today.month || d.year != today.year)
+        {
+            today = d;
+            resolveToday();
+        }
 
-        if (is_wakeup_time != isWakeup)
+        bool isWakeup = isWakeupTime(current_time, wakeup_today, gotosleep_today);
+        bool mode_changed = is_wakeup_time != isWakeup;
+
+        if (mode_changed)
         {
             is_wakeup_time = isWakeup;
-            oled.setBrightness(is_wakeup_time ? 0xFF : 0x01);
+            applyMode();
+            updateProgress(current_time);
+            logEvent(EVENT_MODE, is_wakeup_time, 0);
+            if (WAKEUP_CHIME && is_wakeup_time)
+                chime_play(chime_wakeup);
         }
+        if (activity)
+            chime_stop();
+
+        // every press in goto sleep mode is logged, the morning summary counts them
+        uint8_t down = (hours_state == button::PRESSED) << 0 | (minutes_state == button::PRESSED) << 1 |
+                       (wakeup_state == button::PRESSED) << 2 | (sleep_state == button::PRESSED) << 3;
+        for (uint8_t b = 0; b < 4 && !is_wakeup_time; b++)
+            if ((down & ~buttons_down) >> b & 1)
+                logEvent(EVENT_BUTTON, b, 0);
+        buttons_down = down;
 
+        updateNightDisplay(activity);
+        updatePower(activity || mode_changed || config_rx_tail != config_rx_head);
+        bool display_busy = oled.transitionStep();
+        display_busy |= oled.grayStep();
+
+        serviceConfig();
+
+        // Diagnostics, both alarm buttons together
+        if (wakeup_state == button::PRESSED && sleep_state == button::PRESSED)
+        {
+            showDiagnostics();
+        }
+        else if (diagnostics_first != DIAGNOSTICS_OFF)
+        {
+            leaveDiagnostics();
+        }
         // Wakeup Time
-        if (button_wakeup.update() == button::PRESSED)
+        else if (wakeup_state == button::PRESSED)
         {
-            oled.renderIcon(SSD1306::SUN);
+            animator.stop();
+            oled.stopGray();
+            oled.renderIcon(Display::SUN);
+            oled.hideSeconds();
 
             //printf("%02u:%02u:%02u\r\n", t.hours, t.minutes, t.seconds);
             if (timeChanged(wakeup_time))
@@ -100,18 +488,25 @@ int EddyClock::run()
                 wakeup_time.hours = (wakeup_time.hours + 1) % 24;
                 wakeup_time.seconds = 0;
                 setWakeupTime(wakeup_time.hours, wakeup_time.minutes);
+                logEvent(EVENT_ALARM_SET, 0, timeToMinutes(wakeup_time));
+                resolveToday();
             }
             if (button_minutes.pollAction() == button::PRESS)
             {
                 wakeup_time.minutes = (wakeup_time.minutes + 1) % 60;
                 wakeup_time.seconds = 0;
                 setWakeupTime(wakeup_time.hours, wakeup_time.minutes);
+                logEvent(EVENT_ALARM_SET, 0, timeToMinutes(wakeup_time));
+                resolveToday();
             }
         }
         // Goto Sleep Time
-        else if (button_sleep.update() == button::PRESSED)
+        else if (sleep_state == button::PRESSED)
         {
-            oled.renderIcon(SSD1306::MOON);
+            animator.stop();
+            oled.stopGray();
+            oled.renderIcon(Display::MOON);
+            oled.hideSeconds();
 
             //printf("%02u:%02u:%02u\r\n", t.hours, t.minutes, t.seconds);
             if (timeChanged(gotosleep_time))
@@ -122,12 +517,16 @@ int EddyClock::run()
                 gotosleep_time.hours = (gotosleep_time.hours + 1) % 24;
                 gotosleep_time.seconds = 0;
                 setGotoSleepTime(gotosleep_time.hours, gotosleep_time.minutes);
+                logEvent(EVENT_ALARM_SET, 1, timeToMinutes(gotosleep_time));
+                resolveToday();
             }
             if (button_minutes.pollAction() == button::PRESS)
             {
                 gotosleep_time.minutes = (gotosleep_time.minutes + 1) % 60;
                 gotosleep_time.seconds = 0;
                 setGotoSleepTime(gotosleep_time.hours, gotosleep_time.minutes);
+                logEvent(EVENT_ALARM_SET, 1, timeToMinutes(gotosleep_time));
+                resolveToday();
             }
         }
         // Regular Time
@@ -135,15 +534,39 @@ int EddyClock::run()
         {
             //rv.printTime();
             auto t = current_time;
-            if ( compareTime(t, wakeup_time) == 1 &&   // current time is after wakeup time and before goto sleep time
-                 compareTime(t, gotosleep_time) == -1) // if gotosleep is on the same day
-                oled.renderIcon(SSD1306::SUN);
+            // the icon follows the mode, the same window as the brightness and the progress bar
+            if (is_wakeup_time)
+            {
+                animator.stop();
+                oled.stopGray();
+                oled.transitionIcon(Display::SUN);
+            }
             else
-                oled.renderIcon(SSD1306::MOON);
+            {
+                // the glow and the twinkle are drawn over the full size moon
+                constexpr bool big_moon_icon = Display::Profile::icon_moon == OLED_GLYPH_MOON;
+                bool big_moon = big_moon_icon && !asset_theme_replaces(OLED_GLYPH_MOON);
+                constexpr const Region & icon = Display::Profile::layout.icon;
+                oled.transitionIcon(Display::MOON);
+                if (MOON_GLOW && big_moon && !oled.isTransitioning())
+                    oled.startGray(&oled_moon_glow, icon.col, icon.page);
+                else if (MOON_TWINKLE && big_moon && !oled.isTransitioning())
+                    animator.play(&oled_moon_twinkle, icon.col, icon.page);
+            }
 
             if (timeChanged(t))
             {
+                display_busy = true;
+                if (t.minutes % PIXEL_SHIFT_MINUTES == 0)
+                    oled.pixelShiftStep();
                 oled.renderTime(t.hours, t.minutes);
+                updateProgress(t);
+            }
+
+            if (t.seconds != last_second)
+            {
+                last_second = t.seconds;
+                display_busy |= updateSeconds(t);
             }
 
             bool button_pressed = false;
@@ -158,13 +581,434 @@ int EddyClock::run()
                 button_pressed = true;
             }
             if (button_pressed)
-                rv.setTime(t.hours, t.minutes, 0);
+            {
+                logEvent(EVENT_TIME_SET, 0, timeToMinutes(t));
+                t.seconds = 0;
+                setLocal(today, t);
+            }
+        }
+
+        // animation frames only get the bus when nothing else needed it this pass
+        if (!display_busy)
+            animator.service();
+        // the trace goes out between commands, see config_protocol.h
+        if (config.idle() || absolute_time_diff_us(config_rx_last, get_absolute_time()) > CONFIG_TRACE_HOLD_MS * 1000)
+            trace_drain();
+
+        // a flash write stalls the whole chip, it gets a pass where nothing moves on the screen
+        // and the chime isn't waiting for its next block
+        bool busy = activity || i2c_bus_tx_bytes() != pass_bytes;
+        if (!busy && !display_busy && !oled.isTransitioning() && !oled.isGray() && !chime_playing() &&
+            event_log_flush_due())
+        {
+            watchdog_update();
+            event_log_flush();
+            busy = true;
         }
+
+        uint32_t pass_us = time_us_64() - pass_start;
+        loop_passes++;
+        if (pass_us > loop_worst_us)
+            loop_worst_us = pass_us;
+        if (busy)
+            loop_busy_us += pass_us;
+        else
+            loop_idle_us += pass_us;
     }
 
     return 1;
 }
 
+// The rows of the diagnostics page, in order, printStats() has the same with names
+void EddyClock::collectStats(uint32_t (&values)[STATS_COUNT])
+{
+    uint32_t i2c_transactions = 0, i2c_errors = 0, i2c_blocked_ms = 0, oled_bytes = 0, rtc_bytes = 0;
+    const i2c_bus_stats_t * bus = i2c_bus_stats();
+    for (int i = 0; i < I2C_BUS_MAX_TARGETS; i++)
+    {
+        i2c_transactions += bus[i].transactions;
+        i2c_errors += bus[i].errors;
+        i2c_blocked_ms += bus[i].blocked_us / 1000;
+        if (bus[i].addr == Display::Profile::i2c_addr)
+            oled_bytes = bus[i].tx_bytes;
+        else if (bus[i].addr == RV3028_I2C_ADDR)
+            rtc_bytes = bus[i].tx_bytes + bus[i].rx_bytes;
+    }
+    uint64_t loop_us = loop_busy_us + loop_idle_us;
+    uint32_t uptime_s = time_us_64() / 1000000;
+
+    int n = 0;
+    values[n++] = uptime_s;
+    values[n++] = uptime_s ? loop_passes / uptime_s : loop_passes;
+    values[n++] = loop_worst_us;
+    values[n++] = loop_us ? loop_busy_us * 1000 / loop_us : 0;
+    values[n++] = oled_bytes;
+    values[n++] = rtc_bytes;
+    values[n++] = i2c_transactions;
+    values[n++] = i2c_errors;
+    values[n++] = i2c_blocked_ms;
+    values[n++] = rv.getEepromCycles();
+}
+
+void EddyClock::printStats()
+{
+    static const char * const names[] = {
+        "uptime s", "loop passes/s", "worst pass us", "busy permille", "oled bytes", "rtc bytes",
+        "i2c transactions", "i2c errors", "i2c blocked ms", "eeprom cycles"
+    };
+    static_assert(count_of(names) == STATS_COUNT, "a name for every row");
+    uint32_t values[STATS_COUNT];
+    collectStats(values);
+    for (int i = 0; i < STATS_COUNT; i++)
+        printf("%d %-18s %lu\r\n", i, names[i], (unsigned long)values[i]);
+
+    const i2c_bus_stats_t * bus = i2c_bus_stats();
+    for (int i = 0; i < I2C_BUS_MAX_TARGETS && bus[i].addr; i++)
+        printf("i2c 0x%02x: %lu transactions, %lu bytes out, %lu in, %lu errors, %llu us blocked\r\n",
+               bus[i].addr, (unsigned long)bus[i].transactions, (unsigned long)bus[i].tx_bytes,
+               (unsigned long)bus[i].rx_bytes, (unsigned long)bus[i].errors, (unsigned long long)bus[i].blocked_us);
+    for (int i = 0; i <= ScreenLayout::count; i++)
+        printf("oled %-12s %lu bytes\r\n", i < ScreenLayout::count ? ScreenLayout::names[i] : "other",
+               (unsigned long)oled.regionBytes(i));
+}
+
+void EddyClock::showDiagnostics()
+{
+    bool redraw = false;
+    if (diagnostics_first == DIAGNOSTICS_OFF)
+    {
+        animator.stop();
+        diagnostics_first = 0;
+        redraw = true;
+        printStats();
+    }
+
+    if (button_minutes.pollAction() == button::PRESS)
+    {
+        diagnostics_night = !diagnostics_night;
+        diagnostics_first = 0;
+        redraw = true;
+    }
+    int count = diagnostics_night ? NIGHT_COUNT : STATS_COUNT;
+    if (button_hours.pollAction() == button::PRESS)
+    {
+        diagnostics_first = (diagnostics_first + Display::NUMBER_ROWS) % count;
+        redraw = true;
+    }
+
+    // the counters move all the time, once a second is enough to read them
+    auto t = rv.getTime();
+    if (redraw || t.seconds != diagnostics_second)
+    {
+        diagnostics_second = t.seconds;
+        uint32_t stats[STATS_COUNT], night[NIGHT_COUNT];
+        const uint32_t * values = stats;
+        if (diagnostics_night)
+        {
+            collectNight(night);
+            values = night;
+        }
+        else
+        {
+            collectStats(stats);
+        }
+        oled.renderNumbers(&values[diagnostics_first], count - diagnostics_first, diagnostics_first);
+    }
+}
+
+// Last night's summary rows, times as hhmm and 0 for what didn't happen
+void EddyClock::collectNight(uint32_t (&values)[NIGHT_COUNT])
+{
+    event_night_t night;
+    event_log_last_night(night);
+    auto time = [](uint16_t hhmm) -> uint32_t { return hhmm == event_night_t::NO_TIME ? 0 : hhmm; };
+
+    int n = 0;
+    values[n++] = time(night.bedtime);
+    values[n++] = time(night.first_press);
+    values[n++] = night.presses;
+    values[n++] = time(night.wakeup);
+    values[n++] = night.resets;
+}
+
+void EddyClock::printLog()
+{
+    uint32_t count = event_log_count();
+    event_t e;
+    for (uint32_t i = 0; event_log_get(i, e); i++)
+    {
+        // the uart takes a few seconds for a full log
+        watchdog_update();
+        rv3028::rv3028_date_t d;
+        rv3028::rv3028_time_t t;
+        event_time_unpack(e.when, d, t);
+        printf("20%02u-%02u-%02u %02u:%02u:%02u %-10s %u %u\r\n", d.year, d.month, d.date, t.hours, t.minutes,
+               t.seconds, event_name(e.type), e.arg, e.value);
+    }
+
+    event_night_t night;
+    event_log_last_night(night);
+    if (night.found)
+        printf("last night: bed %04u, %u presses, first %04u, wakeup %04u, %u resets\r\n", night.bedtime,
+               night.presses, night.first_press, night.wakeup, night.resets);
+    printf("ok log %lu %lu\r\n", (unsigned long)count, (unsigned long)event_log_lost());
+}
+
+void EddyClock::leaveDiagnostics()
+{
+    diagnostics_first = DIAGNOSTICS_OFF;
+    redrawFace();
+}
+
+void EddyClock::redrawFace()
+{
+    animator.stop();
+    oled.clearScreen();
+    // the clock face is drawn again from scratch on this pass
+    last_time.hours = 0xFF;
+    last_second = 0xFF;
+}
+
+bool EddyClock::selectTheme(uint8_t theme)
+{
+    asset_theme_load(theme);
+    redrawFace();
+    saveState();
+    return rv.setUserRam(THEME_USER_RAM, theme);
+}
+
+void EddyClock::serviceConfig()
+{
+    while (config_rx_tail != config_rx_head)
+    {
+        char c = config_rx[config_rx_tail % CONFIG_RX_BUFFER];
+        config_rx_tail = config_rx_tail + 1;
+        config_rx_last = get_absolute_time();
+        if (config.feed(c))
+            runCommand(config.result());
+    }
+
+    if (selftest_on && time_reached(selftest_until))
+    {
+        selftest_on = false;
+        oled.setEntireOn(false);
+    }
+}
+
+void EddyClock::runCommand(const ConfigParser::Result & r)
+{
+    if (r.error != ConfigParser::OK)
+    {
+        printf("err %s\r\n", ConfigParser::errorText(r.error));
+        return;
+    }
+
+    const uint32_t * v = r.argv;
+    switch (r.command)
+    {
+        case ConfigParser::DATE_TIME:
+        {
+            if (r.argc == 0)
+            {
+                rv3028::rv3028_date_t d;
+                rv3028::rv3028_time_t t;
+                readLocal(d, t);
+                printf("ok dt %u %u %u %u %u %u %u\r\n", d.year, d.month, d.date, d.weekday, t.hours, t.minutes, t.seconds);
+                return;
+            }
+            // the RTC doesn't check the date, it would count on from a 31st of April or a 29th
+            // of February outside a leap year
+            if (v[0] > 99 || v[1] < 1 || v[1] > 12 || v[2] < 1 || v[2] > tz_month_days(2000 + v[0], v[1]) ||
+                v[3] > 6 || v[4] > 23 || v[5] > 59 || v[6] > 59)
+                break;
+            logEvent(EVENT_TIME_SET, 1, v[4] * 60 + v[5]);
+            // local time, the weekday follows from the date
+            setLocal({0, (uint8_t)v[2], (uint8_t)v[1], (uint8_t)v[0]}, {(uint8_t)v[6], (uint8_t)v[5], (uint8_t)v[4]});
+            rv3028::rv3028_time_t t;
+            readLocal(today, t);
+            resolveToday();
+            printf("ok dt\r\n");
+            return;
+        }
+
+        case ConfigParser::ALARM:
+            if (r.argc == 0)
+            {
+                printf("ok alarm %02u%02u %02u%02u\r\n", wakeup_time.hours, wakeup_time.minutes,
+                       gotosleep_time.hours, gotosleep_time.minutes);
+                return;
+            }
+            // hhmm
+            if (v[0] / 100 > 23 || v[0] % 100 > 59 || v[1] / 100 > 23 || v[1] % 100 > 59)
+                break;
+            wakeup_time = minutesToTime(v[0] / 100 * 60 + v[0] % 100);
+            gotosleep_time = minutesToTime(v[1] / 100 * 60 + v[1] % 100);
+            if (!setWakeupTime(wakeup_time.hours, wakeup_time.minutes) ||
+                !setGotoSleepTime(gotosleep_time.hours, gotosleep_time.minutes))
+            {
+                printf("err eeprom\r\n");
+                return;
+            }
+            logEvent(EVENT_ALARM_SET, 0, timeToMinutes(wakeup_time));
+            logEvent(EVENT_ALARM_SET, 1, timeToMinutes(gotosleep_time));
+            resolveToday();
+            printf("ok alarm\r\n");
+            return;
+
+        case ConfigParser::SCHEDULE:
+        {
+            if (r.argc == 0)
+            {
+                loadSchedule();
+                printf("ok sched");
+                for (int i = 0; i < Schedule::ENTRIES; i++)
+                    printf(" %08lx", (unsigned long)schedule.raw(i));
+                printf("\r\n");
+                return;
+            }
+            // all or nothing, every entry is checked before the first one is written
+            Schedule::Entry e;
+            bool valid = true;
+            for (int i = 0; i < Schedule::ENTRIES; i++)
+                valid &= v[i] == Schedule::UNUSED || Schedule::decode(v[i], e);
+            if (!valid)
+                break;
+            printf(setSchedule(v) ? "ok sched\r\n" : "err eeprom\r\n");
+            return;
+        }
+
+        case ConfigParser::TIME_ZONE:
+        {
+            rv3028::rv3028_date_t d;
+            rv3028::rv3028_time_t t;
+            readLocal(d, t);
+            printf("ok tz %s %ld", tz_name(tz), (long)tz.offset / 60);
+            if (tz.until == UINT32_MAX)
+            {
+                printf("\r\n");
+                return;
+            }
+            // the last local time before the change
+            tz_civil(tz.until - 1 + tz.offset, d, t);
+            printf(" %02u%02u%02u %02u%02u\r\n", d.year, d.month, d.date, t.hours, t.minutes);
+            return;
+        }
+
+        case ConfigParser::POWER:
+            if (r.argc == 0)
+            {
+                printf("ok power %s %lu", power_profile_name(power_profile()), (unsigned long)power_sys_khz());
+                for (uint8_t p = 0; p < POWER_PROFILES; p++)
+                    printf(" %lu", (unsigned long)(power_time_us((power_profile_t)p) / 1000000));
+                printf("\r\n");
+                return;
+            }
+            if (v[0] > POWER_PROFILES)
+                break;
+            power_pinned = v[0];
+            printf("ok power\r\n");
+            return;
+
+        case ConfigParser::STATS:
+            printStats();
+            printf("ok stats\r\n");
+            return;
+
+        case ConfigParser::LOG:
+            printLog();
+            return;
+
+        case ConfigParser::THEME:
+            if (r.argc == 0)
+            {
+                for (uint8_t i = 0; i < asset_theme_count(); i++)
+                    printf("theme %u %s\r\n", i, asset_theme_name(i));
+                printf("ok theme %u\r\n", asset_theme());
+                return;
+            }
+            if (v[0] >= asset_theme_count())
+                break;
+            printf(selectTheme(v[0]) ? "ok theme\r\n" : "err rtc\r\n");
+            return;
+
+        case ConfigParser::PACK:
+            if (r.argc == 0)
+            {
+                if (asset_pack_size() == 0)
+                    printf("err no pack\r\n");
+                else
+                    printf("ok pack %lu %u\r\n", (unsigned long)asset_pack_size(), asset_theme_count() - 1);
+                return;
+            }
+        {
+            // the words as the RP2350 stores them, least significant byte first
+            uint8_t chunk[ASSET_PACK_CHUNK];
+            static_assert(sizeof(chunk) == (ConfigParser::MAX_ARGS - 1) * sizeof(uint32_t), "a line is a chunk");
+            memcpy(chunk, &v[1], sizeof(chunk));
+            uint8_t theme = asset_theme();
+            bool ok = asset_pack_write(v[0], chunk);
+            // the upload's first chunk switched to the built-in artwork
+            if (asset_theme() != theme)
+                redrawFace();
+            printf(ok ? "ok pack\r\n" : "err pack\r\n");
+            return;
+        }
+
+        case ConfigParser::SELFTEST:
+            selftest_on = true;
+            selftest_until = make_timeout_time_ms(SELFTEST_MS);
+            oled.setEntireOn(true);
+            printf("ok selftest\r\n");
+            return;
+
+        case ConfigParser::NONE:
+            break;
+    }
+    printf("err out of range\r\n");
+}
+
+bool EddyClock::setSchedule(const uint32_t * raw)
+{
+    loadSchedule();
+    bool ok = true;
+    for (int i = 0; i < Schedule::ENTRIES; i++)
+    {
+        // a slot that changes completely takes four EEPROM writes
+        watchdog_update();
+        ok &= schedule.storeRaw(rv, i, raw[i]);
+    }
+    resolveToday();
+    return ok;
+}
+
+void EddyClock::updateNightDisplay(bool activity)
+{
+    if (activity)
+        night_wake_until = make_timeout_time_ms(NIGHT_WAKE_SECONDS * 1000);
+
+    bool on = is_wakeup_time || !NIGHT_DISPLAY_OFF || !time_reached(night_wake_until);
+    if (on && !oled.isDisplayOn())
+    {
+        // the press that wakes the panel should not also change the time
+        button_hours.pollAction();
+        button_minutes.pollAction();
+    }
+    oled.setDisplayOn(on);
+}
+
+void EddyClock::updatePower(bool activity)
+{
+    if (activity || chime_playing())
+        interactive_until = make_timeout_time_ms(POWER_INTERACTIVE_SECONDS * 1000);
+
+    power_profile_t p = is_wakeup_time ? POWER_DAY : POWER_NIGHT;
+    if (!time_reached(interactive_until))
+        p = POWER_INTERACTIVE;
+    if (power_pinned != POWER_PROFILES)
+        p = (power_profile_t)power_pinned;
+    power_select(p);
+}
+
 rv3028::rv3028_time_t EddyClock::getWakeupTime()
 {
     rv3028::rv3028_time_t t;
@@ -5,13 +5,21 @@
 #ifndef EDDYCLOCK_CLOCK_H
 #define EDDYCLOCK_CLOCK_H
 
+#include "animator.h"
 #include "button.h"
+#include "config_protocol.h"
+#include "event_log.h"
 #include "rv3028.h"
+#include "schedule.h"
 #include "ssd1306.h"
+#include "tz.h"
+#include "warm_state.h"
 
 class EddyClock {
 public:
-    explicit EddyClock(i2c_inst_t * i2c);
+    // i2c is the RTC's bus, display_i2c the panel's, the same one when they share it. warm is
+    // the state snapshot from before a reset, nullptr after power on.
+    EddyClock(i2c_inst_t * i2c, i2c_inst_t * display_i2c, const warm_state_t * warm);
     ~EddyClock() = default;
 
     int run();
@@ -23,14 +31,73 @@ private:
     rv3028::rv3028_time_t getGotoSleepTime();
     bool setGotoSleepTime(uint16_t hours, uint16_t minutes);
 
+    void calibrateRtc();
+    void restoreState(const warm_state_t * warm);
+    void logBoot(bool warm);
+    void logEvent(event_type_t type, uint8_t arg, uint16_t value);
+    // the RTC runs in UTC, these convert with the time zone
+    void readLocal(rv3028::rv3028_date_t & date, rv3028::rv3028_time_t & time);
+    void setLocal(const rv3028::rv3028_date_t & date, const rv3028::rv3028_time_t & time);
+    void saveState();
+    void resolveToday();
+    void applyMode();
+
+    static constexpr int STATS_COUNT = 10;
+    void collectStats(uint32_t (&values)[STATS_COUNT]);
+    void printStats();
+    static constexpr int NIGHT_COUNT = 5;
+    void collectNight(uint32_t (&values)[NIGHT_COUNT]);
+    void printLog();
+    void showDiagnostics();
+    void leaveDiagnostics();
+    void redrawFace();
+    // load a theme and keep it in the RTC's user RAM, false when that write failed
+    bool selectTheme(uint8_t theme);
+    void serviceConfig();
+    void runCommand(const ConfigParser::Result & r);
+    void loadSchedule();
+    bool setSchedule(const uint32_t * raw);
+    void updateNightDisplay(bool activity);
+    void updatePower(bool activity);
+    void updateProgress(rv3028::rv3028_time_t t);
+    bool updateSeconds(rv3028::rv3028_time_t t);
+
     bool timeChanged(rv3028::rv3028_time_t t);
-    int compareTime(rv3028::rv3028_time_t t1, rv3028::rv3028_time_t t2);
 
     rv3028 rv;
+    tz_t tz;
     rv3028::rv3028_time_t last_time;
     rv3028::rv3028_time_t wakeup_time;
     rv3028::rv3028_time_t gotosleep_time;
+
+    // the pair in effect today, from the schedule profiles or the defaults above
+    Schedule schedule;
+    bool schedule_loaded;
+    rv3028::rv3028_date_t today;
+    rv3028::rv3028_time_t wakeup_today;
+    rv3028::rv3028_time_t gotosleep_today;
     bool is_wakeup_time;
+    absolute_time_t night_wake_until;
+    absolute_time_t interactive_until;
+    uint8_t power_pinned;       // profile kept by the power command, POWER_PROFILES = by activity
+    uint8_t last_second;
+    uint32_t seconds_bytes;
+    uint8_t seconds_ticks;
+
+    // performance counters since boot, a pass is busy when it sent something on the bus or had
+    // a button down, the rest is time a low power wait could have used
+    uint32_t loop_passes;
+    uint32_t loop_worst_us;
+    uint64_t loop_busy_us;
+    uint64_t loop_idle_us;
+    uint8_t diagnostics_first;  // first row of the diagnostics page, DIAGNOSTICS_OFF = not shown
+    uint8_t diagnostics_second;
+    bool diagnostics_night;     // last night's summary instead of the counters
+    uint8_t buttons_down;       // bit n = button n of EVENT_BUTTON, to log presses at night
+
+    ConfigParser config;
+    bool selftest_on;
+    absolute_time_t selftest_until;
 
     button button_hours;
     button button_minutes;
@@ -38,7 +105,8 @@ private:
     button button_wakeup;
     button button_sleep;
 
-    SSD1306 oled;
+    Display oled;
+    SpriteAnimator animator;
 };
 
 
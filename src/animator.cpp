@@ -0,0 +1,107 @@
+/**
+ * animator.cpp
+ *
+ * Plays delta encoded sprite animations on the SSD1306.
+ */
+
+#include "animator.h"
+
+// bus budget of a single service() call, roughly 1 ms at 800 kHz
+#define ANIMATOR_BYTES_PER_SERVICE 64
+
+SpriteAnimator::SpriteAnimator(Display & oled) :
+    _oled(oled),
+    _anim(nullptr),
+    _col(0),
+    _page(0),
+    _frame(0),
+    _span(0),
+    _in_frame(false),
+    _frame_due(false)
+{
+}
+
+SpriteAnimator::~SpriteAnimator()
+{
+    stop();
+}
+
+bool SpriteAnimator::frameTimer(repeating_timer_t * rt)
+{
+    auto * self = static_cast<SpriteAnimator *>(rt->user_data);
+    self->_frame_due = true;
+    return true;
+}
+
+void SpriteAnimator::play(const sprite_anim_t * anim, uint8_t col, uint8_t page)
+{
+    if (anim == _anim)
+        return;
+
+    stop();
+    _anim = anim;
+    _col = col;
+    _page = page;
+    _frame = 0;
+    _in_frame = false;
+    _frame_due = false;
+    add_repeating_timer_ms(anim->frame_ms, frameTimer, this, &_timer);
+}
+
+void SpriteAnimator::stop()
+{
+    if (_anim == nullptr)
+        return;
+
+    cancel_repeating_timer(&_timer);
+
+    // run the remaining deltas of the loop, they are small and leave the key frame showing
+    while (_frame != 0 || _in_frame)
+    {
+        if (!_in_frame)
+        {
+            _span = _anim->frame_spans[_frame];
+            _in_frame = true;
+        }
+        sendSpans(UINT16_MAX);
+    }
+    _anim = nullptr;
+}
+
+void SpriteAnimator::service()
+{
+    if (_anim == nullptr || !_oled.isDisplayOn())
+        return;
+
+    if (!_in_frame)
+    {
+        if (!_frame_due)
+            return;
+        _frame_due = false;
+        _span = _anim->frame_spans[_frame];
+        _in_frame = true;
+    }
+    sendSpans(ANIMATOR_BYTES_PER_SERVICE);
+}
+
+bool SpriteAnimator::sendSpans(uint16_t budget)
+{
+    // returns true when the frame is complete
+    uint16_t end = _anim->frame_spans[_frame + 1];
+    uint16_t sent = 0;
+    while (_span < end)
+    {
+        const sprite_span_t & s = _anim->spans[_span];
+        if (sent > 0 && sent + s.len > budget)
+            return false;
+
+        uint8_t col = _col + s.col;
+        _oled.renderArea(&_anim->data[s.offset], col, col + s.len - 1, _page + s.page, _page + s.page);
+        sent += s.len;
+        _span++;
+    }
+
+    _in_frame = false;
+    _frame = (_frame + 1) % _anim->frame_count;
+    return true;
+}
@@ -0,0 +1,50 @@
+/**
+ * animator.h
+ *
+ * Plays delta encoded sprite animations (see sprite_anim.h) on the SSD1306.
+ *
+ * A repeating timer marks frames as due at the animation's fixed rate, the bytes are sent from
+ * service() in the main loop, at most ANIMATOR_BYTES_PER_SERVICE per call. A frame that is not
+ * finished when the next one is due simply delays it, so a busy bus slows the animation down
+ * instead of queueing up work.
+ */
+
+#ifndef ANIMATOR_H
+#define ANIMATOR_H
+
+#include "pico/time.h"
+#include "ssd1306.h"
+extern "C" {
+#include "sprite_anim.h"
+}
+
+class SpriteAnimator {
+public:
+    explicit SpriteAnimator(Display & oled);
+    ~SpriteAnimator();
+
+    // Start playing an animation whose key frame is already on the display. Playing the same
+    // animation again is a no-op.
+    void play(const sprite_anim_t * anim, uint8_t col, uint8_t page);
+    // Stop, leaving the key frame on the display
+    void stop();
+
+    // Send the next spans of a due frame. Call it when the loop has no more important bus traffic.
+    void service();
+
+private:
+    static bool frameTimer(repeating_timer_t * rt);
+    bool sendSpans(uint16_t budget);
+
+    Display & _oled;
+    const sprite_anim_t * _anim;
+    uint8_t _col;
+    uint8_t _page;
+    uint8_t _frame;
+    uint16_t _span;
+    bool _in_frame;
+    volatile bool _frame_due;
+    repeating_timer_t _timer;
+};
+
+#endif // ANIMATOR_H
@@ -0,0 +1,170 @@
+/**
+ * asset_pack.cpp
+ *
+ * Themes from the asset pack in the flash.
+ */
+
+#include "asset_pack.h"
+
+#include <string.h>
+#include "asset_pack_format.h"
+#include "flash_data.h"
+extern "C" {
+#include "oled_static_data.h"
+}
+
+static_assert(OLED_GLYPH_COUNT <= 32, "the replaced glyphs are a 32 bit mask");
+static_assert(FLASH_PAGE_SIZE == ASSET_PACK_PAGE, "packs are padded to flash pages");
+static_assert(FLASH_PAGE_SIZE % ASSET_PACK_CHUNK == 0, "chunks fill pages exactly");
+
+static oled_glyph_t theme_glyphs[OLED_GLYPH_COUNT];
+static const oled_glyph_t * glyphs = oled_glyphs;
+static uint8_t theme = 0;
+static uint32_t replaced = 0;
+
+// the pack is checked on first use and again after an upload
+static bool checked = false;
+static bool valid = false;
+
+static uint32_t upload_next = FLASH_ASSET_PACK_SIZE;    // nothing being uploaded
+static uint8_t upload_page[FLASH_PAGE_SIZE];
+
+static const uint8_t * pack()
+{
+    return flash_data_xip(FLASH_ASSET_PACK_OFFSET);
+}
+
+static const asset_pack_header_t * header()
+{
+    return (const asset_pack_header_t *)pack();
+}
+
+static const asset_pack_entry_t * entries()
+{
+    return (const asset_pack_entry_t *)(pack() + sizeof(asset_pack_header_t) + header()->theme_count * ASSET_PACK_NAME_LEN);
+}
+
+static bool check()
+{
+    const asset_pack_header_t * h = header();
+    if (h->magic != ASSET_PACK_MAGIC || h->version != ASSET_PACK_VERSION || h->glyph_count != OLED_GLYPH_COUNT ||
+        h->size < sizeof(asset_pack_header_t) || h->size > FLASH_ASSET_PACK_SIZE || h->theme_count > ASSET_PACK_MAX_THEMES)
+        return false;
+    uint32_t tables = sizeof(asset_pack_header_t) + h->theme_count * ASSET_PACK_NAME_LEN +
+                      h->entry_count * sizeof(asset_pack_entry_t);
+    if (tables > h->size || asset_pack_crc(pack() + sizeof(asset_pack_header_t), h->size - sizeof(asset_pack_header_t)) != h->crc)
+        return false;
+
+    for (uint8_t t = 0; t < h->theme_count; t++)
+        if (pack()[sizeof(asset_pack_header_t) + (t + 1) * ASSET_PACK_NAME_LEN - 1] != '\0')
+            return false;
+
+    // A glyph must take the place of the built-in one exactly, the layout doesn't change, and
+    // decode to exactly its pages from its own bytes: the decoder trusts what passes here.
+    for (uint16_t i = 0; i < h->entry_count; i++)
+    {
+        const asset_pack_entry_t & e = entries()[i];
+        if (e.theme == 0 || e.theme > h->theme_count || e.glyph >= OLED_GLYPH_COUNT ||
+            e.offset < tables || e.offset > h->size || e.size > h->size - e.offset)
+            return false;
+        const oled_glyph_t & g = oled_glyphs[e.glyph];
+        const oled_glyph_t replacement = {pack() + e.offset, e.size, e.width, e.pages, e.encoding};
+        if (e.width != g.width || e.pages != g.pages || !oled_glyph_valid(&replacement))
+            return false;
+    }
+    return true;
+}
+
+static bool packValid()
+{
+    if (!checked)
+    {
+        valid = check();
+        checked = true;
+    }
+    return valid;
+}
+
+const oled_glyph_t * asset_glyphs()
+{
+    return glyphs;
+}
+
+bool asset_theme_replaces(uint8_t glyph)
+{
+    return glyph < OLED_GLYPH_COUNT && (replaced >> glyph & 1);
+}
+
+uint8_t asset_theme()
+{
+    return theme;
+}
+
+uint8_t asset_theme_count()
+{
+    return packValid() ? 1 + header()->theme_count : 1;
+}
+
+const char * asset_theme_name(uint8_t t)
+{
+    if (t == 0)
+        return "built-in";
+    if (t >= asset_theme_count())
+        return nullptr;
+    return (const char *)(pack() + sizeof(asset_pack_header_t) + (t - 1) * ASSET_PACK_NAME_LEN);
+}
+
+bool asset_theme_load(uint8_t t)
+{
+    glyphs = oled_glyphs;
+    theme = 0;
+    replaced = 0;
+    if (t == 0)
+        return true;
+    if (t >= asset_theme_count())
+        return false;
+
+    memcpy(theme_glyphs, oled_glyphs, sizeof(theme_glyphs));
+    for (uint16_t i = 0; i < header()->entry_count; i++)
+    {
+        const asset_pack_entry_t & e = entries()[i];
+        if (e.theme != t)
+            continue;
+        theme_glyphs[e.glyph] = {pack() + e.offset, e.size, e.width, e.pages, e.encoding};
+        replaced |= 1u << e.glyph;
+    }
+    glyphs = theme_glyphs;
+    theme = t;
+    return true;
+}
+
+uint32_t asset_pack_size()
+{
+    return packValid() ? header()->size : 0;
+}
+
+bool asset_pack_write(uint32_t offset, const uint8_t * data)
+{
+    if (offset == 0)
+    {
+        // nothing may point into the pack while it is rewritten
+        asset_theme_load(0);
+        checked = false;
+        upload_next = 0;
+    }
+    if (offset != upload_next || offset + ASSET_PACK_CHUNK > FLASH_ASSET_PACK_SIZE)
+        return false;
+
+    if (offset % FLASH_SECTOR_SIZE == 0 && !flash_data_erase(FLASH_ASSET_PACK_OFFSET + offset))
+        return false;
+    memcpy(&upload_page[offset % FLASH_PAGE_SIZE], data, ASSET_PACK_CHUNK);
+    uint32_t page_end = offset + ASSET_PACK_CHUNK;
+    if (page_end % FLASH_PAGE_SIZE == 0)
+    {
+        if (!flash_data_program(FLASH_ASSET_PACK_OFFSET + page_end - FLASH_PAGE_SIZE, upload_page))
+            return false;
+        checked = false;
+    }
+    upload_next = page_end;
+    return true;
+}
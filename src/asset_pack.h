@@ -0,0 +1,44 @@
+/**
+ * asset_pack.h
+ *
+ * Themes: other artwork for the glyphs, from an asset pack (asset_pack_format.h) in its own
+ * flash partition, see flash_data.h. The pack is read in place through XIP. Loading a theme
+ * checks the pack once and points the glyphs it replaces at their data in the pack, drawing
+ * then works on a pointer and a length as for the built-in artwork, with nothing copied.
+ *
+ * Theme 0 is the built-in artwork, always there. A new pack comes over the serial port in
+ * chunks written in order from offset 0, the built-in theme is loaded as the upload starts.
+ */
+
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <stdint.h>
+extern "C" {
+#include "oled_glyph.h"
+}
+
+#define ASSET_PACK_CHUNK 32     // bytes per asset_pack_write()
+
+// glyph table of the loaded theme, indexed by OLED_GLYPH_*
+const oled_glyph_t * asset_glyphs();
+// whether the loaded theme has its own artwork for a glyph
+bool asset_theme_replaces(uint8_t glyph);
+
+uint8_t asset_theme();
+// the built-in one included, 1 when there is no valid pack
+uint8_t asset_theme_count();
+// nullptr past the last theme
+const char * asset_theme_name(uint8_t theme);
+// false when the pack doesn't have the theme, the built-in one is loaded then
+bool asset_theme_load(uint8_t theme);
+
+// size of a valid pack, 0 when there is none; the check reads the whole pack once
+uint32_t asset_pack_size();
+
+// One chunk of ASSET_PACK_CHUNK bytes. A sector is erased when its first chunk arrives and a
+// page programmed with its last, which blocks for some 50 ms and 1 ms. false for a chunk out of
+// order or a flash operation that couldn't run, the same chunk can be sent again then.
+bool asset_pack_write(uint32_t offset, const uint8_t * data);
+
+#endif // ASSET_PACK_H
@@ -0,0 +1,66 @@
+/**
+ * asset_pack_format.h
+ *
+ * Asset pack: themes, each a set of glyphs that replace built-in ones of the same size. Written
+ * by tools/asset_compiler, read in place from the flash by asset_pack.cpp. Little endian, in
+ * this order:
+ *
+ *   asset_pack_header_t
+ *   theme names, ASSET_PACK_NAME_LEN bytes each, zero padded
+ *   asset_pack_entry_t for every glyph a theme replaces
+ *   glyph data in the oled_glyph_t encodings, at the offsets of the entries
+ *
+ * The pack is padded to a whole number of ASSET_PACK_PAGE bytes. Glyphs are named by their
+ * OLED_GLYPH_* index, so a pack only fits firmware built from the same manifest; glyph_count
+ * and the sizes of the replaced glyphs are checked against the firmware's.
+ */
+
+#ifndef ASSET_PACK_FORMAT_H
+#define ASSET_PACK_FORMAT_H
+
+#include <stdint.h>
+
+#define ASSET_PACK_MAGIC      0x4B415041    // "APAK"
+// bumped whenever the layout changes, packs in an older layout are then ignored
+#define ASSET_PACK_VERSION    1
+#define ASSET_PACK_NAME_LEN   12            // a name has at most ASSET_PACK_NAME_LEN - 1 characters
+#define ASSET_PACK_MAX_THEMES 15            // besides the built-in one
+#define ASSET_PACK_PAGE       256           // the flash page
+#define ASSET_PACK_MAX_SIZE   (64 * 1024)   // the flash partition
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t glyph_count;   // OLED_GLYPH_COUNT of the manifest
+    uint32_t size;          // of the whole pack, padding included
+    uint32_t crc;           // asset_pack_crc() of everything after the header
+    uint16_t entry_count;
+    uint8_t theme_count;
+    uint8_t reserved;
+} asset_pack_header_t;
+
+typedef struct {
+    uint32_t offset;        // of the data, from the start of the pack
+    uint16_t size;          // bytes of data
+    uint8_t theme;          // 1 for the pack's first theme, 0 is the built-in artwork
+    uint8_t glyph;          // OLED_GLYPH_* index replaced
+    uint8_t width;
+    uint8_t pages;
+    uint8_t encoding;       // OLED_GLYPH_RAW or OLED_GLYPH_RLE
+    uint8_t reserved;
+} asset_pack_entry_t;
+
+// CRC-32 as in zlib, bit at a time since a pack is only checked when a theme is loaded
+static inline uint32_t asset_pack_crc(const uint8_t * data, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++)
+            crc = crc >> 1 ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+#endif // ASSET_PACK_FORMAT_H
@@ -8,19 +8,72 @@
  * the_button.c
  *
  * Handle button input for the 'front button' of pico2maple.
- * Does debounce, and triggers short press or long hold events.
- * Short press: button is pressed and released before the time limit.
- * Long hold: button is pressed and held until the time limit.
+ * The debounce runs in a PIO state machine (buttons.pio), its interrupt latches presses and
+ * releases, which update() turns into PRESS and RELEASE actions.
  *
  * Copyright (c) 2025 Colin Luoma
  */
 
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
+#include "hardware/pio.h"
+#include "hardware/sync.h"
+#include "buttons.pio.h"
 
-#define DEBOUNCE_MS 30
+#define DEBOUNCE_SAMPLE_HZ 1000  // 30 samples to settle, see buttons.pio
 #define PRESSED_PIN_LEVEL 0  // This means button pressed results in pin going high
 
+// Debounced levels from the PIO program, bit n is pin debounce_first_pin + n. The interrupt
+// sets the edges, each button clears its own.
+static PIO debounce_pio;
+static uint debounce_sm;
+static uint8_t debounce_first_pin;
+static uint8_t debounce_count;
+static bool debounce_running = false;
+static volatile uint32_t debounced_levels;
+static volatile uint32_t pressed_edges;
+static volatile uint32_t released_edges;
+
+static void debounceIrq()
+{
+    while (!pio_sm_is_rx_fifo_empty(debounce_pio, debounce_sm))
+    {
+        uint32_t levels = pio_sm_get(debounce_pio, debounce_sm);
+        uint32_t changed = levels ^ debounced_levels;
+        uint32_t down = PRESSED_PIN_LEVEL ? levels : ~levels;
+        pressed_edges = pressed_edges | (changed & down);
+        released_edges = released_edges | (changed & ~down);
+        debounced_levels = levels;
+    }
+}
+
+bool button::startDebounce(uint8_t first_pin, uint8_t count)
+{
+    uint offset;
+    if (!pio_claim_free_sm_and_add_program_for_gpio_range(&buttons_program, &debounce_pio, &debounce_sm, &offset,
+                                                          first_pin, count, true))
+        return false;
+
+    // the program reports the levels it finds first, which match these and raise no edge
+    debounced_levels = gpio_get_all() >> first_pin & ((1u << count) - 1);
+    debounce_first_pin = first_pin;
+    debounce_count = count;
+
+    uint irq = pio_get_irq_num(debounce_pio, 0);
+    pio_set_irqn_source_enabled(debounce_pio, 0, pio_get_rx_fifo_not_empty_interrupt_source(debounce_sm), true);
+    irq_set_exclusive_handler(irq, debounceIrq);
+    irq_set_enabled(irq, true);
+    buttons_program_init(debounce_pio, debounce_sm, offset, first_pin, count, DEBOUNCE_SAMPLE_HZ);
+    debounce_running = true;
+    return true;
+}
+
+void button::clockChanged()
+{
+    if (debounce_running)
+        buttons_program_set_sample_rate(debounce_pio, debounce_sm, DEBOUNCE_SAMPLE_HZ);
+}
+
 button::button(uint8_t pin)
 {
     gpio_init(pin);
@@ -39,52 +92,44 @@ button::button(uint8_t pin)
 }
 
 button::State button::update() {
-    bool level = gpio_get(_pin);
-
-    switch (_state) {
-        case IDLE:
-            if (level == PRESSED_PIN_LEVEL && _last_gpio_level != PRESSED_PIN_LEVEL)
-            {
-                // Initial button press
-                _last_change = get_absolute_time();
-                _state = DEBOUNCE;
-            }
-            break;
-
-        case DEBOUNCE:
-            if (absolute_time_diff_us(_last_change, get_absolute_time()) > DEBOUNCE_MS)
-            {
-                if (level == PRESSED_PIN_LEVEL)
-                {
-                    // Confirmed press
-                    _state = PRESSED;
-                    _action = PRESS;
-                }
-                else
-                {
-                    // Bounce, return to idle
-                    _state = IDLE;
-                }
-            }
-            break;
-
-        case PRESSED:
-            if (level != PRESSED_PIN_LEVEL && _last_gpio_level == PRESSED_PIN_LEVEL) // button released
-            {
-                _state = IDLE;
-                _action = RELEASE;
-            }
-            // still being held
-            break;
+    bool down, pressed, released;
+    if (debounce_running && _pin >= debounce_first_pin && _pin < debounce_first_pin + debounce_count)
+    {
+        uint32_t bit = 1u << (_pin - debounce_first_pin);
+        uint32_t irqs = save_and_disable_interrupts();
+        down = ((debounced_levels & bit) != 0) == PRESSED_PIN_LEVEL;
+        pressed = pressed_edges & bit;
+        released = released_edges & bit;
+        pressed_edges = pressed_edges & ~bit;
+        released_edges = released_edges & ~bit;
+        restore_interrupts(irqs);
+    }
+    else
+    {
+        bool level = gpio_get(_pin);
+        down = level == PRESSED_PIN_LEVEL;
+        pressed = down && _last_gpio_level != PRESSED_PIN_LEVEL;
+        released = !down && _last_gpio_level == PRESSED_PIN_LEVEL;
+        _last_gpio_level = level;
     }
-    _last_gpio_level = level;
 
+    if (pressed)
+        _action = PRESS;
+    else if (released)
+        _action = RELEASE;
+
+    _state = down || pressed ? PRESSED : IDLE;
     return _state;
 }
 
+bool button::isHeld() const
+{
+    return gpio_get(_pin) == PRESSED_PIN_LEVEL;
+}
+
 button::Action button::pollAction()
 {
     const Action ret = _action;
     _action = NONE;
     return ret;
-}
\ No newline at end of file
+}
@@ -12,7 +12,6 @@ class button {
 public:
     enum State {
         IDLE,
-        DEBOUNCE,
         PRESSED
      };
 
@@ -25,8 +24,19 @@ public:
     button(uint8_t pin);
     ~button() = default;
 
+    // Hand the debounce of the contiguous pins first_pin..first_pin+count-1 to a PIO state
+    // machine, once all their buttons are constructed. Presses are then latched from its
+    // interrupt, so none are missed while the main loop is busy. Without it, or when no state
+    // machine is free, update() reads the pins as they are.
+    static bool startDebounce(uint8_t first_pin, uint8_t count);
+    // keeps the sample rate after clk_sys changed
+    static void clockChanged();
+
+    // a press shorter than the time between two calls still shows as PRESSED once
     State update();
     Action pollAction();
+    // raw pin level, no debounce, for checks at boot
+    bool isHeld() const;
 
 
 private:
@@ -34,8 +44,6 @@ private:
     State _state;
     Action _action;
     bool _last_gpio_level;
-    absolute_time_t _last_change;
-    absolute_time_t _press_start;
 };
 
 
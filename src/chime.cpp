@@ -0,0 +1,253 @@
+/**
+ * chime.cpp
+ *
+ * Wakeup chime, synthesis and PWM/DMA playback.
+ */
+
+#include "chime.h"
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/pwm.h"
+
+#define CHIME_BLOCK         256     // samples per DMA buffer, 16 ms
+#define CHIME_ATTACK        (CHIME_SAMPLE_HZ / 200)     // 5 ms, no click at the note start
+// the speaker rest level is reached from 0 and back at the ends of the tune
+#define CHIME_BIAS_RAMP     (CHIME_SAMPLE_HZ / 20)
+
+// C6 E6 G6 C7, each ringing out, then a breath
+static const chime_note_t wakeup_notes[] = {
+    {84, 4}, {88, 4}, {91, 4}, {96, 10}, {0, 6},
+};
+const chime_t chime_wakeup = {wakeup_notes, sizeof(wakeup_notes) / sizeof(wakeup_notes[0]), 4, 160, 8000};
+
+// phase step per sample for every note number, 2^32 is a full period
+struct PhaseSteps {
+    uint32_t step[128];
+    constexpr PhaseSteps() : step()
+    {
+        const double semitone = 1.0594630943592953;
+        for (int n = 0; n < 128; n++)
+        {
+            double f = 440.0;
+            for (int i = 69; i < n; i++)
+                f *= semitone;
+            for (int i = n; i < 69; i++)
+                f /= semitone;
+            // notes above the Nyquist frequency stay silent
+            step[n] = f < CHIME_SAMPLE_HZ / 2 ? (uint32_t)(f * 4294967296.0 / CHIME_SAMPLE_HZ) : 0;
+        }
+    }
+};
+static constexpr PhaseSteps phase_steps;
+
+static uint32_t noteSamples(const chime_note_t & n)
+{
+    return n.eighths * (CHIME_SAMPLE_HZ / 8);
+}
+
+static uint32_t passSamples(const chime_t & c)
+{
+    uint32_t len = 0;
+    for (uint8_t i = 0; i < c.count; i++)
+        len += noteSamples(c.notes[i]);
+    return len;
+}
+
+uint32_t chime_length(const chime_t & c)
+{
+    return passSamples(c) * c.repeats + CHIME_BIAS_RAMP;
+}
+
+// -32768..32768, a parabola for each half period, close enough to a sine for a bell
+static int32_t wave(uint32_t phase)
+{
+    int32_t x = (phase >> 16) & 0x7FFF;
+    int32_t y = (x * (32768 - x)) >> 13;
+    return phase & 0x80000000 ? -y : y;
+}
+
+static uint8_t level(const chime_t & c, uint32_t t, uint32_t pass, uint32_t length)
+{
+    if (t >= length)
+        return 0;
+
+    uint32_t bias = CHIME_SILENCE;
+    if (t < CHIME_BIAS_RAMP)
+        bias = CHIME_SILENCE * t / CHIME_BIAS_RAMP;
+    else if (length - t < CHIME_BIAS_RAMP)
+        bias = CHIME_SILENCE * (length - t) / CHIME_BIAS_RAMP;
+    if (pass == 0 || t >= pass * c.repeats)
+        return bias;
+
+    // the note that sounds at t and how far into it t is
+    uint32_t tn = t % pass;
+    uint8_t i = 0;
+    while (tn >= noteSamples(c.notes[i]))
+        tn -= noteSamples(c.notes[i++]);
+    const chime_note_t & n = c.notes[i];
+    uint32_t len = noteSamples(n);
+    if (n.midi == 0 || n.midi > 127)
+        return bias;
+
+    // 15 bit envelope: a short attack, then a quadratic decay to silence at the note's end
+    uint32_t left = len - tn;
+    int32_t env = tn < CHIME_ATTACK ? tn * 32767 / CHIME_ATTACK : (uint64_t)left * left * 32767 / ((uint64_t)len * len);
+    uint32_t fade_len = (uint32_t)c.fade_ms * (CHIME_SAMPLE_HZ / 1000);
+    int32_t fade = t < fade_len ? (uint64_t)t * 32767 / fade_len : 32767;
+
+    int32_t s = wave(phase_steps.step[n.midi] * tn);
+    s = (s * env) >> 15;
+    s = (s * fade) >> 15;
+    s = (s * c.volume) >> 8;
+    int32_t v = (int32_t)bias + (s >> 8);
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+void chime_render(const chime_t & c, uint32_t first, uint8_t * out, uint32_t count)
+{
+    uint32_t pass = passSamples(c);
+    uint32_t length = pass * c.repeats + CHIME_BIAS_RAMP;
+    for (uint32_t i = 0; i < count; i++)
+        out[i] = level(c, first + i, pass, length);
+}
+
+// Playback. Each channel plays its own buffer and starts the other one when it is done, the
+// interrupt of the finished channel refills its buffer while the other one plays.
+static uint8_t chime_pin;
+static uint chime_slice;
+static int chans[2] = {-1, -1};
+static int dma_timer = -1;
+static const chime_t * tune;
+static uint32_t render_pos;
+static volatile bool playing = false;
+static volatile bool stop_requested = false;
+static uint32_t buffers[2][CHIME_BLOCK];
+
+static void fill(int b)
+{
+    uint8_t levels[CHIME_BLOCK];
+    chime_render(*tune, render_pos, levels, CHIME_BLOCK);
+    render_pos += CHIME_BLOCK;
+    // the compare register holds both channels of the slice, the pin's half is set
+    uint shift = pwm_gpio_to_channel(chime_pin) == PWM_CHAN_B ? 16 : 0;
+    for (int i = 0; i < CHIME_BLOCK; i++)
+        buffers[b][i] = (uint32_t)levels[i] << shift;
+}
+
+static void stopOutput()
+{
+    uint32_t mask = 1u << chans[0] | 1u << chans[1];
+    dma_channel_set_irq1_enabled(chans[0], false);
+    dma_channel_set_irq1_enabled(chans[1], false);
+    dma_hw->abort = mask;
+    while (dma_hw->abort & mask)
+        tight_loop_contents();
+    dma_hw->ints1 = mask;
+    pwm_set_gpio_level(chime_pin, 0);
+    playing = false;
+}
+
+static void chimeIrq()
+{
+    for (int b = 0; b < 2; b++)
+    {
+        if (!playing || !(dma_hw->ints1 & 1u << chans[b]))
+            continue;
+        dma_hw->ints1 = 1u << chans[b];
+
+        // the other buffer plays the block before render_pos, once that is past the end
+        // (or a stop came) there is nothing left to hear
+        if (stop_requested || render_pos - CHIME_BLOCK >= chime_length(*tune))
+        {
+            stopOutput();
+            return;
+        }
+        fill(b);
+        dma_channel_set_read_addr(chans[b], buffers[b], false);
+        dma_channel_set_trans_count(chans[b], CHIME_BLOCK, false);
+    }
+}
+
+bool chime_init(uint8_t pin)
+{
+    chans[0] = dma_claim_unused_channel(false);
+    chans[1] = dma_claim_unused_channel(false);
+    dma_timer = dma_claim_unused_timer(false);
+    if (chans[0] < 0 || chans[1] < 0 || dma_timer < 0)
+    {
+        // give back what was claimed, the chime stays silent
+        for (int & c : chans)
+        {
+            if (c >= 0)
+                dma_channel_unclaim(c);
+            c = -1;
+        }
+        if (dma_timer >= 0)
+            dma_timer_unclaim(dma_timer);
+        dma_timer = -1;
+        return false;
+    }
+
+    chime_pin = pin;
+    chime_slice = pwm_gpio_to_slice_num(pin);
+    gpio_set_function(pin, GPIO_FUNC_PWM);
+    pwm_config pc = pwm_get_default_config();
+    pwm_config_set_wrap(&pc, 255);
+    pwm_init(chime_slice, &pc, true);
+    pwm_set_gpio_level(pin, 0);
+
+    chime_clock_changed();
+    for (int b = 0; b < 2; b++)
+    {
+        dma_channel_config c = dma_channel_get_default_config(chans[b]);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_dreq(&c, dma_get_timer_dreq(dma_timer));
+        channel_config_set_chain_to(&c, chans[1 - b]);
+        dma_channel_configure(chans[b], &c, &pwm_hw->slice[chime_slice].cc, buffers[b], CHIME_BLOCK, false);
+    }
+    irq_add_shared_handler(DMA_IRQ_1, chimeIrq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+    return true;
+}
+
+void chime_clock_changed()
+{
+    // one sample per timer tick
+    if (dma_timer >= 0)
+        dma_timer_set_fraction(dma_timer, 1, clock_get_hz(clk_sys) / CHIME_SAMPLE_HZ);
+}
+
+void chime_play(const chime_t & c)
+{
+    if (dma_timer < 0 || playing)
+        return;
+
+    tune = &c;
+    render_pos = 0;
+    stop_requested = false;
+    fill(0);
+    fill(1);
+    dma_channel_set_read_addr(chans[1], buffers[1], false);
+    dma_channel_set_trans_count(chans[1], CHIME_BLOCK, false);
+    dma_hw->ints1 = 1u << chans[0] | 1u << chans[1];
+    dma_channel_set_irq1_enabled(chans[0], true);
+    dma_channel_set_irq1_enabled(chans[1], true);
+    playing = true;
+    dma_channel_transfer_from_buffer_now(chans[0], buffers[0], CHIME_BLOCK);
+}
+
+void chime_stop()
+{
+    if (playing)
+        stop_requested = true;
+}
+
+bool chime_playing()
+{
+    return playing;
+}
@@ -0,0 +1,51 @@
+/**
+ * chime.h
+ *
+ * Soft wakeup chime on a PWM pin, for a small speaker or piezo behind an RC low pass. The tune
+ * is a short list of notes in flash, synthesised a block at a time into 8 bit PWM levels and
+ * played by two chained DMA channels paced by a DMA timer, so the CPU only sees an interrupt
+ * per block. The volume rises from silence over the first seconds.
+ *
+ * chime_render() is a plain function of the tune and the sample index, with no state and no
+ * SDK calls, so the same PCM can be produced on a host.
+ */
+
+#ifndef CHIME_H
+#define CHIME_H
+
+#include <stdint.h>
+
+#define CHIME_SAMPLE_HZ     16000
+#define CHIME_SILENCE       128     // PWM level of the resting speaker cone
+
+struct chime_note_t {
+    uint8_t midi;       // note number, 69 = A4 = 440 Hz, 0 = rest
+    uint8_t eighths;    // length in eighths of a second
+};
+
+struct chime_t {
+    const chime_note_t * notes;
+    uint8_t count;
+    uint8_t repeats;    // the notes are played this often
+    uint8_t volume;     // 0-255, reached at the end of the fade in
+    uint16_t fade_ms;   // fade in from silence
+};
+
+// the tune played at wakeup
+extern const chime_t chime_wakeup;
+
+// length in samples, all repeats
+uint32_t chime_length(const chime_t & c);
+// PWM levels for samples first..first+count-1, silence past the end
+void chime_render(const chime_t & c, uint32_t first, uint8_t * out, uint32_t count);
+
+// claim the PWM slice of pin, the DMA channels and the DMA timer, false when they are taken
+bool chime_init(uint8_t pin);
+// the sample rate is divided down from clk_sys, this sets it again after a change
+void chime_clock_changed();
+void chime_play(const chime_t & c);
+// silence within a block, the rest of the tune is skipped
+void chime_stop();
+bool chime_playing();
+
+#endif // CHIME_H
@@ -0,0 +1,167 @@
+/**
+ * config_protocol.cpp
+ *
+ * Parser for the configuration commands.
+ */
+
+#include "config_protocol.h"
+
+#include <string.h>
+
+struct CommandInfo {
+    const char * name;
+    ConfigParser::Command command;
+    uint8_t set_args;   // number of values the set form takes, 0 = read only
+    bool hex;
+};
+
+static const CommandInfo commands[] = {
+    {"dt",       ConfigParser::DATE_TIME, 7, false},
+    {"alarm",    ConfigParser::ALARM,     2, false},
+    {"sched",    ConfigParser::SCHEDULE,  ConfigParser::MAX_ARGS, true},
+    {"stats",    ConfigParser::STATS,     0, false},
+    {"selftest", ConfigParser::SELFTEST,  0, false},
+    {"log",      ConfigParser::LOG,       0, false},
+    {"theme",    ConfigParser::THEME,     1, false},
+    {"pack",     ConfigParser::PACK,      ConfigParser::MAX_ARGS, true},
+    {"tz",       ConfigParser::TIME_ZONE, 0, false},
+    {"power",    ConfigParser::POWER,     1, false},
+};
+
+void ConfigParser::reset()
+{
+    _state = NAME;
+    _name_len = 0;
+    _cmd = 0;
+    memset(&_result, 0, sizeof(_result));
+}
+
+void ConfigParser::fail(Error e)
+{
+    _result.error = e;
+    _state = SKIP;
+}
+
+const char * ConfigParser::errorText(Error e)
+{
+    switch (e)
+    {
+        case OK: return "ok";
+        case UNKNOWN_COMMAND: return "unknown command";
+        case BAD_NUMBER: return "bad number";
+        case ARG_COUNT: return "wrong number of values";
+    }
+    return "?";
+}
+
+void ConfigParser::lookup()
+{
+    _name[_name_len] = '\0';
+    for (uint8_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++)
+    {
+        if (strcmp(_name, commands[i].name) == 0)
+        {
+            _cmd = i;
+            _result.command = commands[i].command;
+            return;
+        }
+    }
+    fail(UNKNOWN_COMMAND);
+}
+
+bool ConfigParser::finish()
+{
+    // an empty command, e.g. a blank line or ";;", is no command at all
+    if (_state == NAME && _name_len == 0)
+        return false;
+
+    if (_state == NAME)
+        lookup();
+    if (_result.error == OK && _result.argc != 0 && _result.argc != commands[_cmd].set_args)
+        _result.error = ARG_COUNT;
+    return true;
+}
+
+bool ConfigParser::feed(char c)
+{
+    bool end = c == '\n' || c == '\r' || c == ';';
+    bool space = c == ' ' || c == '\t';
+
+    // the result of the previous command stays readable until the next one starts
+    if (_state == NAME && _name_len == 0 && !end && !space)
+    {
+        Result empty = {};
+        _result = empty;
+    }
+
+    if (end)
+    {
+        bool done = finish();
+        _state = NAME;
+        _name_len = 0;
+        return done;
+    }
+
+    switch (_state)
+    {
+        case NAME:
+            if (space)
+            {
+                if (_name_len == 0)
+                    break;  // leading blanks
+                _state = GAP;
+                lookup();
+            }
+            else if (_name_len < sizeof(_name) - 1 && c >= 'a' && c <= 'z')
+                _name[_name_len++] = c;
+            else
+                fail(UNKNOWN_COMMAND);
+            break;
+
+        case GAP:
+            if (space)
+                break;
+            if (_result.argc == MAX_ARGS)
+            {
+                fail(ARG_COUNT);
+                break;
+            }
+            _result.argv[_result.argc++] = 0;
+            _state = NUMBER;
+            [[fallthrough]];
+
+        case NUMBER:
+        {
+            if (space)
+            {
+                _state = GAP;
+                break;
+            }
+            uint32_t base = commands[_cmd].hex ? 16 : 10;
+            uint32_t digit;
+            if (c >= '0' && c <= '9')
+                digit = c - '0';
+            else if (base == 16 && c >= 'a' && c <= 'f')
+                digit = c - 'a' + 10;
+            else if (base == 16 && c >= 'A' && c <= 'F')
+                digit = c - 'A' + 10;
+            else
+            {
+                fail(BAD_NUMBER);
+                break;
+            }
+            uint32_t & v = _result.argv[_result.argc - 1];
+            if (v > (UINT32_MAX - digit) / base)
+            {
+                fail(BAD_NUMBER);
+                break;
+            }
+            v = v * base + digit;
+            break;
+        }
+
+        case SKIP:
+            break;
+    }
+    return false;
+}
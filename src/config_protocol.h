@@ -0,0 +1,110 @@
+/**
+ * config_protocol.h
+ *
+ * Line based configuration commands on the stdio uart (and USB CDC when stdio is enabled
+ * there). A command is a name followed by space separated numbers and ends with a newline or
+ * a ';', so a whole clock can be set up with a single line:
+ *
+ *   dt 26 10 18 0 7 30 0; alarm 0700 1930; sched 00000000 ...
+ *
+ *   dt                               read the local date and time, weekday 0 = Sunday
+ *   dt <yy> <mm> <dd> <wd> <h> <m> <s>  set both, in local time; the weekday is worked out
+ *                                    from the date, wd is only checked to be 0-6
+ *   alarm                            read the default wakeup and goto sleep times
+ *   alarm <hhmm> <hhmm>              set them
+ *   sched                            read the schedule table
+ *   sched <9 x 8 hex digits>         write the whole table, see schedule.h for the format
+ *   stats                            print the performance counters
+ *   selftest                         light every pixel for a moment
+ *   log                              print the event log, oldest first, see event_log.h
+ *   theme                            list the themes and print the one in use
+ *   theme <n>                        switch to theme n, 0 is the built-in artwork
+ *   pack                             check the asset pack, print its size and theme count
+ *   pack <offset> <8 x 8 hex digits> write 32 bytes of a new pack at offset (hex), the words
+ *                                    least significant byte first, see asset_pack.h
+ *   tz                               print the zone name, the UTC offset in minutes and the
+ *                                    last local yymmdd hhmm before the next change, if any
+ *   power                            print the clock profile, sys_clk in kHz and the seconds
+ *                                    spent in each profile, see power.h
+ *   power <n>                        keep profile n (0 interactive, 1 day, 2 night) to measure
+ *                                    it, 3 goes back to choosing by activity
+ *
+ * Every command is answered with one line starting with "ok" or "err". The parser is a plain
+ * state machine over single characters with no allocation and no dependencies on the SDK,
+ * EddyClock carries out the commands.
+ *
+ * The uart also carries the binary trace (trace.h) in 18 byte frames: TRACE_FRAME_START (0x1E),
+ * a trace_record_t as it is in memory, and the xor of its 16 bytes. A frame goes out whole,
+ * between printed lines, and not while a command is partly received (unless it was left
+ * unfinished for 5 s). Replies are plain text without 0x1E, so a program reading them drops
+ * 0x1E and the 17 bytes after it.
+ */
+
+#ifndef CONFIG_PROTOCOL_H
+#define CONFIG_PROTOCOL_H
+
+#include <stdint.h>
+
+class ConfigParser {
+public:
+    enum Command : uint8_t {
+        NONE,
+        DATE_TIME,
+        ALARM,
+        SCHEDULE,
+        STATS,
+        SELFTEST,
+        LOG,
+        THEME,
+        PACK,
+        TIME_ZONE,
+        POWER
+    };
+
+    enum Error : uint8_t {
+        OK,
+        UNKNOWN_COMMAND,
+        BAD_NUMBER,
+        ARG_COUNT
+    };
+
+    static constexpr int MAX_ARGS = 9;
+
+    struct Result {
+        Command command;
+        Error error;
+        uint8_t argc;       // 0 = read, otherwise the values to set
+        uint32_t argv[MAX_ARGS];
+    };
+
+    ConfigParser() { reset(); }
+
+    // true when c ended a command, result() holds it until the next call
+    bool feed(char c);
+    const Result & result() const { return _result; }
+    // nothing of a command received yet, blanks aside
+    bool idle() const { return _state == NAME && _name_len == 0; }
+    void reset();
+
+    static const char * errorText(Error e);
+
+private:
+    enum State : uint8_t {
+        NAME,
+        GAP,
+        NUMBER,
+        SKIP        // after an error, until the end of the command
+    };
+
+    void lookup();
+    bool finish();
+    void fail(Error e);
+
+    State _state;
+    char _name[9];
+    uint8_t _name_len;
+    uint8_t _cmd;       // index into the command table
+    Result _result;
+};
+
+#endif // CONFIG_PROTOCOL_H
@@ -0,0 +1,261 @@
+/**
+ * event_log.cpp
+ *
+ * Event log in a pair of flash sectors.
+ */
+
+#include "event_log.h"
+
+#include <string.h>
+#include "flash_data.h"
+#include "pico/time.h"
+
+#define EVENT_LOG_SECTORS        FLASH_EVENT_LOG_SECTORS
+// bumped whenever the record format changes, sectors in an older format are then ignored
+#define EVENT_LOG_MAGIC          0x45564C01
+#define EVENT_LOG_BUFFER         32
+// a page takes 32 events, it is written once a few are waiting or the oldest is this old
+#define EVENT_LOG_FLUSH_EVENTS   8
+#define EVENT_LOG_FLUSH_MINUTES  10
+// slot 0 of a sector is its header, the events follow
+#define SLOTS_PER_SECTOR         (FLASH_SECTOR_SIZE / sizeof(event_t))
+#define SLOTS_PER_PAGE           (FLASH_PAGE_SIZE / sizeof(event_t))
+
+struct sector_header_t {
+    uint32_t magic;
+    uint32_t seq;
+};
+static_assert(sizeof(event_t) == 8, "events are 8 bytes in the flash");
+static_assert(sizeof(sector_header_t) == sizeof(event_t), "the header takes the first slot");
+
+static uint8_t current;         // sector being filled
+static bool current_valid;
+static uint32_t current_seq;
+static uint32_t next_slot;      // in the current sector, SLOTS_PER_SECTOR = full
+static bool older_valid;
+static event_t buffer[EVENT_LOG_BUFFER];
+static uint32_t buffered;
+static absolute_time_t flush_by;
+static uint32_t lost;
+
+static uint8_t older()
+{
+    return (current + 1) % EVENT_LOG_SECTORS;
+}
+
+static uint32_t sector_offset(uint8_t s)
+{
+    return FLASH_EVENT_LOG_OFFSET + s * FLASH_SECTOR_SIZE;
+}
+
+static const event_t * slots(uint8_t s)
+{
+    return (const event_t *)flash_data_xip(sector_offset(s));
+}
+
+static const sector_header_t * header(uint8_t s)
+{
+    return (const sector_header_t *)slots(s);
+}
+
+static bool erased(const event_t & e)
+{
+    return e.when == 0xFFFFFFFF && e.type == EVENT_NONE && e.arg == 0xFF && e.value == 0xFFFF;
+}
+
+// FAT style, an event can't be all ones since the month is at most 12
+uint32_t event_time(const rv3028::rv3028_date_t & date, const rv3028::rv3028_time_t & time)
+{
+    return (uint32_t)(date.year & 0x7F) << 25 | (uint32_t)(date.month & 0x0F) << 21 |
+           (uint32_t)(date.date & 0x1F) << 16 | (uint32_t)(time.hours & 0x1F) << 11 |
+           (uint32_t)(time.minutes & 0x3F) << 5 | (time.seconds / 2 & 0x1F);
+}
+
+void event_time_unpack(uint32_t when, rv3028::rv3028_date_t & date, rv3028::rv3028_time_t & time)
+{
+    date.weekday = 0;
+    date.year = when >> 25 & 0x7F;
+    date.month = when >> 21 & 0x0F;
+    date.date = when >> 16 & 0x1F;
+    time.hours = when >> 11 & 0x1F;
+    time.minutes = when >> 5 & 0x3F;
+    time.seconds = (when & 0x1F) * 2;
+}
+
+const char * event_name(uint8_t type)
+{
+    switch (type)
+    {
+        case EVENT_RESET: return "reset";
+        case EVENT_POWER_LOST: return "power-lost";
+        case EVENT_MODE: return "mode";
+        case EVENT_BUTTON: return "button";
+        case EVENT_TIME_SET: return "time-set";
+        case EVENT_ALARM_SET: return "alarm-set";
+        default: return "?";
+    }
+}
+
+void event_log_init()
+{
+    // of the sectors with a header, the one with the higher sequence number is being filled
+    current_valid = false;
+    for (uint8_t s = 0; s < EVENT_LOG_SECTORS; s++)
+    {
+        const sector_header_t * h = header(s);
+        if (h->magic == EVENT_LOG_MAGIC && (!current_valid || (int32_t)(h->seq - current_seq) > 0))
+        {
+            current = s;
+            current_seq = h->seq;
+            current_valid = true;
+        }
+    }
+
+    if (!current_valid)
+    {
+        // nothing logged yet, the first flush starts on sector 0
+        current = EVENT_LOG_SECTORS - 1;
+        current_seq = 0;
+        next_slot = SLOTS_PER_SECTOR;
+        older_valid = false;
+        return;
+    }
+
+    older_valid = header(older())->magic == EVENT_LOG_MAGIC && header(older())->seq == current_seq - 1;
+
+    // after the last slot that was written, a write cut short by a reset still counts as one
+    next_slot = SLOTS_PER_SECTOR;
+    while (next_slot > 1 && erased(slots(current)[next_slot - 1]))
+        next_slot--;
+}
+
+void event_log_add(event_type_t type, uint8_t arg, uint16_t value, uint32_t when)
+{
+    if (buffered == EVENT_LOG_BUFFER)
+    {
+        lost++;
+        return;
+    }
+    if (buffered == 0)
+        flush_by = make_timeout_time_ms(EVENT_LOG_FLUSH_MINUTES * 60 * 1000);
+    buffer[buffered++] = {when, type, arg, value};
+}
+
+bool event_log_flush_due()
+{
+    return buffered >= EVENT_LOG_FLUSH_EVENTS || (buffered > 0 && time_reached(flush_by));
+}
+
+void event_log_flush()
+{
+    if (buffered == 0)
+        return;
+
+    // a single flash operation per call, an erase leaves the page write to the next one
+    if (next_slot >= SLOTS_PER_SECTOR)
+    {
+        if (!flash_data_erase(sector_offset(older())))
+            return;
+        older_valid = current_valid;
+        current = older();
+        current_valid = true;
+        current_seq++;
+        next_slot = 1;
+        return;
+    }
+
+    // the page as it is with the new events added, the slots already written are programmed
+    // with what they hold, which leaves them as they are
+    uint32_t first = next_slot / SLOTS_PER_PAGE * SLOTS_PER_PAGE;
+    event_t page[SLOTS_PER_PAGE];
+    memcpy(page, &slots(current)[first], sizeof(page));
+    if (first == 0)
+    {
+        sector_header_t h = {EVENT_LOG_MAGIC, current_seq};
+        memcpy(&page[0], &h, sizeof(h));
+    }
+    uint32_t n = 0;
+    while (n < buffered && next_slot + n < first + SLOTS_PER_PAGE)
+    {
+        page[next_slot + n - first] = buffer[n];
+        n++;
+    }
+
+    if (!flash_data_program(sector_offset(current) + first * sizeof(event_t), (const uint8_t *)page))
+        return;
+    next_slot += n;
+    buffered -= n;
+    memmove(buffer, buffer + n, buffered * sizeof(event_t));
+}
+
+uint32_t event_log_count()
+{
+    uint32_t in_older = older_valid ? SLOTS_PER_SECTOR - 1 : 0;
+    uint32_t in_current = current_valid ? next_slot - 1 : 0;
+    return in_older + in_current + buffered;
+}
+
+bool event_log_get(uint32_t i, event_t & e)
+{
+    uint32_t in_older = older_valid ? SLOTS_PER_SECTOR - 1 : 0;
+    uint32_t in_current = current_valid ? next_slot - 1 : 0;
+
+    if (i < in_older)
+        e = slots(older())[1 + i];
+    else if (i - in_older < in_current)
+        e = slots(current)[1 + i - in_older];
+    else if (i - in_older - in_current < buffered)
+        e = buffer[i - in_older - in_current];
+    else
+        return false;
+    return true;
+}
+
+uint32_t event_log_lost()
+{
+    return lost;
+}
+
+static uint16_t hhmm(uint32_t when)
+{
+    return (when >> 11 & 0x1F) * 100 + (when >> 5 & 0x3F);
+}
+
+void event_log_last_night(event_night_t & night)
+{
+    const uint16_t none = event_night_t::NO_TIME;
+    night = {false, none, none, 0, none, 0};
+
+    // a reset in the night logs goto sleep mode once more, that doesn't start another night
+    event_night_t n = night;
+    bool in_night = false;
+    event_t e;
+    for (uint32_t i = 0; event_log_get(i, e); i++)
+    {
+        if (!in_night)
+        {
+            if (e.type == EVENT_MODE && e.arg == 0)
+            {
+                n = {true, hhmm(e.when), none, 0, none, 0};
+                in_night = true;
+            }
+        }
+        else if (e.type == EVENT_MODE && e.arg == 1)
+        {
+            n.wakeup = hhmm(e.when);
+            night = n;
+            in_night = false;
+        }
+        else if (e.type == EVENT_BUTTON)
+        {
+            if (n.presses++ == 0)
+                n.first_press = hhmm(e.when);
+        }
+        else if (e.type == EVENT_RESET)
+        {
+            n.resets++;
+        }
+    }
+    if (in_night)
+        night = n;
+}
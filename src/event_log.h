@@ -0,0 +1,74 @@
+/**
+ * event_log.h
+ *
+ * Append only log of what happened around the night, kept in the last two 4 kB sectors of the
+ * RP2350 flash so it survives power cycles: resets and power losses, mode changes, buttons
+ * pressed in goto sleep mode and changes to the time or the alarm times.
+ *
+ * Events are collected in RAM and written a page at a time when the main loop has nothing else
+ * to do. Each sector starts with a header holding a sequence number, the newer sector is the one
+ * being filled and the older one keeps the events before it. A sector is only erased when the
+ * other one is full, every 511 events, so a night's worth of events costs no erase at all and a
+ * sector sees an erase every few months.
+ *
+ * The sectors are part of the flash data area, see flash_data.h.
+ */
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <stdint.h>
+#include "rv3028.h"
+
+enum event_type_t : uint8_t {
+    EVENT_RESET,        // arg: 0 power on, 1 watchdog, 2 other warm reset
+    EVENT_POWER_LOST,   // when the RTC switched to its battery, value: switchovers counted
+    EVENT_MODE,         // arg: 1 wakeup, 0 goto sleep
+    EVENT_BUTTON,       // pressed in goto sleep mode, arg: 0 hours, 1 minutes, 2 wakeup, 3 goto sleep
+    EVENT_TIME_SET,     // arg: 0 buttons, 1 serial, value: minutes since midnight
+    EVENT_ALARM_SET,    // arg: 0 wakeup, 1 goto sleep, value: minutes since midnight
+    EVENT_NONE = 0xFF   // erased flash
+};
+
+struct event_t {
+    uint32_t when;      // see event_time()
+    uint8_t type;
+    uint8_t arg;
+    uint16_t value;
+};
+
+// local date and time packed into 32 bits: year:7 month:4 date:5 hours:5 minutes:6 seconds/2:5
+uint32_t event_time(const rv3028::rv3028_date_t & date, const rv3028::rv3028_time_t & time);
+void event_time_unpack(uint32_t when, rv3028::rv3028_date_t & date, rv3028::rv3028_time_t & time);
+const char * event_name(uint8_t type);
+
+// find the write position, before anything else is logged
+void event_log_init();
+void event_log_add(event_type_t type, uint8_t arg, uint16_t value, uint32_t when);
+
+// Whether buffered events should go to the flash: enough of them for a page write, or the
+// oldest has waited long enough. A flush blocks for about a millisecond, and some 50 ms when
+// it has to erase the older sector.
+bool event_log_flush_due();
+void event_log_flush();
+
+// events written and buffered, oldest first, the oldest go when a sector is erased
+uint32_t event_log_count();
+bool event_log_get(uint32_t i, event_t & e);
+// events that didn't fit the RAM buffer since boot
+uint32_t event_log_lost();
+
+// The last night, from its last switch to goto sleep mode to the next switch to wakeup mode,
+// or until now when it is still going. Times are hhmm, NO_TIME when they didn't happen.
+struct event_night_t {
+    static constexpr uint16_t NO_TIME = 0xFFFF;
+    bool found;
+    uint16_t bedtime;
+    uint16_t first_press;   // first button pressed in the night, i.e. out of bed
+    uint16_t presses;
+    uint16_t wakeup;
+    uint16_t resets;        // a power loss is one as well
+};
+void event_log_last_night(event_night_t & night);
+
+#endif // EVENT_LOG_H
@@ -0,0 +1,42 @@
+/**
+ * flash_data.cpp
+ *
+ * Flash operations on the data area.
+ */
+
+#include "flash_data.h"
+
+#include "pico/flash.h"
+
+// how long a flash operation may wait for the other core to get out of the way
+#define FLASH_DATA_LOCKOUT_MS    10
+
+struct flash_op_t {
+    uint32_t offset;
+    const uint8_t * page;   // nullptr = erase the sector
+};
+
+static void flash_op(void * param)
+{
+    const flash_op_t * op = (const flash_op_t *)param;
+    if (op->page)
+        flash_range_program(op->offset, op->page, FLASH_PAGE_SIZE);
+    else
+        flash_range_erase(op->offset, FLASH_SECTOR_SIZE);
+}
+
+static bool run_flash_op(uint32_t offset, const uint8_t * page)
+{
+    flash_op_t op = {offset, page};
+    return flash_safe_execute(flash_op, &op, FLASH_DATA_LOCKOUT_MS) == PICO_OK;
+}
+
+bool flash_data_erase(uint32_t offset)
+{
+    return run_flash_op(offset, nullptr);
+}
+
+bool flash_data_program(uint32_t offset, const uint8_t * page)
+{
+    return run_flash_op(offset, page);
+}
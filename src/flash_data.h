@@ -0,0 +1,42 @@
+/**
+ * flash_data.h
+ *
+ * The end of the RP2350 flash holds data written at run time, below it the firmware image:
+ *
+ *   FLASH_ASSET_PACK_OFFSET   asset pack with the themes, 64 kB (asset_pack.h)
+ *   FLASH_EVENT_LOG_OFFSET    event log, the last two sectors (event_log.h)
+ *
+ * The image must stay below FLASH_DATA_OFFSET: the link fails when it doesn't, see
+ * flash_data.ld. The size of the area is repeated in CMakeLists.txt for the linker.
+ */
+
+#ifndef FLASH_DATA_H
+#define FLASH_DATA_H
+
+#include <stdint.h>
+#include "hardware/flash.h"
+#include "asset_pack_format.h"
+
+#define FLASH_EVENT_LOG_SECTORS  2
+#define FLASH_EVENT_LOG_OFFSET   (PICO_FLASH_SIZE_BYTES - FLASH_EVENT_LOG_SECTORS * FLASH_SECTOR_SIZE)
+#define FLASH_ASSET_PACK_SIZE    ASSET_PACK_MAX_SIZE
+#define FLASH_ASSET_PACK_OFFSET  (FLASH_EVENT_LOG_OFFSET - FLASH_ASSET_PACK_SIZE)
+#define FLASH_DATA_OFFSET        FLASH_ASSET_PACK_OFFSET
+
+#ifdef FLASH_DATA_RESERVED
+static_assert(PICO_FLASH_SIZE_BYTES - FLASH_DATA_OFFSET == FLASH_DATA_RESERVED,
+              "the flash data area changed, update FLASH_DATA_RESERVED in CMakeLists.txt");
+#endif
+
+// where a flash offset reads through XIP
+static inline const uint8_t * flash_data_xip(uint32_t offset)
+{
+    return (const uint8_t *)(XIP_BASE + offset);
+}
+
+// One erase of a sector or program of a page. The code runs from the same flash, so interrupts
+// and the other core are held off meanwhile; false when that couldn't be done in time.
+bool flash_data_erase(uint32_t offset);
+bool flash_data_program(uint32_t offset, const uint8_t * page);
+
+#endif // FLASH_DATA_H
@@ -0,0 +1,148 @@
+/**
+ * i2c_bus.cpp
+ *
+ * Blocking and DMA fed transfers on the i2c buses.
+ */
+
+#include "i2c_bus.h"
+
+#include "hardware/dma.h"
+#include "pico/stdlib.h"
+
+// the DMA writes whole data_cmd words, the data byte plus the stop flag on the last one
+#define I2C_DMA_MAX_LEN 1100
+
+static int dma_chan = -1;
+static i2c_inst_t * dma_i2c = nullptr;
+static i2c_bus_stats_t * dma_stats = nullptr;
+static uint16_t dma_words[I2C_DMA_MAX_LEN];
+static uint32_t tx_bytes = 0;
+static i2c_bus_stats_t stats[I2C_BUS_MAX_TARGETS];
+
+// a DMA write only holds up its own bus
+static void waitFor(i2c_inst_t * i2c)
+{
+    while (dma_i2c == i2c && i2c_bus_busy())
+        tight_loop_contents();
+}
+
+static i2c_bus_stats_t * statsFor(uint8_t addr)
+{
+    for (i2c_bus_stats_t & s : stats)
+    {
+        if (s.addr == addr)
+            return &s;
+        if (s.addr == 0)
+        {
+            s.addr = addr;
+            return &s;
+        }
+    }
+    // more targets than slots, the last one collects the rest
+    return &stats[I2C_BUS_MAX_TARGETS - 1];
+}
+
+int i2c_bus_write(i2c_inst_t * i2c, uint8_t addr, const uint8_t * src, size_t len, bool nostop)
+{
+    i2c_bus_stats_t * s = statsFor(addr);
+    uint64_t start = time_us_64();
+    waitFor(i2c);
+    tx_bytes += len + 1;
+    int ret = i2c_write_blocking(i2c, addr, src, len, nostop);
+
+    s->transactions++;
+    s->tx_bytes += len + 1;
+    s->errors += ret != (int)len;
+    s->blocked_us += time_us_64() - start;
+    return ret;
+}
+
+int i2c_bus_read(i2c_inst_t * i2c, uint8_t addr, uint8_t * dst, size_t len, bool nostop)
+{
+    i2c_bus_stats_t * s = statsFor(addr);
+    uint64_t start = time_us_64();
+    waitFor(i2c);
+    int ret = i2c_read_blocking(i2c, addr, dst, len, nostop);
+
+    s->transactions++;
+    s->tx_bytes += 1;
+    s->rx_bytes += ret > 0 ? ret : 0;
+    s->errors += ret != (int)len;
+    s->blocked_us += time_us_64() - start;
+    return ret;
+}
+
+bool i2c_bus_write_dma(i2c_inst_t * i2c, uint8_t addr, const uint8_t * src, size_t len)
+{
+    if (len == 0 || len > I2C_DMA_MAX_LEN)
+        return false;
+
+    i2c_bus_wait();
+    if (dma_chan < 0)
+    {
+        dma_chan = dma_claim_unused_channel(false);
+        if (dma_chan < 0)
+            return false;
+    }
+
+    for (size_t i = 0; i < len; i++)
+        dma_words[i] = src[i];
+    dma_words[len - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    // same as the SDK does at the start of a blocking write
+    i2c_hw_t * hw = i2c_get_hw(i2c);
+    hw->enable = 0;
+    hw->tar = addr;
+    hw->enable = 1;
+    (void)hw->clr_stop_det;
+    (void)hw->clr_tx_abrt;
+
+    dma_channel_config c = dma_channel_get_default_config(dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_dreq(&c, i2c_get_dreq(i2c, true));
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    dma_channel_configure(dma_chan, &c, &hw->data_cmd, dma_words, len, true);
+    dma_i2c = i2c;
+    dma_stats = statsFor(addr);
+    dma_stats->transactions++;
+    dma_stats->tx_bytes += len + 1;
+    tx_bytes += len + 1;
+    return true;
+}
+
+bool i2c_bus_busy()
+{
+    if (dma_i2c == nullptr)
+        return false;
+
+    if (dma_channel_is_busy(dma_chan))
+        return true;
+
+    // the last byte has left the FIFO once the stop condition went out (or the target didn't ack)
+    i2c_hw_t * hw = i2c_get_hw(dma_i2c);
+    if (!(hw->raw_intr_stat & (I2C_IC_RAW_INTR_STAT_STOP_DET_BITS | I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS)))
+        return true;
+
+    dma_stats->errors += (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) != 0;
+    (void)hw->clr_stop_det;
+    (void)hw->clr_tx_abrt;
+    dma_i2c = nullptr;
+    return false;
+}
+
+uint32_t i2c_bus_tx_bytes()
+{
+    return tx_bytes;
+}
+
+const i2c_bus_stats_t * i2c_bus_stats()
+{
+    return stats;
+}
+
+void i2c_bus_wait()
+{
+    while (i2c_bus_busy())
+        tight_loop_contents();
+}
@@ -0,0 +1,45 @@
+/**
+ * i2c_bus.h
+ *
+ * Every i2c transfer goes through here, on whichever instance the caller passes. Besides the
+ * usual blocking transfers there is a DMA fed write that returns straight away, the blocking
+ * calls on the same instance wait for it to finish before they touch the bus. One DMA write is
+ * in flight at a time, i2c_bus_busy() and i2c_bus_wait() are about that one.
+ */
+
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hardware/i2c.h"
+
+int i2c_bus_write(i2c_inst_t * i2c, uint8_t addr, const uint8_t * src, size_t len, bool nostop);
+int i2c_bus_read(i2c_inst_t * i2c, uint8_t addr, uint8_t * dst, size_t len, bool nostop);
+
+// Start a write of len bytes in the background. src is copied, so the caller may reuse it
+// straight away. Returns false when no DMA channel could be claimed or len is too long.
+bool i2c_bus_write_dma(i2c_inst_t * i2c, uint8_t addr, const uint8_t * src, size_t len);
+bool i2c_bus_busy();
+void i2c_bus_wait();
+
+// bytes written since boot, address bytes included, to measure what a feature costs on the bus
+uint32_t i2c_bus_tx_bytes();
+
+// Counters per target address since boot. Errors are transfers that were not acknowledged in
+// full. blocked_us is the time the blocking calls kept the caller waiting, for a DMA write
+// still in flight and for their own transfer.
+struct i2c_bus_stats_t {
+    uint8_t addr;           // 0 = unused slot
+    uint32_t transactions;
+    uint32_t tx_bytes;      // address bytes included
+    uint32_t rx_bytes;
+    uint32_t errors;
+    uint64_t blocked_us;
+};
+
+#define I2C_BUS_MAX_TARGETS 4
+
+const i2c_bus_stats_t * i2c_bus_stats();
+
+#endif // I2C_BUS_H
@@ -0,0 +1,107 @@
+/**
+ * layout.h
+ *
+ * Named screen regions, in frame buffer (logical) columns and 8 pixel pages. Every panel
+ * profile describes its screen as a ScreenLayout and the driver checks it at compile time:
+ * regions must lie on the panel, must not overlap, and must stay clear of the columns the
+ * pixel shift wraps around the right edge.
+ */
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <stdint.h>
+
+struct Region {
+    uint8_t col;
+    uint8_t page;
+    uint8_t width;      // 0 = the panel has no such region
+    uint8_t pages;
+
+    constexpr bool empty() const { return width == 0 || pages == 0; }
+    constexpr uint8_t colEnd() const { return col + width - 1; }
+    constexpr uint8_t pageEnd() const { return page + pages - 1; }
+    constexpr uint16_t bytes() const { return width * pages; }
+
+    // a region of the same size directly to the right
+    constexpr Region next(uint8_t w) const { return {(uint8_t)(col + width), page, w, pages}; }
+
+    constexpr bool overlaps(const Region & o) const
+    {
+        return !empty() && !o.empty() &&
+               col <= o.colEnd() && o.col <= colEnd() &&
+               page <= o.pageEnd() && o.page <= pageEnd();
+    }
+};
+
+struct ScreenLayout {
+    Region icon;
+    Region hour_tens;
+    Region hour_ones;
+    Region colon;
+    Region minute_tens;
+    Region minute_ones;
+    Region meridiem;
+    Region second_tens;
+    Region second_ones;
+    Region status;      // free line for a seconds bar, a date or similar
+    Region progress;    // one page high bar showing how much of the night has passed
+
+    static constexpr int count = 11;
+    static constexpr const char * names[count] = {
+        "icon", "hour tens", "hour ones", "colon", "minute tens", "minute ones", "am/pm",
+        "second tens", "second ones", "status", "progress"
+    };
+    constexpr const Region & operator[](int i) const
+    {
+        switch (i)
+        {
+            case 0: return icon;
+            case 1: return hour_tens;
+            case 2: return hour_ones;
+            case 3: return colon;
+            case 4: return minute_tens;
+            case 5: return minute_ones;
+            case 6: return meridiem;
+            case 7: return second_tens;
+            case 8: return second_ones;
+            case 9: return status;
+            default: return progress;
+        }
+    }
+};
+
+// width/pages are the panel, margin the number of columns at the right edge that the pixel
+// shift may wrap around to the left
+constexpr bool layoutFits(const ScreenLayout & l, uint8_t width, uint8_t pages, uint8_t margin)
+{
+    for (int i = 0; i < ScreenLayout::count; i++)
+    {
+        const Region & r = l[i];
+        if (r.empty())
+            continue;
+        if (r.col + r.width + margin > width || r.page + r.pages > pages)
+            return false;
+        for (int j = i + 1; j < ScreenLayout::count; j++)
+            if (r.overlaps(l[j]))
+                return false;
+    }
+    return true;
+}
+
+// the time is a row of glyphs: two digits, colon, two digits, the seconds two small digits
+constexpr ScreenLayout timeLayout(Region icon, uint8_t col, uint8_t page, uint8_t digit_width,
+                                  uint8_t digit_pages, uint8_t colon_width, Region meridiem,
+                                  Region second_tens, Region status, Region progress)
+{
+    Region hour_tens = {col, page, digit_width, digit_pages};
+    Region hour_ones = hour_tens.next(digit_width);
+    Region colon = hour_ones.next(colon_width);
+    Region minute_tens = colon.next(digit_width);
+    Region minute_ones = minute_tens.next(digit_width);
+    Region second_ones = second_tens.next(second_tens.width);
+    return {icon, hour_tens, hour_ones, colon, minute_tens, minute_ones, meridiem, second_tens, second_ones,
+            status, progress};
+}
+
+#endif // LAYOUT_H
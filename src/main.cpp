@@ -11,27 +11,62 @@
 #include <sys/unistd.h>
 #include "pico/stdlib.h"
 
-extern "C" {
-#include "ssd1306.h"
-#include "utils.h"
-}
-
 #include "EddyClock.h"
+#include "power.h"
+#include "warm_state.h"
+
+// The RTC and the panel share the default i2c pins (GPIO 4/5) as the clock is wired, at a
+// rate both of them take, above the RTC's 400 kHz rating. With DISPLAY_I2C_SEPARATE the panel
+// is wired to its own pins on the other i2c controller instead, so the RTC stays within its
+// rating and the panel gets the fast mode plus rate.
+#ifndef DISPLAY_I2C_SEPARATE
+#define DISPLAY_I2C_SEPARATE    0
+#endif
+#define SHARED_I2C_HZ           (400 * 2000)
+#define RTC_I2C_HZ              (400 * 1000)
+#define DISPLAY_I2C_INSTANCE    1
+#define DISPLAY_I2C_SDA_PIN     6
+#define DISPLAY_I2C_SCL_PIN     7
+#define DISPLAY_I2C_HZ          (1000 * 1000)
+
+static_assert(!DISPLAY_I2C_SEPARATE || DISPLAY_I2C_INSTANCE != PICO_DEFAULT_I2C,
+              "the panel needs the other i2c controller");
+
+static void initBus(i2c_inst_t * i2c, uint baudrate, uint sda, uint scl)
+{
+    i2c_init(i2c, baudrate);
+    power_track_i2c(i2c, baudrate);
+    gpio_set_function(sda, GPIO_FUNC_I2C);
+    gpio_set_function(scl, GPIO_FUNC_I2C);
+    gpio_pull_up(sda);
+    gpio_pull_up(scl);
+}
 
 int main()
 {
     stdio_init_all();
     printf("Starting eddyclock\n");
 
+    // a valid snapshot means the clock was reset while powered, the panel is already up
+    warm_state_t warm;
+    bool is_warm = warm_state_load(warm);
+
     // initialize i2c
-    i2c_init(i2c_default, 400 * 2000);
-    gpio_set_function(PICO_DEFAULT_I2C_SDA_PIN, GPIO_FUNC_I2C);
-    gpio_set_function(PICO_DEFAULT_I2C_SCL_PIN, GPIO_FUNC_I2C);
-    gpio_pull_up(PICO_DEFAULT_I2C_SDA_PIN);
-    gpio_pull_up(PICO_DEFAULT_I2C_SCL_PIN);
-    sleep_ms(50);
-
-    EddyClock c(i2c_default);
+    i2c_inst_t * display_i2c = i2c_default;
+    if (DISPLAY_I2C_SEPARATE)
+    {
+        display_i2c = I2C_INSTANCE(DISPLAY_I2C_INSTANCE);
+        initBus(i2c_default, RTC_I2C_HZ, PICO_DEFAULT_I2C_SDA_PIN, PICO_DEFAULT_I2C_SCL_PIN);
+        initBus(display_i2c, DISPLAY_I2C_HZ, DISPLAY_I2C_SDA_PIN, DISPLAY_I2C_SCL_PIN);
+    }
+    else
+    {
+        initBus(i2c_default, SHARED_I2C_HZ, PICO_DEFAULT_I2C_SDA_PIN, PICO_DEFAULT_I2C_SCL_PIN);
+    }
+    if (!is_warm)
+        sleep_ms(50);
+
+    EddyClock c(i2c_default, display_i2c, is_warm ? &warm : nullptr);
     c.run();
 
     return 0;
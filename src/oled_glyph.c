@@ -0,0 +1,120 @@
+/**
+ * oled_glyph.c
+ *
+ * Streaming decoder for run length encoded glyphs.
+ */
+
+#include "oled_glyph.h"
+
+#include <string.h>
+
+void oled_glyph_decode(const oled_glyph_t * g, uint8_t * dst, uint16_t stride)
+{
+    const uint8_t * src = g->data;
+    const uint8_t * src_end = g->data + g->size;
+
+    for (uint8_t page = 0; page < g->pages; page++)
+    {
+        uint8_t * out = dst + page * stride;
+        uint8_t * end = out + g->width;
+
+        if (g->encoding == OLED_GLYPH_RAW)
+        {
+            uint16_t n = src_end - src < g->width ? src_end - src : g->width;
+            memcpy(out, src, n);
+            src += n;
+            continue;
+        }
+
+        // a damaged stream stops at the end of its data, runs are cut at the end of the page
+        while (out < end && src < src_end)
+        {
+            uint8_t token = *src++;
+            uint16_t n;
+            if (token & OLED_RLE_RUN_FLAG)
+            {
+                if (src == src_end)
+                    return;
+                n = (token & ~OLED_RLE_RUN_FLAG) + OLED_RLE_MIN_RUN;
+                if (n > end - out)
+                    n = end - out;
+                memset(out, *src++, n);
+            }
+            else
+            {
+                n = token + 1;
+                if (n > src_end - src)
+                    n = src_end - src;
+                if (n > end - out)
+                    n = end - out;
+                memcpy(out, src, n);
+                src += n;
+            }
+            out += n;
+        }
+    }
+}
+
+uint8_t oled_glyph_byte(const oled_glyph_t * g, uint8_t col, uint8_t page)
+{
+    uint16_t index = page * g->width + col;
+    if (g->encoding == OLED_GLYPH_RAW)
+        return index < g->size ? g->data[index] : 0;
+
+    // walk the tokens, runs never cross a page so the output position is just a byte count
+    const uint8_t * src = g->data;
+    const uint8_t * src_end = g->data + g->size;
+    uint16_t pos = 0;
+    while (src < src_end)
+    {
+        uint8_t token = *src++;
+        uint16_t n;
+        if (token & OLED_RLE_RUN_FLAG)
+        {
+            if (src == src_end)
+                break;
+            n = (token & ~OLED_RLE_RUN_FLAG) + OLED_RLE_MIN_RUN;
+            if (index < pos + n)
+                return *src;
+            src++;
+        }
+        else
+        {
+            n = token + 1;
+            if (index < pos + n)
+                return index - pos < src_end - src ? src[index - pos] : 0;
+            src += n;
+        }
+        pos += n;
+    }
+    return 0;
+}
+
+bool oled_glyph_valid(const oled_glyph_t * g)
+{
+    if (g->encoding == OLED_GLYPH_RAW)
+        return g->size == g->width * g->pages;
+    if (g->encoding != OLED_GLYPH_RLE)
+        return false;
+
+    const uint8_t * src = g->data;
+    const uint8_t * src_end = g->data + g->size;
+    for (uint8_t page = 0; page < g->pages; page++)
+    {
+        uint16_t left = g->width;
+        while (left > 0)
+        {
+            if (src == src_end)
+                return false;
+            uint8_t token = *src++;
+            bool run = token & OLED_RLE_RUN_FLAG;
+            uint16_t n = run ? (token & ~OLED_RLE_RUN_FLAG) + OLED_RLE_MIN_RUN : token + 1;
+            uint16_t bytes = run ? 1 : n;
+            if (n > left || bytes > src_end - src)
+                return false;
+            src += bytes;
+            left -= n;
+        }
+    }
+    return src == src_end;
+}
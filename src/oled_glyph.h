@@ -0,0 +1,57 @@
+/**
+ * oled_glyph.h
+ *
+ * Images in SSD1306 page layout, as emitted by tools/asset_compiler into oled_glyphs[].
+ *
+ * Glyphs are either raw page buffers or run length encoded. The RLE stream is page oriented, runs
+ * never cross a page, made of tokens:
+ *   0x00-0x7F  literal, the next (token + 1) bytes are copied
+ *   0x80-0xFF  run, the next byte is repeated (token - 0x80 + 3) times
+ */
+
+#ifndef OLED_GLYPH_H
+#define OLED_GLYPH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define OLED_GLYPH_RAW 0
+#define OLED_GLYPH_RLE 1
+
+#define OLED_RLE_RUN_FLAG 0x80
+#define OLED_RLE_MIN_RUN  3
+
+typedef struct {
+    const uint8_t * data;
+    uint16_t size;          // bytes of data
+    uint8_t width;
+    uint8_t pages;
+    uint8_t encoding;
+} oled_glyph_t;
+
+// Grey image for temporal dithering on the 1 bit panel. Each bit plane is a raw page buffer,
+// least significant first, and over one cycle of the schedule plane p is shown 2^p times, so the
+// time averaged brightness of a pixel follows its grey level.
+typedef struct {
+    const uint8_t * planes;
+    const uint8_t * schedule;   // plane shown in each frame of a cycle
+    uint8_t width;
+    uint8_t pages;
+    uint8_t bits;
+    uint8_t schedule_len;
+} oled_gray_t;
+
+// Expand a glyph straight into a page buffer, dst is the top left byte and stride the distance
+// between pages, so a glyph can be decoded in place into a frame buffer. The decoder never reads
+// past size bytes of data nor writes past width bytes of a page, a damaged glyph leaves bytes
+// undrawn instead.
+void oled_glyph_decode(const oled_glyph_t * g, uint8_t * dst, uint16_t stride);
+
+// Single byte of a glyph, for column at a time drawing, 0 where a damaged glyph has no data
+uint8_t oled_glyph_byte(const oled_glyph_t * g, uint8_t col, uint8_t page);
+
+// Whether the data decodes to exactly width * pages bytes, every page ending with a token, and
+// the last token ending with the data. Glyphs from outside the firmware are checked with this.
+bool oled_glyph_valid(const oled_glyph_t * g);
+
+#endif // OLED_GLYPH_H
@@ -1,103 +0,0 @@
-
-#include <stdint.h>
-
-const uint8_t oled_one[64] = {
-	0x00,0x00,0x00,0x80,0xC0,0xE0,0xF0,0x78,0x3C,0x1C,0xFE,0xFE,0xFE,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x01,0x00,0x00,0x00,0x00,0xFF,0xFF,0xFF,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xFF,0xFF,0xFF,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x3F,0x3F,0x3F,0x00,0x00,0x00
-};
-
-const uint8_t oled_two[64] = {
-	0x00,0x00,0x80,0xC0,0xC0,0xE0,0xE0,0x60,0x60,0x60,0xE0,0xC0,0xC0,0x80,0x00,0x00,0x00,0x00,0x01,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0xC1,0xFF,0x7F,0x1E,0x00,
-	0x00,0x00,0x00,0x80,0xC0,0xE0,0x70,0x38,0x1C,0x0E,0x07,0x03,0x01,0x00,0x00,0x00,0x00,0x06,0x07,0x07,0x07,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x00
-};
-
-const uint8_t oled_three[64] = {
-	0x00,0x80,0x80,0xC0,0xC0,0xE0,0xE0,0x60,0x60,0x60,0xE0,0xE0,0xC0,0x80,0x00,0x00,0x00,0x00,0x01,0x01,0x00,0xC0,0xC0,0xC0,0xC0,0xC0,0xE0,0xF1,0x3F,0x1F,0x0F,0x00,
-	0x00,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x01,0x81,0xC7,0xFF,0xFE,0x00,0x00,0x03,0x03,0x07,0x07,0x06,0x06,0x06,0x06,0x07,0x07,0x03,0x03,0x01,0x00,0x00
-};
-
-const uint8_t oled_four[64] = {
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0xE0,0xE0,0xE0,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0xC0,0xE0,0x78,0x1C,0x0F,0x07,0x01,0xFF,0xFF,0x00,0x00,0x00,
-	0x00,0x3C,0x3E,0x37,0x33,0x30,0x30,0x30,0x30,0x30,0x30,0xFF,0xFF,0x30,0x30,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x07,0x07,0x00,0x00,0x00
-};
-
-const uint8_t oled_five[64] = {
-	0x00,0x00,0x00,0xE0,0xE0,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x00,0x00,0x00,0x00,0x00,0xFF,0xFF,0x60,0x60,0x60,0x60,0xE0,0xE0,0xC0,0xC0,0x80,0x00,0x00,
-	0x00,0x00,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x81,0xC3,0xFF,0xFF,0x00,0x00,0x00,0x03,0x03,0x07,0x07,0x06,0x06,0x06,0x07,0x07,0x03,0x03,0x01,0x00,0x00
-};
-
-const uint8_t oled_six[64] = {
-	0x00,0x00,0x00,0x00,0x80,0xC0,0xC0,0xE0,0x60,0x60,0x60,0x60,0xE0,0x00,0x00,0x00,0x00,0xF8,0xFE,0xFF,0xC3,0xE1,0x60,0x60,0x60,0x60,0xE0,0xE0,0xC0,0x80,0x00,0x00,
-	0x00,0x7F,0xFF,0xE3,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x81,0xFF,0xFF,0x3E,0x00,0x00,0x00,0x00,0x01,0x03,0x07,0x06,0x06,0x06,0x07,0x07,0x03,0x01,0x00,0x00,0x00
-};
-
-const uint8_t oled_seven[64] = {
-	0x00,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0xE0,0xE0,0x60,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0xE0,0xFC,0x3F,0x0F,0x03,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0xC0,0xF8,0xFE,0x1F,0x07,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x04,0x07,0x07,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00
-};
-
-const uint8_t oled_eight[64] = {
-	0x00,0x00,0x00,0x80,0x80,0xC0,0xC0,0xC0,0xC0,0xC0,0xC0,0x80,0x80,0x00,0x00,0x00,0x00,0x00,0x1E,0x3F,0x73,0xE1,0xC0,0xC0,0xC0,0xC0,0x61,0x7B,0x3F,0x1E,0x00,0x00,
-	0x00,0x30,0xFC,0xFE,0x87,0x03,0x01,0x01,0x01,0x01,0x83,0x87,0xFE,0xFC,0x30,0x00,0x00,0x00,0x00,0x01,0x01,0x03,0x03,0x03,0x03,0x03,0x03,0x01,0x01,0x00,0x00,0x00
-};
-
-const uint8_t oled_nine[64] = {
-	0x00,0x80,0xC0,0xE0,0x70,0x70,0x30,0x30,0x30,0x70,0xE0,0xE0,0xC0,0x00,0x00,0x00,0x00,0x7F,0xFF,0xE1,0xC0,0x80,0x80,0x80,0x80,0x80,0xC0,0xE1,0xFF,0xFF,0xF0,0x00,
-	0x00,0x00,0x80,0x01,0x01,0x01,0x01,0x81,0x81,0xC1,0xE1,0xFF,0x3F,0x0F,0x00,0x00,0x00,0x00,0x03,0x03,0x03,0x03,0x03,0x03,0x01,0x01,0x00,0x00,0x00,0x00,0x00,0x00
-};
-
-const uint8_t oled_zero[64] = {
-	0x00,0x00,0x00,0x00,0x80,0xC0,0xC0,0xC0,0xC0,0xC0,0xC0,0x80,0x00,0x00,0x00,0x00,0x00,0xE0,0xFE,0xFF,0x07,0x01,0x00,0x00,0x00,0x00,0x01,0x07,0xFF,0xFC,0xC0,0x00,
-	0x00,0x07,0x3F,0xFF,0xE0,0x80,0x00,0x00,0x00,0x00,0x80,0xE0,0xFF,0x7F,0x07,0x00,0x00,0x00,0x00,0x00,0x01,0x03,0x03,0x03,0x03,0x03,0x03,0x01,0x00,0x00,0x00,0x00
-};
-
-const uint8_t oled_colon[16] = {
-	0x00,0x00,0x00,0x00,0x00,0x06,0x06,0x00,0x00,0x60,0x60,0x00,0x00,0x00,0x00,0x00
-};
-
-const uint8_t oled_sun[512] = {
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x10,0x70,0xC0,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0xC0,0x70,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x06,0x0C,0x08,0x18,0x30,0x60,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0x80,0xC1,0xC0,0xC0,0xE0,0xE0,0xE0,0xE0,0xE0,0xE0,
-	0xE0,0xE0,0xE0,0xE0,0xE0,0xC1,0xC0,0xC0,0x80,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0xC0,0x60,0x38,0x0C,0x07,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0xC0,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xC0,0xE0,0xF8,0xFC,0xFE,0xFE,0xFF,0x7F,0x3F,0x3F,0x3F,0x3F,0x3F,0x7F,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0x7F,0x3F,0x3F,0x3F,0x3F,0x3F,0x7F,0xFE,0xFE,0xFC,0xF8,0xE0,0xC0,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x01,0x01,0x03,0x02,0x00,0x00,0x00,0x00,0xF8,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xC0,0x80,0x00,0x10,0x3C,0x3C,0x1C,0x80,0xC0,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xC0,0x80,0x18,0x3C,0x3C,0x18,0x00,0x80,0xC0,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xF8,0x00,0x00,0x02,0x03,0x01,0x01,0x01,0x01,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x40,0x40,0x40,0x40,0x40,0x00,0x00,0x00,0x00,0x3F,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xBF,0x3F,0x3F,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
-	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x3F,0x3F,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x3F,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x07,0x0F,0x3F,0x7F,0xFF,0xFF,0xFF,0xFF,0xFF,0xFE,0xF8,0xF0,0xE1,0xC3,0x87,0x8F,0x8F,0x8F,
-	0x8F,0x8F,0x8F,0x8F,0xC3,0xE0,0xF8,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x7F,0x3F,0x0F,0x07,0x01,0x00,0x00,0x00,0x01,0x03,0x02,0x06,0x04,0x04,0x04,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0xC0,0x60,0x30,0x18,0x0C,0x06,0x02,0x00,0x00,0x00,0x00,0x00,0x01,0x03,0x03,0xC7,0x07,0x07,0x0F,0x0F,0x0F,0x0F,0x0F,0x0F,
-	0x0F,0x0F,0x0F,0x0F,0x0F,0x07,0x07,0xC7,0x03,0x03,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x0C,0x18,0x10,0x30,0x60,0xC0,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x06,0x03,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x03,0x06,0x0C,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x03,0x02,0x00,0x00,0x00,0x00,0x00,0x00
-};
-
-const uint8_t oled_moon[512] = {
-	0x00,0x00,0x00,0x00,0x10,0x38,0x10,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x20,0x70,0xF8,0x70,0x20,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x60,0x60,0x60,0x60,0x60,0x60,0xE0,0xE0,0xE1,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x04,0x0E,0x04,0x00,0x00,0x00,0x00,0x80,0xE0,0x38,0x0C,0x07,0xFF,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x38,0x3C,0x3E,0x36,0x37,0x33,0x33,0x31,0x30,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xE0,0x3E,0x03,0x00,0x00,0x00,0x00,0x00,0x0F,0x78,0xC0,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x82,0x42,0x22,0x12,0x0A,0x0A,0x06,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xF0,0x1F,0x00,0x00,0x00,0x08,0x38,0x60,0x60,0x38,0x00,0x01,0x07,0x1C,0x30,0xE0,0x80,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x64,0x54,0x4C,0x44,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x07,0x7C,0xC0,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x03,0x06,0x0C,0x18,
-	0x30,0x20,0x60,0x40,0xC0,0x80,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x40,0xE0,0x40,0x00,0x00,0x00,0x00,0x01,0x03,0x0E,0x18,0x30,0x60,0x40,0xC0,0x80,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x3C,
-	0x66,0x42,0x42,0x62,0x36,0x1C,0x01,0x01,0x03,0x02,0x02,0x04,0x04,0x04,0x0C,0x08,0x08,0x08,0x08,0x08,0x88,0x88,0xC8,0x6C,0x34,0x1C,0x0C,0x00,0x00,0x00,0x00,0x00,
-	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x01,0x03,0x02,0x02,0x06,0x04,0x04,0x04,0x04,
-	0x04,0x04,0x0C,0x08,0x08,0x08,0x08,0x08,0x08,0x0C,0x04,0x04,0x04,0x04,0x04,0x06,0x02,0x02,0x03,0x01,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00
-};
-
-const uint8_t oled_pm[16] = {
-	0x00,0x00,0x00,0x00,0x00,0x7E,0x12,0x12,0x0C,0x00,0x7E,0x02,0x0C,0x02,0x7E,0x00
-};
-
-const uint8_t oled_am[16] = {
-	0x00,0x00,0x00,0x00,0x00,0x7C,0x12,0x12,0x7C,0x00,0x7E,0x02,0x0C,0x02,0x7E,0x00
-};
-
@@ -0,0 +1,85 @@
+/**
+ * panel_profile.h
+ *
+ * Compile time description of the OLED panels the clock is built for. The SSD1306 driver is a
+ * template over one of these, so buffer sizes, page loops and the screen layout are constants
+ * of each build variant. The profile is picked with PANEL_PROFILE, see CMakeLists.txt.
+ */
+
+#ifndef PANEL_PROFILE_H
+#define PANEL_PROFILE_H
+
+#include <stdint.h>
+#include "layout.h"
+extern "C" {
+#include "oled_static_data.h"
+}
+
+// 2.42" SSD1309 128x64, the panel the clock was designed around
+struct SSD1309_128x64 {
+    static constexpr uint8_t width = 128;
+    static constexpr uint8_t height = 64;
+    static constexpr uint8_t i2c_addr = 0x3C;
+
+    // init sequence values that depend on the glass
+    static constexpr uint8_t seg_remap = 0x01;    // column 127 is mapped to SEG0
+    static constexpr uint8_t com_scan = 0x08;     // scan from COM[N-1] to COM0
+    static constexpr uint8_t com_pins = 0x12;     // alternative COM pin layout
+    static constexpr uint8_t precharge = 0xF1;
+    static constexpr uint8_t vcomh = 0x30;        // 0.83xVcc
+    static constexpr uint8_t charge_pump = 0x14;
+
+    // 0x2C/0x2D one column content scroll, used for the horizontal pixel shift and the icon slide
+    static constexpr bool content_scroll = true;
+    // rows the pixel shift moves the picture down, the bottom rows of RAM come in at the top
+    // and have to stay dark
+    static constexpr uint8_t shift_rows = 3;
+
+    // full height icon, cropped to its artwork, and the time to the right of it, with the
+    // three columns the pixel shift wraps around kept free
+    static constexpr int icon_sun = OLED_GLYPH_SUN;
+    static constexpr int icon_moon = OLED_GLYPH_MOON;
+    static constexpr ScreenLayout layout = timeLayout(
+            {0, 0, 57, 8},          // icon
+            57, 0, 16, 4, 4,        // time: column, page, digit width, digit pages, colon width
+            {109, 4, 16, 1},        // am/pm, under the minutes
+            {107, 5, 9, 2},         // seconds, under am/pm
+            {57, 5, 48, 2},         // status
+            {57, 7, 68, 1});        // progress
+};
+
+// 0.91" SSD1306 128x32, half size icons with the time next to them on a single row
+struct SSD1306_128x32 {
+    static constexpr uint8_t width = 128;
+    static constexpr uint8_t height = 32;
+    static constexpr uint8_t i2c_addr = 0x3C;
+
+    static constexpr uint8_t seg_remap = 0x01;
+    static constexpr uint8_t com_scan = 0x08;
+    static constexpr uint8_t com_pins = 0x02;     // sequential COM pin layout
+    static constexpr uint8_t precharge = 0xF1;
+    static constexpr uint8_t vcomh = 0x30;
+    static constexpr uint8_t charge_pump = 0x14;
+
+    // not in the SSD1306 command set
+    static constexpr bool content_scroll = false;
+    // the row that comes in at the top is controller RAM below the panel, the bottom row of
+    // the picture is blank
+    static constexpr uint8_t shift_rows = 1;
+
+    static constexpr int icon_sun = OLED_GLYPH_SUN_SMALL;
+    static constexpr int icon_moon = OLED_GLYPH_MOON_SMALL;
+    static constexpr ScreenLayout layout = timeLayout(
+            {0, 0, 32, 4},          // icon
+            34, 0, 16, 4, 4,        // time
+            {106, 3, 16, 1},        // am/pm
+            {106, 0, 9, 2},         // seconds
+            {0, 0, 0, 0},           // no room for a status line
+            {104, 2, 24, 1});       // progress
+};
+
+#ifndef PANEL_PROFILE
+#define PANEL_PROFILE SSD1309_128x64
+#endif
+
+#endif // PANEL_PROFILE_H
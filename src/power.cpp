@@ -0,0 +1,179 @@
+/**
+ * power.cpp
+ *
+ * System clock profiles and gating of unused blocks.
+ */
+
+#include "power.h"
+
+#include "button.h"
+#include "chime.h"
+#include "i2c_bus.h"
+#include "trace.h"
+#include "hardware/clocks.h"
+#include "hardware/pio.h"
+#include "hardware/pll.h"
+#include "hardware/resets.h"
+#include "hardware/uart.h"
+#include "pico/stdlib.h"
+#include "pico/time.h"
+
+// the i2c block needs 8 cycles of clk_sys low and 8 high for each bit
+#define I2C_CYCLES_PER_BIT  16
+#define POWER_MAX_I2C       2
+
+// clk_sys of each profile, fastest first, all of them within reach of the system PLL. The night
+// clock still drives the 1 MHz panel bus of DISPLAY_I2C_SEPARATE.
+static const uint32_t profile_khz[POWER_PROFILES] = {SYS_CLK_KHZ, 48000, 24000};
+
+struct tracked_i2c_t {
+    i2c_inst_t * i2c;
+    uint baudrate;
+};
+static tracked_i2c_t buses[POWER_MAX_I2C];
+static uint8_t bus_count;
+
+static power_profile_t current = POWER_INTERACTIVE;
+static uint64_t since_us;
+static uint64_t spent_us[POWER_PROFILES];
+
+void power_track_i2c(i2c_inst_t * i2c, uint baudrate)
+{
+    for (uint8_t i = 0; i < bus_count; i++)
+    {
+        if (buses[i].i2c == i2c)
+        {
+            buses[i].baudrate = baudrate;
+            return;
+        }
+    }
+    if (bus_count < POWER_MAX_I2C)
+        buses[bus_count++] = {i2c, baudrate};
+}
+
+static bool fits(power_profile_t p)
+{
+    for (uint8_t i = 0; i < bus_count; i++)
+        if ((uint64_t)profile_khz[p] * 1000 < (uint64_t)buses[i].baudrate * I2C_CYCLES_PER_BIT)
+            return false;
+    return true;
+}
+
+static bool inReset(uint32_t bits)
+{
+    return (resets_hw->reset & bits) == bits;
+}
+
+static uint32_t uartResetBits(uint i)
+{
+    return i == 0 ? RESETS_RESET_UART0_BITS : RESETS_RESET_UART1_BITS;
+}
+
+// a uart held in reset can't be asked whether it is enabled
+static bool uartInUse(uint i)
+{
+    return !inReset(uartResetBits(i)) && uart_is_enabled(UART_INSTANCE(i));
+}
+
+static void uartsIdle()
+{
+    for (uint i = 0; i < NUM_UARTS; i++)
+        if (uartInUse(i))
+            uart_tx_wait_blocking(UART_INSTANCE(i));
+}
+
+// clk_peri from the crystal, whatever a clk_sys change did to it. Only the stdio uart is set up
+// here, at the stdio baud rate.
+static void pinPeripheralClock()
+{
+    if (clock_get_hz(clk_peri) == XOSC_HZ)
+        return;
+    clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_XOSC_CLKSRC, XOSC_HZ, XOSC_HZ);
+    if (uartInUse(uart_get_index(uart_default)))
+        uart_set_baudrate(uart_default, PICO_DEFAULT_UART_BAUD_RATE);
+}
+
+void power_init()
+{
+    uartsIdle();
+    pinPeripheralClock();
+
+    // nothing here samples the ADC or talks USB, with both clocks gone the USB PLL can go too
+    clock_stop(clk_adc);
+    clock_stop(clk_hstx);
+#if !LIB_PICO_STDIO_USB
+    clock_stop(clk_usb);
+    pll_deinit(pll_usb);
+#endif
+
+    // PIO blocks without a claimed state machine and uarts nobody set up stay in reset
+    static const uint32_t pio_resets[] = {RESETS_RESET_PIO0_BITS, RESETS_RESET_PIO1_BITS, RESETS_RESET_PIO2_BITS};
+    static_assert(NUM_PIOS <= sizeof(pio_resets) / sizeof(pio_resets[0]), "a reset bit for every PIO");
+    for (uint i = 0; i < NUM_PIOS; i++)
+    {
+        bool claimed = false;
+        for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++)
+            claimed |= pio_sm_is_claimed(PIO_INSTANCE(i), sm);
+        if (!claimed)
+            reset_block_mask(pio_resets[i]);
+    }
+    for (uint i = 0; i < NUM_UARTS; i++)
+        if (!inReset(uartResetBits(i)) && !uart_is_enabled(UART_INSTANCE(i)))
+            reset_block_mask(uartResetBits(i));
+
+    current = POWER_INTERACTIVE;
+    since_us = time_us_64();
+}
+
+bool power_select(power_profile_t p)
+{
+    // a profile too slow for one of the buses gives way to the next faster one
+    while (p > POWER_INTERACTIVE && !fits(p))
+        p = (power_profile_t)(p - 1);
+    if (p == current)
+        return true;
+
+    uint64_t start = time_us_64();
+    i2c_bus_wait();
+    uartsIdle();
+    if (!set_sys_clock_khz(profile_khz[p], false))
+        return false;
+
+    pinPeripheralClock();
+    for (uint8_t i = 0; i < bus_count; i++)
+        i2c_set_baudrate(buses[i].i2c, buses[i].baudrate);
+    button::clockChanged();
+    chime_clock_changed();
+
+    spent_us[current] += start - since_us;
+    since_us = start;
+    current = p;
+    TRACE(TRACE_POWER_PROFILE, p, profile_khz[p], (uint32_t)(time_us_64() - start));
+    return true;
+}
+
+power_profile_t power_profile()
+{
+    return current;
+}
+
+uint32_t power_sys_khz()
+{
+    return clock_get_hz(clk_sys) / 1000;
+}
+
+const char * power_profile_name(power_profile_t p)
+{
+    switch (p)
+    {
+        case POWER_INTERACTIVE: return "interactive";
+        case POWER_DAY: return "day";
+        case POWER_NIGHT: return "night";
+        default: return "?";
+    }
+}
+
+uint64_t power_time_us(power_profile_t p)
+{
+    return spent_us[p] + (p == current ? time_us_64() - since_us : 0);
+}
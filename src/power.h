@@ -0,0 +1,43 @@
+/**
+ * power.h
+ *
+ * System clock profiles by activity. The RP2350 runs at the SDK clock only while someone uses
+ * the clock, during the day and the night it only has to notice a minute tick or a button and
+ * runs slower. Everything derived from clk_sys is set again after a change: the i2c baud rates,
+ * the sample rate of the PIO debounce and the chime's DMA timer. clk_peri runs from the crystal,
+ * so the uart doesn't notice, and the microsecond timer and the watchdog tick from clk_ref.
+ *
+ * power_init() also stops what the firmware never uses: the USB and ADC clocks with the USB
+ * PLL behind them, the HSTX clock, and PIO blocks and uarts nothing claimed, held in reset.
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+#include "hardware/i2c.h"
+
+enum power_profile_t : uint8_t {
+    POWER_INTERACTIVE,  // buttons, configuration commands, the chime
+    POWER_DAY,          // wakeup mode, nobody around
+    POWER_NIGHT,        // goto sleep mode, nobody around
+    POWER_PROFILES
+};
+
+// An i2c bus to keep at baudrate across clock changes. Every profile's clock must give it at
+// least 16 cycles a bit; a profile that can't is skipped for the next faster one.
+void power_track_i2c(i2c_inst_t * i2c, uint baudrate);
+
+// after everything is claimed, starts in POWER_INTERACTIVE
+void power_init();
+
+// Switch to profile p, nothing happens when it is already in use. Waits for a DMA i2c write
+// and the uart to finish first, a change takes well under a millisecond.
+bool power_select(power_profile_t p);
+power_profile_t power_profile();
+uint32_t power_sys_khz();
+const char * power_profile_name(power_profile_t p);
+// time spent in profile p since power_init()
+uint64_t power_time_us(power_profile_t p);
+
+#endif // POWER_H
@@ -0,0 +1,103 @@
+/**
+ * rtc_calibration.cpp
+ *
+ * RV3028 crystal error measured against the RP2350 timer.
+ */
+
+#include "rtc_calibration.h"
+
+#include <math.h>
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "pico/time.h"
+#include "rv3028.h"
+
+// the clock output has an edge every millisecond, give up when there is none for much longer
+#define RTC_CALIBRATION_EDGE_TIMEOUT_US 100000
+
+bool rtc_calibration_measure(uint pin, uint32_t seconds, uint32_t & edges, uint64_t & elapsed_us,
+                             rtc_calibration_progress_t progress, void * ctx)
+{
+    // the slice counts rising edges on its B pin instead of system clock cycles, the 16 bit
+    // counter wraps in a minute at 1024 Hz so it is polled and accumulated
+    uint slice = pwm_gpio_to_slice_num(pin);
+    pwm_config cfg = pwm_get_default_config();
+    pwm_config_set_clkdiv_mode(&cfg, PWM_DIV_B_RISING);
+    pwm_config_set_clkdiv(&cfg, 1.f);
+    pwm_init(slice, &cfg, false);
+    gpio_set_function(pin, GPIO_FUNC_PWM);
+    pwm_set_counter(slice, 0);
+    pwm_set_enabled(slice, true);
+
+    // the window starts at an edge, not at an arbitrary point between two
+    uint16_t last = 0;
+    uint64_t start = time_us_64();
+    while ((last = pwm_get_counter(slice)) == 0)
+    {
+        if (time_us_64() - start > RTC_CALIBRATION_EDGE_TIMEOUT_US)
+        {
+            pwm_set_enabled(slice, false);
+            return false;
+        }
+    }
+    start = time_us_64();
+
+    const uint64_t window_us = (uint64_t)seconds * 1000000;
+    uint64_t last_edge = start;
+    uint32_t count = 0;
+    uint32_t reported = 0;
+    bool ok = true;
+    while (true)
+    {
+        uint16_t c = pwm_get_counter(slice);
+        uint64_t now = time_us_64();
+        if (c != last)
+        {
+            count += (uint16_t)(c - last);
+            last = c;
+            last_edge = now;
+            // ... and ends at one too. Progress is only reported a second or more before the
+            // end, so the final edges are timed by a tight loop.
+            if (now - start >= window_us)
+                break;
+        }
+        else if (now - last_edge > RTC_CALIBRATION_EDGE_TIMEOUT_US)
+        {
+            ok = false;
+            break;
+        }
+
+        uint32_t done = (now - start) / 1000000;
+        if (progress && done != reported && done < seconds)
+        {
+            reported = done;
+            progress(done, seconds, ctx);
+        }
+    }
+    pwm_set_enabled(slice, false);
+    gpio_set_function(pin, GPIO_FUNC_SIO);
+
+    edges = count;
+    elapsed_us = last_edge - start;
+    return ok;
+}
+
+double rtc_calibration_ppm(uint32_t edges, uint64_t elapsed_us, uint32_t nominal_hz, double reference_ppm)
+{
+    if (elapsed_us == 0 || nominal_hz == 0)
+        return 0;
+
+    // a fast reference makes the window look longer and the RTC slower than it is
+    double hz = edges * 1e6 / (double)elapsed_us;
+    return (hz / nominal_hz - 1) * 1e6 + reference_ppm;
+}
+
+int16_t rtc_calibration_steps(double ppm)
+{
+    long steps = lround(ppm / rv3028::OFFSET_STEP_PPM);
+    if (steps < rv3028::OFFSET_MIN)
+        return rv3028::OFFSET_MIN;
+    if (steps > rv3028::OFFSET_MAX)
+        return rv3028::OFFSET_MAX;
+    return (int16_t)steps;
+}
@@ -0,0 +1,34 @@
+/**
+ * rtc_calibration.h
+ *
+ * Measure how far the RV3028 crystal is off, with the RP2350 crystal as the reference. The RTC
+ * clock output is wired to a GPIO and its rising edges are counted by a PWM slice while the
+ * microsecond timer measures how long they took. The error in ppm converts to the RV3028
+ * EEOffset steps that correct it.
+ *
+ * The result is no better than the reference: a known error of the RP2350 crystal can be given
+ * as reference_ppm, positive when it runs fast.
+ */
+
+#ifndef RTC_CALIBRATION_H
+#define RTC_CALIBRATION_H
+
+#include <stdint.h>
+#include "pico/types.h"
+
+// done and total are seconds of the measurement window
+typedef void (*rtc_calibration_progress_t)(uint32_t done, uint32_t total, void * ctx);
+
+// Count rising edges on pin, which must be a PWM B input (an odd GPIO), for about seconds
+// seconds. edges and elapsed_us run from the first edge to the last. Returns false when no
+// edges arrive, progress may be null.
+bool rtc_calibration_measure(uint pin, uint32_t seconds, uint32_t & edges, uint64_t & elapsed_us,
+                             rtc_calibration_progress_t progress, void * ctx);
+
+// frequency error of the measured clock in ppm, positive when it runs fast
+double rtc_calibration_ppm(uint32_t edges, uint64_t elapsed_us, uint32_t nominal_hz, double reference_ppm);
+
+// the EEOffset value that corrects ppm, clamped to what the register holds
+int16_t rtc_calibration_steps(double ppm);
+
+#endif // RTC_CALIBRATION_H
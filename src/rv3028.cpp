@@ -6,11 +6,14 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include <hardware/i2c.h>
 #include <pico/time.h>
 
-#include "utils.h"
+#include "i2c_bus.h"
+#include "trace.h"
+#include "tz.h"
 
 // The 7-bit I2C ADDRESS of the RV3028
 #define RV3028_ADDR         0x52
@@ -86,6 +89,12 @@
 #define RV3028_EEOffset_8_1      0x36 // bits 8 to 1 of EEOffset. Bit 0 is bit 7 of register 0x37
 #define EEPROM_Backup_Register   0x37
 
+// User EEPROM 0x28-0x2A, after the schedule table: EEPROM program cycles since the first boot,
+// most significant byte first. Saved every few cycles so keeping count wears the EEPROM little.
+#define EEPROM_CYCLES_ADDR       0x28
+#define EEPROM_CYCLES_BYTES      3
+#define EEPROM_CYCLES_SAVE_EVERY 16
+
 
 // BITS IN IMPORTANT REGISTERS
 
@@ -118,6 +127,11 @@
 #define CTRL2_12_24       1
 #define CTRL2_RESET       0
 
+// Bits in Event Control register
+#define EVENTCTRL_TSR     2 // time stamp reset, reads as 0
+#define EVENTCTRL_TSOW    1 // 1 = a new event overwrites the stamp
+#define EVENTCTRL_TSS     0 // 1 = stamp the backup switchover instead of the EVI pin
+
 // Bits in Hours register
 #define HOURS_AM_PM       5
 
@@ -187,15 +201,15 @@ uint8_t dec_to_bcd(const uint8_t d)
 static uint8_t read_register(i2c_inst_t * i2c, uint8_t reg)
 {
     uint8_t val;
-    i2c_write_blocking(i2c, RV3028_I2C_ADDR, &reg, 1, true);
-    i2c_read_blocking(i2c, RV3028_I2C_ADDR, &val, 1, false);
+    i2c_bus_write(i2c, RV3028_I2C_ADDR, &reg, 1, true);
+    i2c_bus_read(i2c, RV3028_I2C_ADDR, &val, 1, false);
     return val;
 }
 
 static bool write_register(i2c_inst_t * i2c, uint8_t reg, uint8_t val)
 {
     uint8_t buf[2] = {reg, val};
-    if (i2c_write_blocking(i2c, RV3028_I2C_ADDR, buf, 2, true) == 1)
+    if (i2c_bus_write(i2c, RV3028_I2C_ADDR, buf, 2, true) == sizeof(buf))
         return true;
 
     return false;
@@ -211,6 +225,9 @@ static bool wait_for_eeprom_nobusy(i2c_inst_t * i2c) {
 rv3028::rv3028(i2c_inst_t * i2c)
 {
     _i2c = i2c;
+    _saved_clkout = 0;
+    _eeprom_cycles = 0;
+    _eeprom_cycles_loaded = false;
     write_register(_i2c, RV3028_STATUS, 0x00);
 }
 
@@ -286,35 +303,75 @@ uint8_t read_config_eeprom_ram_mirror(i2c_inst_t * i2c, uint8_t eeprom_addr)
     return eeprom_data;
 }
 
-bool rv3028::setEepromRegister(uint8_t eeprom_addr, uint8_t val)
+static bool write_user_eeprom(i2c_inst_t * i2c, uint8_t eeprom_addr, uint8_t val)
 {
-    DEBUG_PRINT("setEepromRegister\r\n");
-    if (eeprom_addr > 0x2A)  // max user-accessible EEPROM address
-        return false;
-
-    bool ret = wait_for_eeprom_nobusy(_i2c);
+    bool ret = wait_for_eeprom_nobusy(i2c);
 
     // Disable auto refresh by writing 1 to EERD control bit in CTRL1 register
-    set_eeprom_autorefresh(_i2c, false);
+    set_eeprom_autorefresh(i2c, false);
 
     // Write EEPROM Register
-    write_register(_i2c, RV3028_EEPROM_ADDR, eeprom_addr);
-    write_register(_i2c, RV3028_EEPROM_DATA, val);
-    write_register(_i2c, RV3028_EEPROM_CMD, EEPROMCMD_First);
-    write_register(_i2c, RV3028_EEPROM_CMD, EEPROMCMD_WriteSingle);
+    write_register(i2c, RV3028_EEPROM_ADDR, eeprom_addr);
+    write_register(i2c, RV3028_EEPROM_DATA, val);
+    write_register(i2c, RV3028_EEPROM_CMD, EEPROMCMD_First);
+    write_register(i2c, RV3028_EEPROM_CMD, EEPROMCMD_WriteSingle);
 
-    if(!wait_for_eeprom_nobusy(_i2c))
+    if(!wait_for_eeprom_nobusy(i2c))
         ret = false;
 
     // Reenable auto refresh by writing 0 to EERD control bit in CTRL1 register
-    set_eeprom_autorefresh(_i2c, true);
+    set_eeprom_autorefresh(i2c, true);
 
     return ret;
 }
 
+bool rv3028::setEepromRegister(uint8_t eeprom_addr, uint8_t val)
+{
+    TRACE(TRACE_RTC_SET_EEPROM, eeprom_addr, val);
+    if (eeprom_addr > 0x2A)  // max user-accessible EEPROM address
+        return false;
+
+    countEepromCycles(1);
+    return write_user_eeprom(_i2c, eeprom_addr, val);
+}
+
+void rv3028::loadEepromCycles()
+{
+    if (_eeprom_cycles_loaded)
+        return;
+    _eeprom_cycles_loaded = true;
+
+    uint32_t saved = 0;
+    for (int i = 0; i < EEPROM_CYCLES_BYTES; i++)
+        saved = saved << 8 | getEepromRegister(EEPROM_CYCLES_ADDR + i);
+    // erased EEPROM, the count starts now
+    _eeprom_cycles = saved == 0xFFFFFF ? 0 : saved;
+}
+
+void rv3028::countEepromCycles(uint32_t n)
+{
+    loadEepromCycles();
+    uint32_t before = _eeprom_cycles;
+    _eeprom_cycles += n;
+    if (before / EEPROM_CYCLES_SAVE_EVERY == _eeprom_cycles / EEPROM_CYCLES_SAVE_EVERY)
+        return;
+
+    // saving costs cycles too, they are part of the saved count
+    _eeprom_cycles += EEPROM_CYCLES_BYTES;
+    uint32_t saved = _eeprom_cycles < 0xFFFFFF ? _eeprom_cycles : 0xFFFFFE;
+    for (int i = 0; i < EEPROM_CYCLES_BYTES; i++)
+        write_user_eeprom(_i2c, EEPROM_CYCLES_ADDR + i, saved >> (8 * (EEPROM_CYCLES_BYTES - 1 - i)));
+}
+
+uint32_t rv3028::getEepromCycles()
+{
+    loadEepromCycles();
+    return _eeprom_cycles;
+}
+
 uint8_t rv3028::getEepromRegister(uint8_t eeprom_addr)
 {
-    DEBUG_PRINT("getEepromRegister\r\n");
+    TRACE(TRACE_RTC_GET_EEPROM, eeprom_addr);
     if (eeprom_addr > 0x2A)  // max user-accessible EEPROM address
         return 0xFF;
 
@@ -369,6 +426,85 @@ bool set_backup_switchover_mode(i2c_inst_t * i2c, uint8_t val) {
     return success;
 }
 
+bool rv3028::startCalibrationClock()
+{
+    // Only the RAM mirror is changed, with the automatic refresh from the EEPROM held off until
+    // stopCalibrationClock(), so nothing is written to the EEPROM
+    if (!set_eeprom_autorefresh(_i2c, false))
+        return false;
+
+    _saved_clkout = read_register(_i2c, EEPROM_Clkout_Register);
+    uint8_t clkout = 1 << EEPROMClkout_CLKOE_BIT | FD_CLKOUT_1024 << EEPROMClkout_FREQ_SHIFT;
+    return write_register(_i2c, EEPROM_Clkout_Register, clkout);
+}
+
+void rv3028::stopCalibrationClock()
+{
+    write_register(_i2c, EEPROM_Clkout_Register, _saved_clkout);
+    set_eeprom_autorefresh(_i2c, true);
+}
+
+int16_t rv3028::getOffset()
+{
+    // 9 bit two's complement, bits 8 to 1 in EEOffset_8_1 and bit 0 in bit 7 of the backup register
+    uint16_t raw = read_register(_i2c, RV3028_EEOffset_8_1) << 1 | read_register(_i2c, EEPROM_Backup_Register) >> 7;
+    return raw & 0x100 ? (int16_t)raw - 0x200 : (int16_t)raw;
+}
+
+bool rv3028::setOffset(int16_t steps)
+{
+    TRACE(TRACE_RTC_SET_OFFSET, (uint32_t)steps);
+    if (steps < OFFSET_MIN || steps > OFFSET_MAX)
+        return false;
+
+    uint16_t raw = steps & 0x1FF;
+    uint8_t backup = read_config_eeprom_ram_mirror(_i2c, EEPROM_Backup_Register);
+    if (backup == 0xFF)
+        return false;
+    backup = (backup & 0x7F) | (raw & 1) << 7;
+    countEepromCycles(1);
+
+    // the first write only updates the RAM, the second copies both registers to the EEPROM
+    if (!wait_for_eeprom_nobusy(_i2c) || !set_eeprom_autorefresh(_i2c, false))
+        return false;
+    write_register(_i2c, RV3028_EEOffset_8_1, raw >> 1);
+    return write_config_eeprom_ram_mirror(_i2c, EEPROM_Backup_Register, backup);
+}
+
+uint8_t rv3028::takePowerLossStamp(rv3028_date_t & date, rv3028_time_t & time)
+{
+    uint8_t ctrl2 = read_register(_i2c, RV3028_CTRL2);
+    uint8_t count = 0;
+    if (ctrl2 & 1 << CTRL2_TSE)
+        count = read_register(_i2c, RV3028_COUNT_TS);
+
+    if (count)
+    {
+        uint8_t ts[6];
+        uint8_t reg = RV3028_SECONDS_TS;
+        i2c_bus_write(_i2c, RV3028_I2C_ADDR, &reg, 1, true);
+        i2c_bus_read(_i2c, RV3028_I2C_ADDR, ts, sizeof(ts), false);
+        time = {(uint8_t)bcd_to_dec(ts[0]), (uint8_t)bcd_to_dec(ts[1]), (uint8_t)bcd_to_dec(ts[2])};
+        // the weekday isn't stamped
+        date = {0, (uint8_t)bcd_to_dec(ts[3]), (uint8_t)bcd_to_dec(ts[4]), (uint8_t)bcd_to_dec(ts[5])};
+    }
+
+    // needs the backup switchover mode oneTimeSetup() enables, the registers live in the RAM
+    write_register(_i2c, RV3028_EVENTCTRL, 1 << EVENTCTRL_TSR | 1 << EVENTCTRL_TSOW | 1 << EVENTCTRL_TSS);
+    write_register(_i2c, RV3028_CTRL2, ctrl2 | 1 << CTRL2_TSE);
+    return count;
+}
+
+uint8_t rv3028::getUserRam(uint8_t i)
+{
+    return i < USER_RAM_BYTES ? read_register(_i2c, RV3028_USER_RAM1 + i) : 0;
+}
+
+bool rv3028::setUserRam(uint8_t i, uint8_t val)
+{
+    return i < USER_RAM_BYTES && write_register(_i2c, RV3028_USER_RAM1 + i, val);
+}
+
 void rv3028::oneTimeSetup()
 {
     // Disable trickle-charging
@@ -379,24 +515,25 @@ void rv3028::oneTimeSetup()
 
     // Check switchover to level-shift mode for battery backup
     set_backup_switchover_mode(_i2c, 3);
+    countEepromCycles(2);
     sleep_ms(1000);
 }
 
 void rv3028::setTime(uint8_t hours, uint8_t minutes, uint8_t seconds)
 {
-    DEBUG_PRINT("setTime\r\n");
+    TRACE(TRACE_RTC_SET_TIME, hours, minutes, seconds);
     uint8_t buf[4] = {
         RV3028_SECONDS,
         dec_to_bcd(seconds),
         dec_to_bcd(minutes),
         dec_to_bcd(hours)
     };
-    i2c_write_blocking(_i2c, RV3028_I2C_ADDR, buf, sizeof(buf), false);
+    i2c_bus_write(_i2c, RV3028_I2C_ADDR, buf, sizeof(buf), false);
 }
 
 void rv3028::setDate(uint8_t year, uint8_t month, uint8_t day, uint8_t weekday)
 {
-    DEBUG_PRINT("setDate\r\n");
+    TRACE(TRACE_RTC_SET_DATE, year, month, day);
     uint8_t buf[5] = {
         RV3028_WEEKDAY,
         dec_to_bcd(weekday),
@@ -404,35 +541,103 @@ void rv3028::setDate(uint8_t year, uint8_t month, uint8_t day, uint8_t weekday)
         dec_to_bcd(month),
         dec_to_bcd(year)
     };
-    i2c_write_blocking(_i2c, RV3028_I2C_ADDR, buf, sizeof(buf), false);
+    i2c_bus_write(_i2c, RV3028_I2C_ADDR, buf, sizeof(buf), false);
 }
 
 void rv3028::setDateTime(time_t * time)
 {
-    DEBUG_PRINT("setDateTime\r\n");
     struct tm * t = gmtime(time);
-    //mktime
+    // tm counts months from 0 and years from 1900
+    rv3028_date_t date = {(uint8_t)t->tm_wday, (uint8_t)t->tm_mday, (uint8_t)(t->tm_mon + 1), (uint8_t)(t->tm_year % 100)};
+    rv3028_time_t tod = {(uint8_t)t->tm_sec, (uint8_t)t->tm_min, (uint8_t)t->tm_hour};
+    setDateTime(date, tod);
+}
+
+void rv3028::setDateTime(const rv3028_date_t & date, const rv3028_time_t & time)
+{
+    TRACE(TRACE_RTC_SET_DATE_TIME);
     uint8_t buf[8] = {
         RV3028_SECONDS,
-        dec_to_bcd(t->tm_sec),
-        dec_to_bcd(t->tm_min),
-        dec_to_bcd(t->tm_hour),
-        dec_to_bcd(t->tm_wday),
-        dec_to_bcd(t->tm_mday),
-        dec_to_bcd(t->tm_mon),
-        dec_to_bcd(t->tm_year + 100)
+        dec_to_bcd(time.seconds),
+        dec_to_bcd(time.minutes),
+        dec_to_bcd(time.hours),
+        dec_to_bcd(date.weekday),
+        dec_to_bcd(date.date),
+        dec_to_bcd(date.month),
+        dec_to_bcd(date.year)
     };
-    i2c_write_blocking(_i2c, RV3028_I2C_ADDR, buf, sizeof(buf), false);
+    i2c_bus_write(_i2c, RV3028_I2C_ADDR, buf, sizeof(buf), false);
 }
 
 void rv3028::printTime()
 {
-    DEBUG_PRINT("printTime\r\n");
+    TRACE(TRACE_RTC_PRINT_TIME);
     uint8_t seconds_addr = 0x00;
     uint8_t time[3];
-    i2c_write_blocking(_i2c, RV3028_I2C_ADDR, &seconds_addr, 1, true);
-    i2c_read_blocking(_i2c, RV3028_I2C_ADDR, time, 3, false);
-    printf("%02lu:%02lu:%02lu\n", bcd_to_dec(time[2]), bcd_to_dec(time[1]), bcd_to_dec(time[0]));
+    i2c_bus_write(_i2c, RV3028_I2C_ADDR, &seconds_addr, 1, true);
+    i2c_bus_read(_i2c, RV3028_I2C_ADDR, time, 3, false);
+    printf("%02u:%02u:%02u\n", bcd_to_dec(time[2]), bcd_to_dec(time[1]), bcd_to_dec(time[0]));
+}
+
+rv3028::rv3028_date_t rv3028::getDate()
+{
+    TRACE(TRACE_RTC_GET_DATE);
+    rv3028_date_t date;
+
+    uint8_t weekday_addr = RV3028_WEEKDAY;
+    i2c_bus_write(_i2c, RV3028_I2C_ADDR, &weekday_addr, 1, true);
+    i2c_bus_read(_i2c, RV3028_I2C_ADDR, (uint8_t *)&date, 4, false);
+
+    date.weekday = date.weekday & 0x07;
+    date.date = bcd_to_dec(date.date);
+    date.month = bcd_to_dec(date.month);
+    date.year = bcd_to_dec(date.year);
+    return date;
+}
+
+// the main loop reads the time on every pass, the bus only sees a read every 100 ms
+static uint64_t lastGetUnixMs = 0;
+static uint32_t lastUnix = 0;
+
+uint32_t rv3028::getUnixTime()
+{
+    uint64_t now = to_ms_since_boot(get_absolute_time());
+    if (now - lastGetUnixMs < 100)
+        return lastUnix;
+
+    // the counter may tick between the bytes of a read, two reads that agree can't be torn
+    uint8_t reg = RV3028_UNIX_TIME0;
+    uint8_t a[4], b[4];
+    i2c_bus_write(_i2c, RV3028_I2C_ADDR, &reg, 1, true);
+    i2c_bus_read(_i2c, RV3028_I2C_ADDR, b, sizeof(b), false);
+    do
+    {
+        memcpy(a, b, sizeof(a));
+        i2c_bus_write(_i2c, RV3028_I2C_ADDR, &reg, 1, true);
+        i2c_bus_read(_i2c, RV3028_I2C_ADDR, b, sizeof(b), false);
+    } while (memcmp(a, b, sizeof(a)) != 0);
+
+    lastGetUnixMs = now;
+    lastUnix = (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+#if TRACE_RTC_READS
+    TRACE(TRACE_RTC_GET_UNIX);
+#endif
+    return lastUnix;
+}
+
+void rv3028::setUnixTime(uint32_t seconds)
+{
+    TRACE(TRACE_RTC_SET_UNIX, seconds);
+    rv3028_date_t date;
+    rv3028_time_t time;
+    tz_civil(seconds, date, time);
+    setDateTime(date, time);
+
+    uint8_t buf[5] = {RV3028_UNIX_TIME0, (uint8_t)seconds, (uint8_t)(seconds >> 8), (uint8_t)(seconds >> 16),
+                      (uint8_t)(seconds >> 24)};
+    i2c_bus_write(_i2c, RV3028_I2C_ADDR, buf, sizeof(buf), false);
+    lastGetUnixMs = to_ms_since_boot(get_absolute_time());
+    lastUnix = seconds;
 }
 
 rv3028::rv3028_time_t rv3028::getTime()
@@ -446,8 +651,8 @@ rv3028::rv3028_time_t rv3028::getTime()
     rv3028_time_t time;
 
     uint8_t seconds_addr = 0x00;
-    i2c_write_blocking(_i2c, RV3028_I2C_ADDR, &seconds_addr, 1, true);
-    i2c_read_blocking(_i2c, RV3028_I2C_ADDR, (uint8_t *)&time, 3, false);
+    i2c_bus_write(_i2c, RV3028_I2C_ADDR, &seconds_addr, 1, true);
+    i2c_bus_read(_i2c, RV3028_I2C_ADDR, (uint8_t *)&time, 3, false);
 
     time.hours = bcd_to_dec(time.hours);
     time.minutes = bcd_to_dec(time.minutes);
@@ -456,7 +661,7 @@ rv3028::rv3028_time_t rv3028::getTime()
     lastGetTimeMs = now;
     lastTime = time;
 
-    DEBUG_PRINT("getTime\r\n");
+    TRACE(TRACE_RTC_GET_TIME);
 
     return time;
 }
\ No newline at end of file
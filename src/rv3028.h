@@ -21,17 +21,63 @@ public:
         uint8_t hours;
     } rv3028_time_t;
 
+    typedef struct {
+        uint8_t weekday;    // 0-6, whatever day setDate() was given as 0
+        uint8_t date;       // 1-31
+        uint8_t month;      // 1-12
+        uint8_t year;       // 0-99
+    } rv3028_date_t;
+
     void oneTimeSetup();
     void setTime(uint8_t hours, uint8_t minutes, uint8_t seconds);
     void setDate(uint8_t year, uint8_t month, uint8_t day, uint8_t weekday);
     void setDateTime(time_t * time);
+    // date and time in a single write, so they can't be torn by a carry between two writes
+    void setDateTime(const rv3028_date_t & date, const rv3028_time_t & time);
     bool setEepromRegister(uint8_t eeprom_addr, uint8_t val);
     uint8_t getEepromRegister(uint8_t eeprom_addr);
+    // EEPROM program cycles since the first boot, user and configuration EEPROM together. The
+    // count is kept in the user EEPROM, its first use costs three EEPROM reads.
+    uint32_t getEepromCycles();
     rv3028_time_t getTime();
+    rv3028_date_t getDate();
+    // The clock runs in UTC: the UNIX time counter, seconds since 1970, with the calendar
+    // registers set to the same time so the power loss stamp is UTC as well.
+    uint32_t getUnixTime();
+    void setUnixTime(uint32_t seconds);
     void printTime();
 
+    // Calibration. The clock output is switched to CALIBRATION_CLOCK_HZ, a frequency taken
+    // before the offset correction, until stopCalibrationClock() puts the old setting back.
+    // The offset is in steps of OFFSET_STEP_PPM, positive values slow the clock down.
+    static constexpr uint32_t CALIBRATION_CLOCK_HZ = 1024;
+    static constexpr float OFFSET_STEP_PPM = 0.9537f;
+    static constexpr int16_t OFFSET_MIN = -256;
+    static constexpr int16_t OFFSET_MAX = 255;
+    bool startCalibrationClock();
+    void stopCalibrationClock();
+    int16_t getOffset();
+    bool setOffset(int16_t steps);
+
+    // Time stamp of the last switch to the backup battery, i.e. when the main power went away.
+    // Returns how many switchovers were counted since the previous call, 0 for none, and starts
+    // counting again. The first call after the RTC itself lost power only enables the stamp.
+    uint8_t takePowerLossStamp(rv3028_date_t & date, rv3028_time_t & time);
+
+    // The two user RAM bytes, kept on the backup battery, 0 after the RTC lost power. No
+    // EEPROM cycles, for settings that change too often or don't fit the user EEPROM.
+    static constexpr uint8_t USER_RAM_BYTES = 2;
+    uint8_t getUserRam(uint8_t i);
+    bool setUserRam(uint8_t i, uint8_t val);
+
 private:
+    void loadEepromCycles();
+    void countEepromCycles(uint32_t n);
+
     i2c_inst_t * _i2c;
+    uint8_t _saved_clkout;
+    uint32_t _eeprom_cycles;
+    bool _eeprom_cycles_loaded;
 };
 
 #endif //RV3028_H
@@ -0,0 +1,125 @@
+/**
+ * schedule.cpp
+ *
+ * Day dependent wakeup and goto sleep times, stored in the RV3028 user EEPROM.
+ */
+
+#include "schedule.h"
+
+#include <stdio.h>
+#include "trace.h"
+
+// user EEPROM 0x00-0x03 holds the default pair, the table follows
+#define SCHEDULE_EEPROM_FIRST      0x04
+#define SCHEDULE_ENTRY_BYTES       4
+
+#define SCHEDULE_BY_DATE_BIT       31
+#define SCHEDULE_TIME_BITS         11
+#define SCHEDULE_TIME_MASK         ((1u << SCHEDULE_TIME_BITS) - 1)
+#define MINUTES_PER_DAY            (24 * 60)
+
+// 0x28-0x2A hold the EEPROM cycle count, see rv3028.cpp
+static_assert(SCHEDULE_EEPROM_FIRST + Schedule::ENTRIES * SCHEDULE_ENTRY_BYTES - 1 <= 0x27,
+              "schedule table doesn't fit the user EEPROM");
+
+uint32_t Schedule::encode(const Entry & e)
+{
+    uint32_t raw = (uint32_t)(e.times.wakeup % MINUTES_PER_DAY) << SCHEDULE_TIME_BITS |
+                   (e.times.gotosleep % MINUTES_PER_DAY);
+    if (e.by_date)
+        raw |= 1u << SCHEDULE_BY_DATE_BIT | (uint32_t)(e.month & 0x0F) << 27 | (uint32_t)(e.day & 0x1F) << 22;
+    else
+        raw |= (uint32_t)(e.weekdays & 0x7F) << 24;
+    return raw;
+}
+
+bool Schedule::decode(uint32_t raw, Entry & e)
+{
+    if (raw == UNUSED)
+        return false;
+
+    e.by_date = raw >> SCHEDULE_BY_DATE_BIT;
+    e.weekdays = e.by_date ? 0 : (raw >> 24) & 0x7F;
+    e.month = e.by_date ? (raw >> 27) & 0x0F : 0;
+    e.day = e.by_date ? (raw >> 22) & 0x1F : 0;
+    e.times.wakeup = (raw >> SCHEDULE_TIME_BITS) & SCHEDULE_TIME_MASK;
+    e.times.gotosleep = raw & SCHEDULE_TIME_MASK;
+
+    if (e.times.wakeup >= MINUTES_PER_DAY || e.times.gotosleep >= MINUTES_PER_DAY)
+        return false;
+    return e.by_date ? e.month >= 1 && e.month <= 12 && e.day >= 1 : e.weekdays != 0;
+}
+
+void Schedule::load(rv3028 & rv)
+{
+    int used = 0;
+    for (int i = 0; i < ENTRIES; i++)
+    {
+        uint32_t raw = 0;
+        for (int b = 0; b < SCHEDULE_ENTRY_BYTES; b++)
+            raw = raw << 8 | rv.getEepromRegister(SCHEDULE_EEPROM_FIRST + i * SCHEDULE_ENTRY_BYTES + b);
+        _raw[i] = raw;
+        _used[i] = decode(raw, _entries[i]);
+        used += _used[i];
+    }
+    TRACE(TRACE_SCHEDULE_LOADED, used, ENTRIES);
+}
+
+bool Schedule::writeSlot(rv3028 & rv, int slot, uint32_t raw)
+{
+    bool ok = true;
+    for (int b = 0; b < SCHEDULE_ENTRY_BYTES; b++)
+    {
+        int shift = 8 * (SCHEDULE_ENTRY_BYTES - 1 - b);
+        uint8_t val = raw >> shift;
+        if (val != (uint8_t)(_raw[slot] >> shift))
+            ok &= rv.setEepromRegister(SCHEDULE_EEPROM_FIRST + slot * SCHEDULE_ENTRY_BYTES + b, val);
+    }
+    _raw[slot] = raw;
+    return ok;
+}
+
+bool Schedule::store(rv3028 & rv, int slot, const Entry & e)
+{
+    if (slot < 0 || slot >= ENTRIES)
+        return false;
+
+    uint32_t raw = encode(e);
+    _used[slot] = decode(raw, _entries[slot]);
+    return writeSlot(rv, slot, raw);
+}
+
+bool Schedule::clear(rv3028 & rv, int slot)
+{
+    if (slot < 0 || slot >= ENTRIES)
+        return false;
+
+    _used[slot] = false;
+    return writeSlot(rv, slot, UNUSED);
+}
+
+bool Schedule::storeRaw(rv3028 & rv, int slot, uint32_t raw)
+{
+    Entry e;
+    if (slot < 0 || slot >= ENTRIES || (raw != UNUSED && !decode(raw, e)))
+        return false;
+
+    _used[slot] = raw != UNUSED;
+    if (_used[slot])
+        _entries[slot] = e;
+    return writeSlot(rv, slot, raw);
+}
+
+Schedule::Times Schedule::resolve(const rv3028::rv3028_date_t & date, Times fallback) const
+{
+    // a holiday beats the weekday profiles
+    for (int i = 0; i < ENTRIES; i++)
+        if (_used[i] && _entries[i].by_date && _entries[i].month == date.month && _entries[i].day == date.date)
+            return _entries[i].times;
+
+    for (int i = 0; i < ENTRIES; i++)
+        if (_used[i] && !_entries[i].by_date && (_entries[i].weekdays >> date.weekday & 1))
+            return _entries[i].times;
+
+    return fallback;
+}
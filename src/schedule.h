@@ -0,0 +1,95 @@
+/**
+ * schedule.h
+ *
+ * Wakeup and goto sleep times that depend on the day. Next to the default pair set with the
+ * buttons, the RV3028 user EEPROM holds a small table of profiles, each either for a set of
+ * weekdays or for a single date (a holiday). The table is read once at boot and resolved to
+ * the day's effective pair when the date changes.
+ *
+ * Each entry is 4 bytes, most significant byte first:
+ *
+ *   weekdays: 0 | mask:7  | 00 | wakeup:11 | goto sleep:11     bit n of mask = weekday n, 0 = Sunday
+ *   date:     1 | month:4 | day:5 | wakeup:11 | goto sleep:11
+ *
+ * Times are minutes since midnight. A weekday entry with an empty mask is an unused slot, as is
+ * erased EEPROM (all ones). Date entries win over weekday entries, earlier entries over later
+ * ones, and with no match the default pair applies.
+ */
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <stdint.h>
+#include "rv3028.h"
+
+class Schedule {
+public:
+    // minutes since midnight
+    struct Times {
+        uint16_t wakeup;
+        uint16_t gotosleep;
+    };
+
+    struct Entry {
+        bool by_date;
+        uint8_t weekdays;   // mask, when !by_date
+        uint8_t month;      // when by_date
+        uint8_t day;
+        Times times;
+    };
+
+    static constexpr int ENTRIES = 9;
+
+    static uint32_t encode(const Entry & e);
+    // false for an unused slot
+    static bool decode(uint32_t raw, Entry & e);
+    static constexpr uint32_t UNUSED = 0xFFFFFFFF;
+
+    // read the whole table from the EEPROM
+    void load(rv3028 & rv);
+    // write one slot, to the EEPROM and the loaded copy
+    bool store(rv3028 & rv, int slot, const Entry & e);
+    bool clear(rv3028 & rv, int slot);
+    // a slot in the EEPROM format, as read or to be written by the configuration commands.
+    // storeRaw() refuses anything that is neither a valid entry nor UNUSED.
+    uint32_t raw(int slot) const { return _raw[slot]; }
+    bool storeRaw(rv3028 & rv, int slot, uint32_t raw);
+
+    Times resolve(const rv3028::rv3028_date_t & date, Times fallback) const;
+
+    // Whether minute (since midnight) is in wakeup mode: from the wakeup minute up to the goto
+    // sleep minute, around midnight when goto sleep comes first. Each mode starts on its own
+    // minute, and a pair with both at the same minute stays in goto sleep mode all day.
+    static bool isWakeup(uint16_t minute, Times times)
+    {
+        return since(times.wakeup, minute) < since(times.wakeup, times.gotosleep);
+    }
+
+    // Minutes of the sleep window (goto sleep until wakeup) that have passed, and its length.
+    // The window is the complement of wakeup mode: done < total exactly when !isWakeup(). With
+    // both at the same minute it is the whole day, from that minute on.
+    static void sleepProgress(uint16_t minute, Times times, uint16_t & done, uint16_t & total)
+    {
+        total = times.wakeup == times.gotosleep ? 24 * 60 : since(times.gotosleep, times.wakeup);
+        done = since(times.gotosleep, minute);
+    }
+
+private:
+    // minutes from one minute of the day to the next time it is another, 0 to a day - 1. Inline
+    // and without a division, so the host tests can sweep every minute of every pair.
+    static uint16_t since(uint16_t from, uint16_t to)
+    {
+        const uint16_t day = 24 * 60;
+        uint16_t d = to + day - from;
+        return d >= day ? d - day : d;
+    }
+
+    bool writeSlot(rv3028 & rv, int slot, uint32_t raw);
+
+    Entry _entries[ENTRIES];
+    bool _used[ENTRIES];
+    // what the EEPROM holds, only bytes that change are written
+    uint32_t _raw[ENTRIES];
+};
+
+#endif // SCHEDULE_H
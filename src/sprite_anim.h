@@ -0,0 +1,37 @@
+/**
+ * sprite_anim.h
+ *
+ * Delta encoded sprite animations for the SSD1306.
+ *
+ * An animation is a key frame plus, for every frame, the spans of bytes that change on the way
+ * to the next frame. The last frame's spans lead back to the key frame so animations loop. Spans
+ * are computed by tools/asset_compiler during the build, only the changed spans are sent at
+ * playback.
+ */
+
+#ifndef SPRITE_ANIM_H
+#define SPRITE_ANIM_H
+
+#include <stdint.h>
+#include "oled_glyph.h"
+
+// a run of bytes on one page of the sprite
+typedef struct {
+    uint8_t page;
+    uint8_t col;
+    uint8_t len;
+    uint16_t offset;                // into the animation data
+} sprite_span_t;
+
+typedef struct {
+    const oled_glyph_t * key_frame; // frame 0
+    const uint8_t * data;           // bytes of all spans
+    const sprite_span_t * spans;
+    const uint16_t * frame_spans;   // spans frame_spans[f] to frame_spans[f+1]-1 turn frame f into the next
+    uint8_t width;
+    uint8_t pages;
+    uint8_t frame_count;
+    uint16_t frame_ms;
+} sprite_anim_t;
+
+#endif // SPRITE_ANIM_H
@@ -3,11 +3,11 @@
  *
  * Interface to an SSD1306 OLED display using i2c.
  *
- * SSD1306 is an OLED driver chip for displays of multiple sizes. Here it is assumed the display is
- * 128x64 pixels.
+ * SSD1306 is an OLED driver chip for displays of multiple sizes. The geometry, i2c address and
+ * init values come from a panel profile (see panel_profile.h) chosen at compile time.
  *
- * The default i2c interface is used. SDA -> GPIO 4 (PICO_DEFAULT_I2C_SDA_PIN)
- *                                    SCL -> GPIO 5 (PICO_DEFAULT_I2C_SCL_PIN)
+ * The i2c instance is given to the constructor, set up by the caller, see ssd1306.h. Every
+ * transfer goes through i2c_bus, so the panel can share its bus with other targets.
  *
  * Copyright (c) 2024 Colin Luoma
  *
@@ -17,19 +17,24 @@
  */
 
 /**
- * The 128x64 pixel screen space is split into several sections for different purposes.
- *
- * |----------------------|-----------------------------------------------|
- * | 96x64 VMU screen     | 32x16 VMU title                               |
- * |                      |-----------------------------------------------|
- * |                      | 32x16 Current VMU bank number                 |
- * |                      |-----------------------------------------------|
- * |                      | 32x16 Current USB device                      |
- * |                      |-----------------------------------------------|
- * |----------------------| 16x16 Exclamation | 16x16 Storage target      |
+ * Screen layout of the 128x64 profile, see panel_profile.h for the regions. The 128x32 one has
+ * half size icons with the time, seconds, am/pm and progress next to them and no status line.
  *
+ * 0               57                                         125
+ * |---------------|------------------------------------------|-----|
+ * | 57x64 sun or  | 68x32 time                               |     |  pages 0-3
+ * | moon, cropped |                                          |     |
+ * | to its art    |                               |----------|     |
+ * |               |                               |16x8 am/pm|     |  page 4
+ * |               |-------------------------|     |----------|     |
+ * |               | 48x16 status            |     |18x16 secs|     |  pages 5-6
+ * |               |-------------------------|-----|----------|     |
+ * |               | 68x8 sleep progress                      |     |  page 7
+ * |---------------|------------------------------------------|-----|
+ *                                                              3 columns the pixel
+ *                                                              shift wraps around
  */
-
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
@@ -37,27 +42,21 @@
 #include "hardware/i2c.h"
 #include <hardware/dma.h>
 #include "ssd1306.h"
+#include "asset_pack.h"
+#include "i2c_bus.h"
+#include "trace.h"
 extern "C" {
 #include "oled_static_data.h"
 }
 
-#define SSD1306_HEIGHT              64
-#define SSD1306_WIDTH               128
-
-#define SSD1306_I2C_ADDR            _u(0x3C)
-
-// 400 is usual, but often these can be overclocked to improve display response.
-// Tested at 1000 on both 32 and 84 pixel height devices and it worked.
-#define SSD1306_I2C_CLK             400
-//#define SSD1306_I2C_CLK             1000
-
-
 // commands (see datasheet)
 #define SSD1306_SET_MEM_MODE        _u(0x20)
 #define SSD1306_SET_COL_ADDR        _u(0x21)
 #define SSD1306_SET_PAGE_ADDR       _u(0x22)
 #define SSD1306_SET_HORIZ_SCROLL    _u(0x26)
 #define SSD1306_SET_SCROLL          _u(0x2E)
+#define SSD1306_CONTENT_SCROLL_RIGHT _u(0x2C)
+#define SSD1306_CONTENT_SCROLL_LEFT _u(0x2D)
 
 #define SSD1306_SET_DISP_START_LINE _u(0x40)
 
@@ -81,50 +80,46 @@ extern "C" {
 #define SSD1306_SET_VCOM_DESEL      _u(0xDB)
 
 #define SSD1306_PAGE_HEIGHT         _u(8)
-#define SSD1306_NUM_PAGES           (SSD1306_HEIGHT / SSD1306_PAGE_HEIGHT)
-#define SSD1306_BUF_LEN             (SSD1306_NUM_PAGES * SSD1306_WIDTH)
+
+// a one column content scroll takes effect over the next two frames, don't touch the RAM
+// until it has finished
+#define SSD1306_SCROLL_SETTLE_MS    25
+
+// Temporal dithering: a bit plane is started every GRAY_PLANE_US. A 64x64 plane is 513 bytes,
+// about 5.8 ms at 800 kHz, so this is close to the fastest the bus allows. A 2 bit cycle of three
+// planes then repeats at ~51 Hz, right at the edge of visible flicker; 3 bits (7 planes) flicker.
+#define GRAY_PLANE_US               6500
+#define FLICKER_FUSION_HZ           50
 
 #define SSD1306_WRITE_MODE         _u(0xFE)
 #define SSD1306_READ_MODE          _u(0xFF)
 
-//#define OLED_BUFFER_SIZE (7 + 8 * 128) // 7 words for screen clearing commands and data start bit before screen data
-#define OLED_BUFFER_SIZE (128 *  64 / 8)
-
 static uint16_t renderAreaBufLen(uint8_t colStart, uint8_t colEnd, uint8_t pageStart, uint8_t pageEnd)
 {
     // calculate how long the flattened buffer will be for a render area
     return (colEnd - colStart + 1) * (pageEnd - pageStart + 1);
 }
 
-void SSD1306_send_cmd(uint8_t cmd) {
+template <class Panel>
+void SSD1306<Panel>::sendCmd(uint8_t cmd) {
     // I2C write process expects a control byte followed by data
     // this "data" can be a command or data to follow up a command
     // Co = 1, D/C = 0 => the driver expects a command
     uint8_t buf[2] = {0x80, cmd};
-    i2c_write_blocking(i2c_default, SSD1306_I2C_ADDR, buf, 2, false);
+    i2c_bus_write(_i2c, Panel::i2c_addr, buf, 2, false);
 }
 
-void SSD1306_send_cmd_list(uint8_t *buf, int num) {
-    for (int i=0;i<num;i++)
-        SSD1306_send_cmd(buf[i]);
-}
-
-void SSD1306_send_buf(const uint8_t *buf, int buflen) {
-    // in horizontal addressing mode, the column address pointer auto-increments
-    // and then wraps around to the next page, so we can send the entire frame
-    // buffer in one gooooooo!
-
-    // copy our frame buffer into a new buffer because we need to add the control byte
-    // to the beginning
-
-    uint8_t * temp_buf = (uint8_t *)malloc(buflen + 1);
-
-    temp_buf[0] = 0x40;
-    memcpy(temp_buf+1, buf, buflen);
-
-    i2c_write_blocking(i2c_default, SSD1306_I2C_ADDR, temp_buf, buflen + 1, false);
-
-    free(temp_buf);
+template <class Panel>
+void SSD1306<Panel>::sendCmds(const uint8_t *buf, int num) {
+    // send a list of commands in a single transaction
+    // Co = 0, D/C = 0 => every following byte is a command
+    uint8_t temp_buf[32];
+    if (num > (int)sizeof(temp_buf) - 1)
+        num = sizeof(temp_buf) - 1;
+
+    temp_buf[0] = 0x00;
+    memcpy(temp_buf+1, buf, num);
+    i2c_bus_write(_i2c, Panel::i2c_addr, temp_buf, num + 1, false);
 }
 
 // int64_t ssd1306_enable_render_dma(alarm_id_t id, __unused void *user_data) {
@@ -143,10 +138,10 @@ void SSD1306_send_buf(const uint8_t *buf, int buflen) {
 //     // set initial values of the oled_buffer, these always need to be sent before the actual data
 //     oled_buffer[0] = (SSD1306_SET_COL_ADDR    << 8) | 0x80;
 //     oled_buffer[1] = (0                       << 8) | 0x80;
-//     oled_buffer[2] = ((SSD1306_WIDTH - 1)     << 8) | 0x80;
+//     oled_buffer[2] = ((WIDTH - 1)     << 8) | 0x80;
 //     oled_buffer[3] = (SSD1306_SET_PAGE_ADDR   << 8) | 0x80;
 //     oled_buffer[4] = (0                       << 8) | 0x80;
-//     oled_buffer[5] = ((SSD1306_NUM_PAGES - 1) << 8) | 0x80;
+//     oled_buffer[5] = ((NUM_PAGES - 1) << 8) | 0x80;
 //     oled_buffer[6] = 0x40;  // data start signal
 //     // vmu bank number area
 //     for (int y = 0; y < 2; y++)
@@ -174,75 +169,221 @@ void SSD1306_send_buf(const uint8_t *buf, int buflen) {
 //                           false);
 // }
 
-void renderArea(const uint8_t *buf, uint8_t colStart, uint8_t colEnd, uint8_t pageStart, uint8_t pageEnd)
+template <class Panel>
+void SSD1306<Panel>::markDirty(uint8_t colStart, uint8_t colEnd, uint8_t pageStart, uint8_t pageEnd)
+{
+    if (!_dirty)
+    {
+        _dirty = true;
+        _dirty_col_start = colStart;
+        _dirty_col_end = colEnd;
+        _dirty_page_start = pageStart;
+        _dirty_page_end = pageEnd;
+        return;
+    }
+    if (colStart < _dirty_col_start) _dirty_col_start = colStart;
+    if (colEnd > _dirty_col_end) _dirty_col_end = colEnd;
+    if (pageStart < _dirty_page_start) _dirty_page_start = pageStart;
+    if (pageEnd > _dirty_page_end) _dirty_page_end = pageEnd;
+}
+
+template <class Panel>
+void SSD1306<Panel>::flushArea(uint8_t colStart, uint8_t colEnd, uint8_t pageStart, uint8_t pageEnd)
+{
+    // pages outside the driven band, or anything while the panel is off, are only sent
+    // once they become visible again
+    uint8_t bandEnd = _band_start + _band_pages - 1;
+    if (!_display_on || pageStart < _band_start || pageEnd > bandEnd)
+        markDirty(colStart, colEnd, pageStart, pageEnd);
+    if (!_display_on)
+        return;
+
+    if (pageStart < _band_start) pageStart = _band_start;
+    if (pageEnd > bandEnd) pageEnd = bandEnd;
+    if (pageStart > pageEnd)
+        return;
+
+    // the frame buffer is in logical columns, the panel RAM may have been content scrolled by
+    // the pixel shift, wrapping columns around the right edge
+    uint8_t physStart = (colStart + _col_shift) % WIDTH;
+    uint8_t width = colEnd - colStart + 1;
+    if (physStart + width > WIDTH)
+    {
+        uint8_t first = WIDTH - physStart;
+        sendWindow(physStart, colStart, first, pageStart, pageEnd);
+        sendWindow(0, colStart + first, width - first, pageStart, pageEnd);
+    }
+    else
+    {
+        sendWindow(physStart, colStart, width, pageStart, pageEnd);
+    }
+}
+
+template <class Panel>
+void SSD1306<Panel>::sendWindow(uint8_t physCol, uint8_t col, uint8_t width, uint8_t pageStart, uint8_t pageEnd)
 {
+    waitScrollSettled();
+
     // update a portion of the display with a render area
     uint8_t cmds[] = {
         SSD1306_SET_COL_ADDR,
-        colStart,
-        colEnd,
+        physCol,
+        (uint8_t)(physCol + width - 1),
         SSD1306_SET_PAGE_ADDR,
         pageStart,
         pageEnd
     };
-    SSD1306_send_cmd_list(cmds, count_of(cmds));
-    SSD1306_send_buf(buf, renderAreaBufLen(colStart, colEnd, pageStart, pageEnd));
+    sendCmds(cmds, count_of(cmds));
+
+    // gather the window out of the frame buffer behind the data control byte
+    uint8_t * p = tx_buffer;
+    *p++ = 0x40;
+    for (uint8_t page = pageStart; page <= pageEnd; page++)
+    {
+        memcpy(p, &oled_buffer[page * WIDTH + col], width);
+        p += width;
+    }
+    i2c_bus_write(_i2c, Panel::i2c_addr, tx_buffer,
+                       renderAreaBufLen(physCol, physCol + width - 1, pageStart, pageEnd) + 1, false);
+    countRegionBytes(col, width, pageStart, pageEnd);
+}
+
+template <class Panel>
+void SSD1306<Panel>::clearBelowPanel()
+{
+    // the RAM pages past the panel, a page at a time as the transmit buffer may hold less
+    static_assert(BUF_LEN >= 128, "a RAM page doesn't fit the transmit buffer");
+    uint8_t * p = tx_buffer;
+    *p++ = 0x40;
+    memset(p, 0x00, 128);
+    for (uint8_t page = NUM_PAGES; page < 8; page++)
+    {
+        uint8_t cmds[] = {
+            SSD1306_SET_COL_ADDR,
+            0,
+            127,
+            SSD1306_SET_PAGE_ADDR,
+            page,
+            page
+        };
+        sendCmds(cmds, count_of(cmds));
+        i2c_bus_write(_i2c, Panel::i2c_addr, tx_buffer, 128 + 1, false);
+    }
+}
+
+template <class Panel>
+void SSD1306<Panel>::countRegionBytes(uint8_t col, uint8_t width, uint8_t pageStart, uint8_t pageEnd)
+{
+    // regions don't overlap, what none of them covers is counted once as the rest
+    uint32_t rest = renderAreaBufLen(col, col + width - 1, pageStart, pageEnd);
+    for (int i = 0; i < ScreenLayout::count; i++)
+    {
+        const Region & r = Panel::layout[i];
+        int w = (col + width < r.col + r.width ? col + width : r.col + r.width) - (col > r.col ? col : r.col);
+        int h = (pageEnd < r.pageEnd() ? pageEnd : r.pageEnd()) - (pageStart > r.page ? pageStart : r.page) + 1;
+        if (r.empty() || w <= 0 || h <= 0)
+            continue;
+        _region_bytes[i] += w * h;
+        rest -= w * h;
+    }
+    _region_bytes[ScreenLayout::count] += rest;
+}
+
+template <class Panel>
+void SSD1306<Panel>::waitScrollSettled()
+{
+    if (!time_reached(_scroll_settle))
+        sleep_until(_scroll_settle);
 }
 
-void SSD1306::render()
+template <class Panel>
+void SSD1306<Panel>::flushDirty()
 {
-    renderArea(oled_buffer, 0, 127, 0, 7);
+    if (!_dirty)
+        return;
+
+    _dirty = false;
+    flushArea(_dirty_col_start, _dirty_col_end, _dirty_page_start, _dirty_page_end);
 }
 
-void renderDigit(uint8_t digit, uint8_t colStart, uint8_t colEnd)
+template <class Panel>
+void SSD1306<Panel>::renderArea(const uint8_t *buf, uint8_t colStart, uint8_t colEnd, uint8_t pageStart, uint8_t pageEnd)
 {
-    uint8_t pageStart = 0;
-    uint8_t pageEnd = 3;
-    switch (digit)
+    // copy the render area into the frame buffer, then send that window to the display
+    uint8_t width = colEnd - colStart + 1;
+    for (uint8_t page = pageStart; page <= pageEnd; page++)
     {
-        case 0:
-            renderArea(oled_zero, colStart, colEnd, pageStart, pageEnd);
-            break;
-        case 1:
-            renderArea(oled_one, colStart, colEnd, pageStart, pageEnd);
-            break;
-        case 2:
-            renderArea(oled_two, colStart, colEnd, pageStart, pageEnd);
-            break;
-        case 3:
-            renderArea(oled_three, colStart, colEnd, pageStart, pageEnd);
-            break;
-        case 4:
-            renderArea(oled_four, colStart, colEnd, pageStart, pageEnd);
-            break;
-        case 5:
-            renderArea(oled_five, colStart, colEnd, pageStart, pageEnd);
-            break;
-        case 6:
-            renderArea(oled_six, colStart, colEnd, pageStart, pageEnd);
-            break;
-        case 7:
-            renderArea(oled_seven, colStart, colEnd, pageStart, pageEnd);
-            break;
-        case 8:
-            renderArea(oled_eight, colStart, colEnd, pageStart, pageEnd);
-            break;
-        case 9:
-            renderArea(oled_nine, colStart, colEnd, pageStart, pageEnd);
-            break;
-        default:
-            break;
+        memcpy(&oled_buffer[page * WIDTH + colStart], buf, width);
+        buf += width;
     }
+    flushArea(colStart, colEnd, pageStart, pageEnd);
+}
+
+template <class Panel>
+void SSD1306<Panel>::render()
+{
+    flushArea(0, WIDTH - 1, 0, NUM_PAGES - 1);
+}
+
+template <class Panel>
+void SSD1306<Panel>::renderGlyph(const oled_glyph_t * g, uint8_t colStart, uint8_t pageStart)
+{
+    // expand straight into the frame buffer, then send that window to the display
+    oled_glyph_decode(g, &oled_buffer[pageStart * WIDTH + colStart], WIDTH);
+    flushArea(colStart, colStart + g->width - 1, pageStart, pageStart + g->pages - 1);
+}
+
+template <class Panel>
+void SSD1306<Panel>::invalidate(const Region & r)
+{
+    if (!r.empty())
+        flushArea(r.col, r.colEnd(), r.page, r.pageEnd());
+}
+
+template <class Panel>
+void SSD1306<Panel>::clearRegion(const Region & r)
+{
+    for (uint8_t page = r.page; page < r.page + r.pages; page++)
+        memset(&oled_buffer[page * WIDTH + r.col], 0x00, r.width);
+    invalidate(r);
+}
+
+template <class Panel>
+void SSD1306<Panel>::renderGlyph(const Region & r, const oled_glyph_t * g)
+{
+    // glyph sizes are only known at run time, the region bounds are checked at compile time
+    if (g->width > r.width || g->pages > r.pages)
+    {
+        TRACE(TRACE_GLYPH_NO_FIT, g->width, g->pages, r.width);
+        return;
+    }
+    if (g->width < r.width || g->pages < r.pages)
+    {
+        for (uint8_t page = r.page; page < r.page + r.pages; page++)
+            memset(&oled_buffer[page * WIDTH + r.col], 0x00, r.width);
+    }
+    oled_glyph_decode(g, &oled_buffer[r.page * WIDTH + r.col], WIDTH);
+    invalidate(r);
+}
+
+template <class Panel>
+void SSD1306<Panel>::renderTimeGlyph(int slot, const Region & r, int glyph)
+{
+    // only regions whose glyph changed go out, a new minute is usually a single digit
+    if (_time_glyphs[slot] == glyph)
+        return;
+    _time_glyphs[slot] = glyph;
+
+    if (glyph < 0)
+        clearRegion(r);
+    else
+        renderGlyph(r, &asset_glyphs()[glyph]);
 }
 
-void SSD1306::renderTime(uint8_t hours, uint8_t minutes)
+template <class Panel>
+void SSD1306<Panel>::renderTime(uint8_t hours, uint8_t minutes)
 {
-    uint8_t empty[64] = {0};
-    uint8_t hour_tens = 59;
-    uint8_t hour_ones = hour_tens + 16;
-    uint8_t colon = hour_ones + 16;
-    uint8_t minute_tens = colon + 4;
-    uint8_t minute_ones = minute_tens + 16;
+    constexpr const ScreenLayout & l = Panel::layout;
 
     // Get AM/PM
     uint8_t hours_ampm;
@@ -253,49 +394,471 @@ void SSD1306::renderTime(uint8_t hours, uint8_t minutes)
     else
         hours_ampm = hours;
 
-    if (hours_ampm / 10)
-        renderDigit(1, hour_tens, hour_tens+15);
-    else
-        renderArea(empty, hour_tens, hour_tens+15, 0, 3);
-    // hour ones
-    renderDigit(hours_ampm % 10, hour_ones, hour_ones+15);
-    // minute tens
-    renderDigit(minutes / 10, minute_tens, minute_tens+15);
-    // minute ones
-    renderDigit(minutes % 10, minute_ones, minute_ones+15);
-    renderArea(oled_colon, colon, colon+3, 0, 3);
-
-    // am/pm
-    if (hours < 12)
-        renderArea(oled_am, 111, 127, 4, 4);
+    renderTimeGlyph(0, l.hour_tens, hours_ampm / 10 ? OLED_GLYPH_ONE : -1);
+    renderTimeGlyph(1, l.hour_ones, OLED_GLYPH_ZERO + hours_ampm % 10);
+    renderTimeGlyph(2, l.colon, OLED_GLYPH_COLON);
+    renderTimeGlyph(3, l.minute_tens, OLED_GLYPH_ZERO + minutes / 10);
+    renderTimeGlyph(4, l.minute_ones, OLED_GLYPH_ZERO + minutes % 10);
+    renderTimeGlyph(5, l.meridiem, hours < 12 ? OLED_GLYPH_AM : OLED_GLYPH_PM);
+}
+
+template <class Panel>
+void SSD1306<Panel>::renderSeconds(uint8_t seconds)
+{
+    // usually only the ones change, tens once every ten seconds
+    renderTimeGlyph(6, Panel::layout.second_tens, OLED_GLYPH_SMALL_ZERO + seconds / 10);
+    renderTimeGlyph(7, Panel::layout.second_ones, OLED_GLYPH_SMALL_ZERO + seconds % 10);
+}
+
+template <class Panel>
+void SSD1306<Panel>::blinkColon(bool on)
+{
+    renderTimeGlyph(2, Panel::layout.colon, on ? OLED_GLYPH_COLON : -1);
+}
+
+template <class Panel>
+void SSD1306<Panel>::hideSeconds()
+{
+    renderTimeGlyph(6, Panel::layout.second_tens, -1);
+    renderTimeGlyph(7, Panel::layout.second_ones, -1);
+    renderTimeGlyph(2, Panel::layout.colon, OLED_GLYPH_COLON);
+}
+
+// progress bar columns, a 5 pixel high outline that fills in, at the top of its page so the
+// rows the pixel shift wraps to the top of the glass stay dark on the last page
+#define PROGRESS_END_COL            _u(0x1F)
+#define PROGRESS_FILLED_COL         _u(0x1F)
+#define PROGRESS_EMPTY_COL          _u(0x11)
+
+template <class Panel>
+void SSD1306<Panel>::renderProgress(uint16_t done, uint16_t total)
+{
+    constexpr const Region & r = Panel::layout.progress;
+    if constexpr (r.empty())
+        return;
     else
-        renderArea(oled_pm, 111, 127, 4, 4);
+    {
+        static_assert(r.pageEnd() < NUM_PAGES - 1 ||
+                      ((PROGRESS_END_COL | PROGRESS_FILLED_COL | PROGRESS_EMPTY_COL) >> (8 - SHIFT_ROWS)) == 0,
+                      "the progress bar reaches into the rows the pixel shift wraps to the top");
+
+        // the first and last column are the ends of the outline
+        constexpr uint8_t inner = r.width - 2;
+        int cols = total == 0 ? 0 : (done >= total ? inner : (uint32_t)done * inner / total);
+        if (cols == _progress_cols)
+            return;
+
+        uint8_t * row = &oled_buffer[r.page * WIDTH + r.col];
+        if (_progress_cols < 0 || cols < _progress_cols)
+        {
+            // first time, or a new night: draw the whole bar
+            row[0] = PROGRESS_END_COL;
+            row[r.width - 1] = PROGRESS_END_COL;
+            for (int c = 0; c < inner; c++)
+                row[1 + c] = c < cols ? PROGRESS_FILLED_COL : PROGRESS_EMPTY_COL;
+            _progress_cols = cols;
+            invalidate(r);
+            return;
+        }
+
+        // only the columns that filled in since the last call
+        for (int c = _progress_cols; c < cols; c++)
+            row[1 + c] = PROGRESS_FILLED_COL;
+        flushArea(r.col + 1 + _progress_cols, r.col + cols, r.page, r.page);
+        _progress_cols = cols;
+    }
+}
+
+template <class Panel>
+void SSD1306<Panel>::hideProgress()
+{
+    if (_progress_cols < 0)
+        return;
+    _progress_cols = -1;
+    clearRegion(Panel::layout.progress);
+}
+
+template <class Panel>
+static const oled_glyph_t * iconGlyph(int i)
+{
+    return &asset_glyphs()[i == SSD1306<Panel>::SUN ? Panel::icon_sun : Panel::icon_moon];
+}
+
+template <class Panel>
+void SSD1306<Panel>::renderIcon(Image i)
+{
+    // the icon only changes with the mode, don't resend it on every pass
+    if (i == _icon)
+        return;
+    _icon = i;
+    _transition_to = -1;
+
+    renderGlyph(Panel::layout.icon, iconGlyph<Panel>(i));
+}
+
+template <class Panel>
+void SSD1306<Panel>::transitionIcon(Image i)
+{
+    if (i == _icon)
+        return;
+
+    // nothing to slide out, nobody to watch it, or a controller that can't do it
+    if (!Panel::content_scroll || _icon < 0 || !_display_on)
+    {
+        renderIcon(i);
+        return;
+    }
+
+    _icon = i;
+    _transition_to = i;
+    _transition_cols = 0;
+    _transition_scrolled = false;
+}
+
+template <class Panel>
+bool SSD1306<Panel>::transitionStep()
+{
+    // transitionIcon() never starts a slide without content scroll, this compiles away then
+    if (!Panel::content_scroll || _transition_to < 0)
+        return false;
+
+    if (!_display_on)
+    {
+        // finish at once, the slide would not be seen
+        _icon = -1;
+        renderIcon(static_cast<Image>(_transition_to));
+        return false;
+    }
+
+    // RAM must not be written while a content scroll is still moving it
+    if (!time_reached(_scroll_settle))
+        return true;
+
+    constexpr const Region & r = Panel::layout.icon;
+    const oled_glyph_t * icon = iconGlyph<Panel>(_transition_to);
+    if (_transition_scrolled)
+    {
+        // the column that wrapped around to the left edge gets the next column of the new icon,
+        // from its right edge inwards
+        uint8_t col = r.width - 1 - _transition_cols;
+        for (uint8_t page = 0; page < r.pages; page++)
+            oled_buffer[(r.page + page) * WIDTH + r.col] = oled_glyph_byte(icon, col, page);
+        flushArea(r.col, r.col, r.page, r.pageEnd());
+
+        _transition_scrolled = false;
+        if (++_transition_cols == r.width)
+        {
+            _transition_to = -1;
+            return false;
+        }
+    }
+
+    // shift the icon area one column right on the controller, and mirror that in the frame buffer
+    uint8_t physStart = (r.col + _col_shift) % WIDTH;
+    uint8_t cmds[] = {
+        SSD1306_CONTENT_SCROLL_RIGHT,
+        0x00,                           // dummy
+        r.page,                         // start page
+        0x01,                           // one column
+        r.pageEnd(),                    // end page
+        physStart,                      // start column
+        (uint8_t)(physStart + r.width - 1), // end column
+    };
+    sendCmds(cmds, count_of(cmds));
+    _scroll_settle = make_timeout_time_ms(SSD1306_SCROLL_SETTLE_MS);
+    _transition_scrolled = true;
+
+    for (uint8_t page = r.page; page <= r.pageEnd(); page++)
+    {
+        uint8_t * row = &oled_buffer[page * WIDTH + r.col];
+        uint8_t wrapped = row[r.width - 1];
+        memmove(row + 1, row, r.width - 1);
+        row[0] = wrapped;
+    }
+
+    return true;
+}
+
+template <class Panel>
+bool SSD1306<Panel>::grayTimer(repeating_timer_t * rt)
+{
+    auto * self = static_cast<SSD1306 *>(rt->user_data);
+    self->_gray_due = true;
+    return true;
+}
 
+template <class Panel>
+void SSD1306<Panel>::startGray(const oled_gray_t * g, uint8_t colStart, uint8_t pageStart)
+{
+    if (g == _gray)
+        return;
+
+    stopGray();
+    _gray = g;
+    _gray_col = colStart;
+    _gray_page = pageStart;
+    _gray_frame = 0;
+    _gray_planes = 0;
+    _gray_stats_start = get_absolute_time();
+    _gray_due = true;
+    add_repeating_timer_us(-GRAY_PLANE_US, grayTimer, this, &_gray_timer);
 }
 
-void SSD1306::renderIcon(Image i)
+template <class Panel>
+void SSD1306<Panel>::stopGray()
 {
-    if (i == SUN)
+    if (_gray == nullptr)
+        return;
+
+    cancel_repeating_timer(&_gray_timer);
+    i2c_bus_wait();
+
+    // leave the most significant plane, the closest 1 bit version of the image
+    const oled_gray_t * g = _gray;
+    _gray = nullptr;
+    uint16_t planeLen = g->width * g->pages;
+    renderArea(&g->planes[(g->bits - 1) * planeLen], _gray_col, _gray_col + g->width - 1,
+               _gray_page, _gray_page + g->pages - 1);
+    // whatever icon was there before is gone
+    _icon = -1;
+}
+
+template <class Panel>
+bool SSD1306<Panel>::grayStep()
+{
+    if (_gray == nullptr)
+        return false;
+
+    // planes are only started from here, never from the timer, so they can't cut into a
+    // transfer of the main loop
+    if (!_gray_due || !_display_on || i2c_bus_busy())
+        return true;
+    _gray_due = false;
+
+    const oled_gray_t * g = _gray;
+    uint16_t planeLen = g->width * g->pages;
+    const uint8_t * plane = &g->planes[g->schedule[_gray_frame] * planeLen];
+    _gray_frame = (_gray_frame + 1) % g->schedule_len;
+
+    // keep the frame buffer in step with the panel
+    uint8_t colEnd = _gray_col + g->width - 1;
+    uint8_t pageEnd = _gray_page + g->pages - 1;
+    for (uint8_t page = 0; page < g->pages; page++)
+        memcpy(&oled_buffer[(_gray_page + page) * WIDTH + _gray_col], &plane[page * g->width], g->width);
+
+    uint8_t physStart = (_gray_col + _col_shift) % WIDTH;
+    if (physStart + g->width > WIDTH || _gray_page < _band_start || pageEnd >= _band_start + _band_pages)
+    {
+        // the window wraps or isn't fully driven, fall back to the blocking path
+        flushArea(_gray_col, colEnd, _gray_page, pageEnd);
+    }
+    else
     {
-        renderArea(oled_sun, 0, 63, 0, 7);
+        waitScrollSettled();
+        uint8_t cmds[] = {
+            SSD1306_SET_COL_ADDR,
+            physStart,
+            (uint8_t)(physStart + g->width - 1),
+            SSD1306_SET_PAGE_ADDR,
+            _gray_page,
+            pageEnd
+        };
+        sendCmds(cmds, count_of(cmds));
+
+        tx_buffer[0] = 0x40;
+        memcpy(tx_buffer + 1, plane, planeLen);
+        if (!i2c_bus_write_dma(_i2c, Panel::i2c_addr, tx_buffer, planeLen + 1))
+            i2c_bus_write(_i2c, Panel::i2c_addr, tx_buffer, planeLen + 1, false);
+        countRegionBytes(_gray_col, g->width, _gray_page, pageEnd);
     }
-    else if (i == MOON)
+
+    // report the achieved plane rate once a second
+    _gray_planes++;
+    int64_t us = absolute_time_diff_us(_gray_stats_start, get_absolute_time());
+    if (us >= 1000000)
+    {
+        [[maybe_unused]] long plane_hz = (long)(_gray_planes * 1000000ll / us);
+        TRACE(TRACE_GRAY_RATE, plane_hz, plane_hz / g->schedule_len, plane_hz / g->schedule_len - FLICKER_FUSION_HZ);
+        _gray_planes = 0;
+        _gray_stats_start = get_absolute_time();
+    }
+    return true;
+}
+
+template <class Panel>
+void SSD1306<Panel>::forgetContent()
+{
+    // blank frame buffer, and nothing cached as drawn so the next render of each part draws it
+    stopGray();
+    memset(oled_buffer, 0x00, sizeof(oled_buffer));
+    _icon = -1;
+    _transition_to = -1;
+    for (int & g : _time_glyphs)
+        g = -1;
+    _progress_cols = -1;
+}
+
+template <class Panel>
+void SSD1306<Panel>::clearScreen()
+{
+    forgetContent();
+    render();
+}
+
+template <class Panel>
+void SSD1306<Panel>::renderNumbers(const uint32_t * values, uint8_t count, uint8_t first_label)
+{
+    forgetContent();
+
+    const oled_glyph_t * digits = &asset_glyphs()[OLED_GLYPH_SMALL_ZERO];
+    const uint8_t w = digits[0].width;
+    for (uint8_t row = 0; row < NUMBER_ROWS && row < count; row++)
     {
-        renderArea(oled_moon, 0, 63, 0, 7);
+        uint8_t * line = &oled_buffer[row * digits[0].pages * WIDTH];
+        oled_glyph_decode(&digits[(first_label + row) % 10], line, WIDTH);
+
+        // right aligned, clear of the pixel shift margin, a gap after the label
+        uint32_t v = values[row];
+        int col = WIDTH - SHIFT_MARGIN - w;
+        do
+        {
+            oled_glyph_decode(&digits[v % 10], line + col, WIDTH);
+            v /= 10;
+            col -= w;
+        } while (v && col >= 2 * w);
     }
+    render();
 }
 
-void SSD1306::setBrightness(uint8_t brightness)
+template <class Panel>
+void SSD1306<Panel>::setBrightness(uint8_t brightness)
 {
     uint8_t cmds[] = {
         SSD1306_SET_CONTRAST,           // set contrast control
         brightness
     };
-    SSD1306_send_cmd_list(cmds, count_of(cmds));
+    sendCmds(cmds, count_of(cmds));
+}
+
+template <class Panel>
+void SSD1306<Panel>::setEntireOn(bool on)
+{
+    sendCmd(SSD1306_SET_ENTIRE_ON | (on ? 0x01 : 0x00));
+}
+
+template <class Panel>
+void SSD1306<Panel>::setDisplayOn(bool on)
+{
+    if (on == _display_on)
+        return;
+
+    if (on)
+    {
+        // bring the panel RAM up to date before it is shown again
+        _display_on = true;
+        flushDirty();
+        sendCmd(SSD1306_SET_DISP | 0x01);
+    }
+    else
+    {
+        sendCmd(SSD1306_SET_DISP | 0x00);
+        _display_on = false;
+    }
+}
+
+template <class Panel>
+void SSD1306<Panel>::setActiveBand(uint8_t page_start, uint8_t num_pages)
+{
+    // Only drive the rows of a band of pages. Lowering the multiplex ratio cuts panel current
+    // roughly in proportion to the rows that are no longer scanned. The band is moved to the
+    // top of the panel with the display start line.
+    if (page_start >= NUM_PAGES)
+        page_start = NUM_PAGES - 1;
+    if (num_pages == 0 || page_start + num_pages > NUM_PAGES)
+        num_pages = NUM_PAGES - page_start;
+    if (page_start == _band_start && num_pages == _band_pages)
+        return;
+
+    // write any content of the newly driven pages first, so nothing stale is ever scanned out
+    _band_start = page_start;
+    _band_pages = num_pages;
+    flushDirty();
+
+    uint8_t cmds[] = {
+        SSD1306_SET_MUX_RATIO,
+        (uint8_t)(num_pages * SSD1306_PAGE_HEIGHT - 1),
+        (uint8_t)(SSD1306_SET_DISP_START_LINE | (page_start * SSD1306_PAGE_HEIGHT)),
+    };
+    sendCmds(cmds, count_of(cmds));
+}
+
+template <class Panel>
+void SSD1306<Panel>::pixelShiftStep()
+{
+    // Walk a snake over a small grid of offsets so that neighbouring positions only ever
+    // differ by one column, which the panel can do by itself with a single content scroll.
+    static const uint8_t orbit[][2] = {
+        {0, 0}, {1, 0}, {2, 0}, {3, 0},
+        {3, 1}, {2, 1}, {1, 1}, {0, 1},
+        {0, 2}, {1, 2}, {2, 2}, {3, 2},
+        {3, 3}, {2, 3}, {1, 3}, {0, 3},
+        {0, 2}, {0, 1},
+    };
+
+    // nothing burns in while the panel is off, and content scrolls need it running
+    if (!_display_on)
+        return;
+
+    // panels with fewer free rows go back and forth on the rows they have
+    _shift_step = (_shift_step + 1) % count_of(orbit);
+    setPixelShift(orbit[_shift_step][0], orbit[_shift_step][1] % (SHIFT_ROWS + 1));
 }
 
-SSD1306::SSD1306(bool rotate_180)
+template <class Panel>
+void SSD1306<Panel>::setPixelShift(uint8_t dx, uint8_t dy)
 {
+    // Vertical moves are free: the display offset remaps the COM lines without touching RAM.
+    // The picture moves down, what comes in at the top are the last rows of the 64 row RAM:
+    // rows the constructor cleared below a shorter panel, or the bottom rows of the frame,
+    // which are kept dark.
+    if (dy != _row_shift)
+    {
+        _row_shift = dy;
+        uint8_t cmds[] = {
+            SSD1306_SET_DISP_OFFSET,
+            (uint8_t)(dy ? 64 - dy : 0),
+        };
+        sendCmds(cmds, count_of(cmds));
+    }
+
+    // Horizontal moves scroll the whole RAM by one column per command, no data is resent.
+    // The frame buffer stays in logical coordinates and flushArea() maps every later
+    // partial update onto the scrolled columns.
+    // Without content scroll only the vertical part of the orbit is used.
+    while (Panel::content_scroll && dx != _col_shift)
+    {
+        bool right = dx > _col_shift;
+        waitScrollSettled();
+        uint8_t cmds[] = {
+            (uint8_t)(right ? SSD1306_CONTENT_SCROLL_RIGHT : SSD1306_CONTENT_SCROLL_LEFT),
+            0x00,                           // dummy
+            0,                              // start page
+            0x01,                           // one column
+            NUM_PAGES - 1,          // end page
+            0,                              // start column
+            WIDTH - 1,              // end column
+        };
+        sendCmds(cmds, count_of(cmds));
+        _scroll_settle = make_timeout_time_ms(SSD1306_SCROLL_SETTLE_MS);
+        _col_shift = right ? _col_shift + 1 : _col_shift - 1;
+    }
+}
+
+template <class Panel>
+SSD1306<Panel>::SSD1306(i2c_inst_t * i2c, bool rotate_180, bool warm)
+{
+    _i2c = i2c;
+
     /// Run through initial chip setup
     // Some of these commands are not strictly necessary as the reset
     // process defaults to some of these but they are shown here
@@ -308,42 +871,76 @@ SSD1306::SSD1306(bool rotate_180)
         0x00,                           // horizontal addressing mode
         /* resolution and layout */
         SSD1306_SET_DISP_START_LINE,    // set display start line to 0
-        (uint8_t)(SSD1306_SET_SEG_REMAP | (rotate_180 ? 0x00 : 0x01)),   // set segment re-map, column address 127 is mapped to SEG0
+        (uint8_t)(SSD1306_SET_SEG_REMAP | (Panel::seg_remap ^ (rotate_180 ? 0x01 : 0x00))), // set segment re-map
         SSD1306_SET_MUX_RATIO,          // set multiplex ratio
-        SSD1306_HEIGHT - 1,             // Display height - 1
-        (uint8_t)(SSD1306_SET_COM_OUT_DIR | (rotate_180 ? 0x00 : 0x08)), // set COM (common) output scan direction. Scan from bottom up, COM[N-1] to COM0
+        Panel::height - 1,              // Display height - 1
+        (uint8_t)(SSD1306_SET_COM_OUT_DIR | (Panel::com_scan ^ (rotate_180 ? 0x08 : 0x00))), // set COM (common) output scan direction
         SSD1306_SET_DISP_OFFSET,        // set display offset
         0x00,                           // no offset
         SSD1306_SET_COM_PIN_CFG,        // set COM (common) pins hardware configuration. Board specific magic number.
-        0x12,                           // 0x02 Works for 128x32, 0x12 Possibly works for 128x64. Other options 0x22, 0x32
+        Panel::com_pins,                // 0x02 for 128x32, 0x12 for 128x64. Other options 0x22, 0x32
         /* timing and driving scheme */
         SSD1306_SET_DISP_CLK_DIV,       // set display clock divide ratio
         0x80,                           // div ratio of 1, standard freq
         SSD1306_SET_PRECHARGE,          // set pre-charge period
-        0xF1,                           // Vcc internally generated on our board
+        Panel::precharge,
         SSD1306_SET_VCOM_DESEL,         // set VCOMH deselect level
-        0x30,                           // 0.83xVcc
+        Panel::vcomh,
         /* display */
         SSD1306_SET_CONTRAST,           // set contrast control
         0xFF,
         SSD1306_SET_ENTIRE_ON,          // set entire display on to follow RAM content
         SSD1306_SET_NORM_DISP,           // set normal (not inverted) display
         SSD1306_SET_CHARGE_PUMP,        // set charge pump
-        0x14,                           // Vcc internally generated on our board
+        Panel::charge_pump,             // Vcc internally generated on our board
         SSD1306_SET_SCROLL | 0x00,      // deactivate horizontal scrolling if set. This is necessary as memory writes will corrupt if scrolling was enabled
         SSD1306_SET_DISP | 0x01, // turn display on
     };
-    SSD1306_send_cmd_list(cmds, count_of(cmds));
-    sleep_ms(50);
-
-    oled_buffer = static_cast<uint8_t *>(malloc(OLED_BUFFER_SIZE));
-    memset(oled_buffer, 0x00, OLED_BUFFER_SIZE);
+    // one transaction instead of one per byte
+    static_assert(sizeof(cmds) < 32, "init sequence is longer than sendCmds() takes");
+    sendCmds(cmds, count_of(cmds));
+    if (!warm)
+        sleep_ms(50);
+
+    // the RAM below a shorter panel is never drawn, but the pixel shift brings its last rows
+    // in at the top
+    if (!warm && SHIFT_ROWS > 0 && NUM_PAGES < 8)
+        clearBelowPanel();
+
+    memset(oled_buffer, 0x00, sizeof(oled_buffer));
+
+    _icon = -1;
+    for (int & g : _time_glyphs)
+        g = -1;     // the frame buffer starts out blank
+    _progress_cols = -1;
+    _display_on = true;
+    _band_start = 0;
+    _band_pages = NUM_PAGES;
+    // the init sequence set no display offset and no content scroll
+    _col_shift = 0;
+    _row_shift = 0;
+    _shift_step = 0;
+    _scroll_settle = get_absolute_time();
+    _transition_to = -1;
+    _transition_cols = 0;
+    _transition_scrolled = false;
+    _gray = nullptr;
+    _gray_due = false;
+    _gray_planes = 0;
+    _dirty = false;
+    for (uint32_t & b : _region_bytes)
+        b = 0;
 
     // First render
-    render();
+    if (!warm)
+        render();
 }
 
-SSD1306::~SSD1306()
+template <class Panel>
+SSD1306<Panel>::~SSD1306()
 {
-    free(oled_buffer);
-}
\ No newline at end of file
+    stopGray();
+}
+
+// only the panel of this build is instantiated
+template class SSD1306<PANEL_PROFILE>;
\ No newline at end of file
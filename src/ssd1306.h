@@ -3,11 +3,12 @@
  *
  * Interface to an SSD1306 OLED display using i2c.
  *
- * SSD1306 is an OLED driver chip for displays of multiple sizes. Here it is assumed the display is
- * 128x64 pixels.
+ * SSD1306 is an OLED driver chip for displays of multiple sizes. The geometry, i2c address and
+ * init values come from a panel profile (see panel_profile.h) chosen at compile time.
  *
- * The default i2c interface is used. SDA -> GPIO 6 (PICO_DEFAULT_I2C_SDA_PIN)
- *                                    SCL -> GPIO 7 (PICO_DEFAULT_I2C_SCL_PIN)
+ * The i2c instance is given to the constructor, set up by the caller. It may be shared with
+ * other targets or be the panel's own bus, see main.cpp. 400 kHz is usual, but these panels
+ * often take more: 1 MHz worked on both the 32 and the 64 pixel high ones.
  *
  * Copyright (c) 2024 Colin Luoma
  *
@@ -20,28 +21,172 @@
 #define SSD1306_H
 
 #include "pico/binary_info.h"
+#include "hardware/i2c.h"
+#include "pico/time.h"
+#include "panel_profile.h"
+extern "C" {
+#include "oled_glyph.h"
+}
 
+template <class Panel>
 class SSD1306
 {
 public:
+    using Profile = Panel;
+    static constexpr uint8_t WIDTH = Panel::width;
+    static constexpr uint8_t NUM_PAGES = Panel::height / 8;
+    static constexpr uint16_t BUF_LEN = WIDTH * NUM_PAGES;
+
+    static_assert(Panel::width <= 128 && Panel::height <= 64, "larger than the controller RAM");
+    static_assert(Panel::height % 8 == 0, "height must be whole pages");
+    // the pixel shift orbit moves content up to 3 columns right, wrapping it around the edge
+    static constexpr uint8_t SHIFT_MARGIN = Panel::content_scroll ? 3 : 0;
+    static_assert(layoutFits(Panel::layout, WIDTH, NUM_PAGES, SHIFT_MARGIN),
+                  "screen regions overlap, leave the panel or the pixel shift margin");
+    // and up to Panel::shift_rows rows down, the last rows of the 64 row controller RAM show
+    // at the top. The driver keeps what it draws out of them, the host test checks the glyphs.
+    static constexpr uint8_t SHIFT_ROWS = Panel::shift_rows;
+    static_assert(SHIFT_ROWS <= 3, "the pixel shift orbit is 4 rows high");
 
     enum Image {
         SUN,
         MOON
      };
 
-    SSD1306(bool rotate_180);
+    // warm = the panel kept its power over a reset of the microcontroller. The init sequence
+    // is still sent but the power up wait and the blank first frame are skipped, the panel
+    // keeps showing the old image until the caller draws over it.
+    SSD1306(i2c_inst_t * i2c, bool rotate_180, bool warm);
     ~SSD1306();
 
     void setBrightness(uint8_t brightness);
 
+    // Panel power control. While the display is off, or while only a band of pages is driven,
+    // drawing still lands in the frame buffer and the unsent area is flushed before it becomes
+    // visible again, so switching back never shows stale content.
+    void setDisplayOn(bool on);
+    // every pixel lit regardless of the RAM content, for the self test
+    void setEntireOn(bool on);
+    bool isDisplayOn() const { return _display_on; }
+    void setActiveBand(uint8_t page_start, uint8_t num_pages);
+
+    // Burn-in protection, moves the whole image one step along a 4x4 pixel orbit without
+    // resending the frame buffer
+    void pixelShiftStep();
+
     void render();
+    void renderArea(const uint8_t *buf, uint8_t colStart, uint8_t colEnd, uint8_t pageStart, uint8_t pageEnd);
+    void renderGlyph(const oled_glyph_t * g, uint8_t colStart, uint8_t pageStart);
+
+    // Drawing by screen region (Panel::layout). A glyph smaller than its region is drawn in the
+    // top left corner with the rest cleared, one that doesn't fit is not drawn at all.
+    void renderGlyph(const Region & r, const oled_glyph_t * g);
+    void clearRegion(const Region & r);
+    // send a region of the frame buffer to the panel
+    void invalidate(const Region & r);
+
+    // Progress bar in the layout's progress region, filled to done/total. Growing the bar only
+    // sends the columns that were added, usually a single byte.
+    void renderProgress(uint16_t done, uint16_t total);
+    void hideProgress();
+
     void renderTime(uint8_t hours, uint8_t minutes);
+
+    // Seconds, either as two small digits or as a blinking colon. Each call sends at most two
+    // small glyph windows, 26-28 bytes each. hideSeconds() clears the digits and puts the
+    // colon back.
+    void renderSeconds(uint8_t seconds);
+    void blinkColon(bool on);
+    void hideSeconds();
     void renderIcon(Image i);
+
+    // Slide the current icon out to the right and the new one in from the left. The
+    // controller does the scrolling, one column per step, and each column of the new icon is
+    // sent exactly once into the column that wrapped around. transitionStep() must be called
+    // from the main loop until it returns false, it never blocks.
+    void transitionIcon(Image i);
+    bool transitionStep();
+    bool isTransitioning() const { return _transition_to >= 0; }
+
+    // Grayscale by temporal dithering, the bit planes of g are cycled through on a timer.
+    // grayStep() must be called from the main loop while it returns true, it starts the next
+    // plane as a DMA transfer and never waits for it. stopGray() leaves the top plane showing.
+    void startGray(const oled_gray_t * g, uint8_t colStart, uint8_t pageStart);
+    void stopGray();
+    bool grayStep();
+    bool isGray() const { return _gray != nullptr; }
     //void renderDMA();
 
+    // Diagnostics page: one number per two page row in the small digits, the row's label digit
+    // on the left and the value right aligned. Takes the whole screen, clearScreen() gives it
+    // back and everything is drawn anew afterwards.
+    void renderNumbers(const uint32_t * values, uint8_t count, uint8_t first_label);
+    void clearScreen();
+    static constexpr uint8_t NUMBER_ROWS = NUM_PAGES / 2;
+
+    // image bytes sent per layout region since boot, index ScreenLayout::count is everything
+    // outside the regions
+    uint32_t regionBytes(int i) const { return _region_bytes[i]; }
+
 private:
-    uint8_t * oled_buffer;
+    void sendCmd(uint8_t cmd);
+    void sendCmds(const uint8_t * buf, int num);
+
+    void renderTimeGlyph(int slot, const Region & r, int glyph);
+    void flushArea(uint8_t colStart, uint8_t colEnd, uint8_t pageStart, uint8_t pageEnd);
+    void sendWindow(uint8_t physCol, uint8_t col, uint8_t width, uint8_t pageStart, uint8_t pageEnd);
+    void clearBelowPanel();
+    void flushDirty();
+    void setPixelShift(uint8_t dx, uint8_t dy);
+    void waitScrollSettled();
+    void markDirty(uint8_t colStart, uint8_t colEnd, uint8_t pageStart, uint8_t pageEnd);
+    void countRegionBytes(uint8_t col, uint8_t width, uint8_t pageStart, uint8_t pageEnd);
+    void forgetContent();
+    static bool grayTimer(repeating_timer_t * rt);
+
+    i2c_inst_t * _i2c;
+    uint8_t oled_buffer[BUF_LEN];
+    // one extra byte for the data control byte
+    uint8_t tx_buffer[BUF_LEN + 1];
+
+    int _icon;
+    // glyph shown in each region of the time, -1 = blank
+    int _time_glyphs[8];
+    // filled columns of the progress bar, -1 = hidden
+    int _progress_cols;
+    bool _display_on;
+    uint8_t _band_start;
+    uint8_t _band_pages;
+
+    uint8_t _col_shift;
+    uint8_t _row_shift;
+    uint8_t _shift_step;
+    absolute_time_t _scroll_settle;
+
+    int _transition_to;
+    uint8_t _transition_cols;
+    bool _transition_scrolled;
+
+    const oled_gray_t * _gray;
+    uint8_t _gray_col;
+    uint8_t _gray_page;
+    uint8_t _gray_frame;
+    volatile bool _gray_due;
+    repeating_timer_t _gray_timer;
+    uint32_t _gray_planes;
+    absolute_time_t _gray_stats_start;
+
+    // bounding box of frame buffer content not yet sent to the panel
+    bool _dirty;
+    uint8_t _dirty_col_start;
+    uint8_t _dirty_col_end;
+    uint8_t _dirty_page_start;
+    uint8_t _dirty_page_end;
+
+    uint32_t _region_bytes[ScreenLayout::count + 1];
 };
 
+// the panel of this build
+using Display = SSD1306<PANEL_PROFILE>;
+
 #endif
@@ -0,0 +1,108 @@
+/**
+ * trace.cpp
+ *
+ * Per core trace rings and the uart drain.
+ */
+
+#include "trace.h"
+
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+#include "pico/platform.h"
+#include "pico/stdlib.h"
+
+// records per core, a power of two
+#define TRACE_RING_RECORDS 256
+
+static_assert((TRACE_RING_RECORDS & (TRACE_RING_RECORDS - 1)) == 0, "ring size must be a power of two");
+static_assert(TRACE_COUNT <= TRACE_CORE1_BIT, "too many tracepoints");
+
+// Each ring has a single writer, its own core, and a single reader, the drain. The counters
+// only ever grow and each is written by one side only: head and dropped by the writer, tail
+// and reported by the drain.
+struct trace_ring_t {
+    trace_record_t records[TRACE_RING_RECORDS];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t dropped;
+    uint32_t reported;
+};
+
+static trace_ring_t rings[NUM_CORES];
+
+void __not_in_flash_func(trace_emit)(trace_id_t id, uint32_t a, uint32_t b, uint32_t c)
+{
+    // interrupt handlers trace too, they are the only other writer on this core
+    uint32_t irq = save_and_disable_interrupts();
+    uint core = get_core_num();
+    trace_ring_t & r = rings[core];
+    uint32_t head = r.head;
+    if (head - r.tail >= TRACE_RING_RECORDS)
+    {
+        r.dropped = r.dropped + 1;
+    }
+    else
+    {
+        trace_record_t & rec = r.records[head & (TRACE_RING_RECORDS - 1)];
+        rec.time_us = time_us_32();
+        rec.id = id | (core ? TRACE_CORE1_BIT : 0);
+        rec.a = a;
+        rec.b = b;
+        rec.c = c;
+        // the record must be complete before the drain on the other core sees it
+        __dmb();
+        r.head = head + 1;
+    }
+    restore_interrupts(irq);
+}
+
+static bool nextRecord(trace_record_t & rec)
+{
+    for (uint core = 0; core < NUM_CORES; core++)
+    {
+        trace_ring_t & r = rings[core];
+
+        // losses are reported ahead of what the ring still holds
+        uint32_t dropped = r.dropped - r.reported;
+        if (dropped)
+        {
+            uint16_t n = dropped > 0xFFFF ? 0xFFFF : dropped;
+            rec = {time_us_32(), (uint16_t)(TRACE_DROPPED | (core ? TRACE_CORE1_BIT : 0)), n, 0, 0};
+            r.reported += n;
+            return true;
+        }
+
+        uint32_t tail = r.tail;
+        if (tail != r.head)
+        {
+            __dmb();
+            rec = r.records[tail & (TRACE_RING_RECORDS - 1)];
+            __dmb();
+            r.tail = tail + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+// The FIFO has no fill level, only an empty flag. An empty FIFO takes a whole frame, so a
+// frame is only started then and always goes out in one piece: printed text, which waits for
+// room, can't end up inside it.
+static_assert(TRACE_FRAME_LEN <= 32, "a frame must fit the empty uart FIFO");
+
+void trace_drain()
+{
+    trace_record_t rec;
+    if (!(uart_get_hw(uart_default)->fr & UART_UARTFR_TXFE_BITS) || !nextRecord(rec))
+        return;
+
+    const uint8_t * bytes = (const uint8_t *)&rec;
+    uint8_t check = 0;
+    uart_putc_raw(uart_default, TRACE_FRAME_START);
+    for (size_t i = 0; i < sizeof(rec); i++)
+    {
+        uart_putc_raw(uart_default, bytes[i]);
+        check ^= bytes[i];
+    }
+    uart_putc_raw(uart_default, check);
+}
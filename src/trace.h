@@ -0,0 +1,91 @@
+/**
+ * trace.h
+ *
+ * Binary event trace. TRACE(id, args...) stores a 16 byte record (timestamp, id, up to three
+ * arguments) in a RAM ring of the calling core, which takes a few dozen cycles and no i/o, so
+ * tracing stays on in release builds. trace_drain() sends the records over the stdio uart from
+ * the main loop, between printed lines and never while a configuration command is coming in,
+ * and tools/trace_decoder turns them back into text and a timeline. The decoder passes the
+ * printed text through; config_protocol.h says how a program talking to the clock skips frames.
+ *
+ * The ids and formats are listed in trace_points.h. The number of arguments is checked against
+ * the format at compile time.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// 0 compiles every TRACE() away
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+// 1 also traces every RTC counter read, ten a second, too many to leave on by default
+#ifndef TRACE_RTC_READS
+#define TRACE_RTC_READS 0
+#endif
+
+enum trace_id_t : uint16_t {
+#define TRACEPOINT(id, format) id,
+#include "trace_points.h"
+#undef TRACEPOINT
+    TRACE_COUNT
+};
+
+struct trace_record_t {
+    uint32_t time_us;   // time_us_32(), wraps after 71 minutes
+    uint16_t id;        // trace_id_t, bit 15 set for core 1
+    uint16_t a;
+    uint32_t b;
+    uint32_t c;
+};
+static_assert(sizeof(trace_record_t) == 16, "trace records are sent as they are in memory");
+
+// on the uart every record is framed by a start byte and an xor of the record bytes
+#define TRACE_FRAME_START  0x1E
+#define TRACE_FRAME_LEN    (1 + sizeof(trace_record_t) + 1)
+#define TRACE_CORE1_BIT    0x8000
+
+void trace_emit(trace_id_t id, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0);
+
+// send the next record if the uart FIFO is empty, never waits for it
+void trace_drain();
+
+constexpr const char * trace_formats[] = {
+#define TRACEPOINT(id, format) format,
+#include "trace_points.h"
+#undef TRACEPOINT
+};
+
+constexpr int trace_arg_count(const char * format)
+{
+    int n = 0;
+    for (; *format; format++)
+    {
+        if (*format != '%')
+            continue;
+        if (format[1] == '%')
+            format++;
+        else
+            n++;
+    }
+    return n;
+}
+
+#define TRACE_NARGS_(_0, _1, _2, _3, n, ...) n
+#define TRACE_NARGS(...) TRACE_NARGS_(0 __VA_OPT__(,) __VA_ARGS__, 3, 2, 1, 0)
+
+#if TRACE_ENABLED
+#define TRACE(id, ...) \
+        do { \
+            static_assert(trace_arg_count(trace_formats[id]) == TRACE_NARGS(__VA_ARGS__), \
+                          "arguments don't match the format of " #id); \
+            trace_emit(id __VA_OPT__(,) __VA_ARGS__); \
+        } while (0)
+#else
+#define TRACE(id, ...) ((void)0)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,30 @@
+/**
+ * trace_points.h
+ *
+ * Every tracepoint of the firmware, with the format the host decoder prints it with. Included
+ * by trace.h for the ids and by tools/trace_decoder for the formats, so both always agree.
+ * New tracepoints go at the end, the ids of recorded traces stay valid then.
+ *
+ * Up to three arguments, the first one 16 bit, all printed as 32 bit ints.
+ */
+
+// TRACEPOINT(id, format)
+TRACEPOINT(TRACE_DROPPED,           "%u trace records dropped, ring full")
+TRACEPOINT(TRACE_RTC_GET_TIME,      "rtc getTime")
+TRACEPOINT(TRACE_RTC_GET_DATE,      "rtc getDate")
+TRACEPOINT(TRACE_RTC_SET_TIME,      "rtc setTime %02u:%02u:%02u")
+TRACEPOINT(TRACE_RTC_SET_DATE,      "rtc setDate %02u-%02u-%02u")
+TRACEPOINT(TRACE_RTC_SET_DATE_TIME, "rtc setDateTime")
+TRACEPOINT(TRACE_RTC_PRINT_TIME,    "rtc printTime")
+TRACEPOINT(TRACE_RTC_GET_EEPROM,    "rtc getEepromRegister 0x%02x")
+TRACEPOINT(TRACE_RTC_SET_EEPROM,    "rtc setEepromRegister 0x%02x = %u")
+TRACEPOINT(TRACE_RTC_SET_OFFSET,    "rtc setOffset %d")
+TRACEPOINT(TRACE_SCHEDULE_LOADED,   "schedule: %u of %u profiles in use")
+TRACEPOINT(TRACE_TODAY,             "today %04u (mmdd): wakeup at minute %u, goto sleep at minute %u")
+TRACEPOINT(TRACE_SECONDS_COST,      "seconds display: %u bytes/s")
+TRACEPOINT(TRACE_GLYPH_NO_FIT,      "glyph %ux%u doesn't fit a region %u wide")
+TRACEPOINT(TRACE_GRAY_RATE,         "gray: %u planes/s, cycle %u Hz, flicker margin %d Hz")
+TRACEPOINT(TRACE_RTC_GET_UNIX,      "rtc getUnixTime")        // only with TRACE_RTC_READS
+TRACEPOINT(TRACE_RTC_SET_UNIX,      "rtc setUnixTime %u")
+TRACEPOINT(TRACE_TZ_OFFSET,         "tz: utc offset %d min, daylight saving %u, until %u")
+TRACEPOINT(TRACE_POWER_PROFILE,     "power: profile %u, sys_clk %u kHz, switch took %u us")
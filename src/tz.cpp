@@ -0,0 +1,289 @@
+/**
+ * tz.cpp
+ *
+ * POSIX TZ rules and the calendar arithmetic for them.
+ */
+
+#include "tz.h"
+
+#include <string.h>
+
+#define SECONDS_PER_DAY     86400
+#define SECONDS_PER_HOUR    3600
+// transitions happen at 02:00 local time unless the rule says otherwise
+#define DEFAULT_CHANGE_TIME (2 * SECONDS_PER_HOUR)
+
+// days since 1970-01-01 of a date in the proleptic Gregorian calendar, H. Hinnant's algorithm
+static int32_t daysFromCivil(int32_t y, uint32_t m, uint32_t d)
+{
+    y -= m <= 2;
+    int32_t era = (y >= 0 ? y : y - 399) / 400;
+    uint32_t yoe = (uint32_t)(y - era * 400);
+    uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+static void civilFromDays(int32_t z, int32_t & y, uint32_t & m, uint32_t & d)
+{
+    z += 719468;
+    int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+    uint32_t doe = (uint32_t)(z - era * 146097);
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = (int32_t)yoe + era * 400 + (m <= 2);
+}
+
+static bool isLeap(int32_t y)
+{
+    return y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+}
+
+uint32_t tz_month_days(int32_t y, uint32_t m)
+{
+    static const uint8_t days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return m == 2 && isLeap(y) ? 29 : days[m - 1];
+}
+
+uint32_t tz_unix(const rv3028::rv3028_date_t & date, const rv3028::rv3028_time_t & time)
+{
+    int32_t days = daysFromCivil(2000 + date.year, date.month, date.date);
+    return (uint32_t)days * SECONDS_PER_DAY + time.hours * SECONDS_PER_HOUR + time.minutes * 60 + time.seconds;
+}
+
+void tz_civil(uint32_t unix_time, rv3028::rv3028_date_t & date, rv3028::rv3028_time_t & time)
+{
+    uint32_t days = unix_time / SECONDS_PER_DAY;
+    uint32_t secs = unix_time % SECONDS_PER_DAY;
+    int32_t y;
+    uint32_t m, d;
+    civilFromDays(days, y, m, d);
+    // 1970-01-01 was a Thursday
+    date = {(uint8_t)((days + 4) % 7), (uint8_t)d, (uint8_t)m, (uint8_t)(y - 2000)};
+    time = {(uint8_t)(secs % 60), (uint8_t)(secs / 60 % 60), (uint8_t)(secs / SECONDS_PER_HOUR)};
+}
+
+// Parsing, each step moves p past what it took and returns false when it doesn't fit
+
+static bool parseNumber(const char *& p, uint32_t max, uint32_t & n)
+{
+    if (*p < '0' || *p > '9')
+        return false;
+    n = 0;
+    while (*p >= '0' && *p <= '9')
+    {
+        n = n * 10 + (*p++ - '0');
+        if (n > max)
+            return false;
+    }
+    return true;
+}
+
+static bool parseName(const char *& p, char (&name)[8])
+{
+    const char * start;
+    size_t len;
+    if (*p == '<')
+    {
+        start = ++p;
+        while (*p && *p != '>')
+            p++;
+        if (*p != '>')
+            return false;
+        len = p++ - start;
+    }
+    else
+    {
+        start = p;
+        while ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z'))
+            p++;
+        len = p - start;
+    }
+    if (len < 3 || len >= sizeof(name))
+        return false;
+    memcpy(name, start, len);
+    name[len] = '\0';
+    return true;
+}
+
+// [+-]hh[:mm[:ss]] in seconds, hours up to max_hours
+static bool parseTime(const char *& p, uint32_t max_hours, int32_t & seconds)
+{
+    bool negative = *p == '-';
+    if (*p == '+' || *p == '-')
+        p++;
+    uint32_t h, m = 0, s = 0;
+    if (!parseNumber(p, max_hours, h))
+        return false;
+    if (*p == ':' && !parseNumber(++p, 59, m))
+        return false;
+    if (*p == ':' && !parseNumber(++p, 59, s))
+        return false;
+    seconds = (int32_t)(h * SECONDS_PER_HOUR + m * 60 + s);
+    if (negative)
+        seconds = -seconds;
+    return true;
+}
+
+static bool parseDay(const char *& p, tz_day_t & day)
+{
+    uint32_t n, w, d;
+    day = {};
+    if (*p == 'M')
+    {
+        p++;
+        if (!parseNumber(p, 12, n) || n < 1 || *p++ != '.' || !parseNumber(p, 5, w) || w < 1 ||
+            *p++ != '.' || !parseNumber(p, 6, d))
+            return false;
+        day.kind = tz_day_t::MONTH_WEEK_DAY;
+        day.month = n;
+        day.week = w;
+        day.weekday = d;
+    }
+    else if (*p == 'J')
+    {
+        p++;
+        if (!parseNumber(p, 365, n) || n < 1)
+            return false;
+        day.kind = tz_day_t::JULIAN_NO_LEAP;
+        day.day = n;
+    }
+    else
+    {
+        if (!parseNumber(p, 365, n))
+            return false;
+        day.kind = tz_day_t::JULIAN;
+        day.day = n;
+    }
+
+    day.time = DEFAULT_CHANGE_TIME;
+    return *p != '/' || parseTime(++p, 167, day.time);
+}
+
+bool tz_parse(const char * spec, tz_rule_t & rule)
+{
+    const char * p = spec;
+    rule = {};
+    int32_t west;
+    if (!parseName(p, rule.std_name) || !parseTime(p, 24, west))
+        return false;
+    rule.std_offset = -west;
+    rule.dst_offset = rule.std_offset;
+    if (*p == '\0')
+        return true;
+
+    if (!parseName(p, rule.dst_name))
+        return false;
+    rule.dst_offset = rule.std_offset + SECONDS_PER_HOUR;
+    if (*p != ',' && *p != '\0')
+    {
+        if (!parseTime(p, 24, west))
+            return false;
+        rule.dst_offset = -west;
+    }
+
+    if (*p == '\0')
+    {
+        // second Sunday of March to first Sunday of November
+        rule.start = {tz_day_t::MONTH_WEEK_DAY, 3, 2, 0, 0, DEFAULT_CHANGE_TIME};
+        rule.end = {tz_day_t::MONTH_WEEK_DAY, 11, 1, 0, 0, DEFAULT_CHANGE_TIME};
+        return true;
+    }
+    return *p++ == ',' && parseDay(p, rule.start) && *p++ == ',' && parseDay(p, rule.end) && *p == '\0';
+}
+
+// Transitions
+
+// days since 1970 of the day a rule picks in year y
+static int32_t ruleDay(const tz_day_t & day, int32_t y)
+{
+    if (day.kind == tz_day_t::JULIAN_NO_LEAP)
+        return daysFromCivil(y, 1, 1) + day.day - 1 + (isLeap(y) && day.day >= 60);
+    if (day.kind == tz_day_t::JULIAN)
+        return daysFromCivil(y, 1, 1) + day.day;
+
+    // the first such weekday of the month, then whole weeks on while still in the month
+    int32_t first = daysFromCivil(y, day.month, 1);
+    uint32_t first_weekday = (uint32_t)((first % 7 + 7 + 4) % 7);
+    uint32_t d = 1 + (day.weekday + 7 - first_weekday) % 7 + (day.week - 1) * 7;
+    while (d > tz_month_days(y, day.month))
+        d -= 7;
+    return first + d - 1;
+}
+
+// UTC of a change, the rule's time counts in the offset in effect before it
+static int64_t changeAt(const tz_day_t & day, int32_t y, int32_t offset_before)
+{
+    return (int64_t)ruleDay(day, y) * SECONDS_PER_DAY + day.time - offset_before;
+}
+
+void tz_init(tz_t & tz, const tz_rule_t & rule)
+{
+    tz.rule = rule;
+    tz.from = 0;
+    tz.until = 0;   // empty, the first conversion works the offset out
+    tz.offset = rule.std_offset;
+    tz.dst = false;
+}
+
+void tz_update(tz_t & tz, uint32_t utc)
+{
+    const tz_rule_t & r = tz.rule;
+    tz.offset = r.std_offset;
+    tz.dst = false;
+    tz.from = 0;
+    tz.until = UINT32_MAX;
+    if (r.dst_name[0] == '\0')
+        return;
+
+    // the changes of the years around utc, the last one before it sets the offset, the first
+    // one after it ends the range; in the southern hemisphere the year starts in daylight saving
+    int32_t y;
+    uint32_t m, d;
+    civilFromDays(utc / SECONDS_PER_DAY, y, m, d);
+    int64_t last = INT64_MIN;
+    int64_t next = INT64_MAX;
+    for (int32_t yy = y - 1; yy <= y + 1; yy++)
+    {
+        int64_t changes[2] = {changeAt(r.start, yy, r.std_offset), changeAt(r.end, yy, r.dst_offset)};
+        for (int i = 0; i < 2; i++)
+        {
+            if (changes[i] <= utc && changes[i] > last)
+            {
+                last = changes[i];
+                tz.dst = i == 0;
+            }
+            else if (changes[i] > utc && changes[i] < next)
+            {
+                next = changes[i];
+            }
+        }
+    }
+    tz.offset = tz.dst ? r.dst_offset : r.std_offset;
+    tz.from = last < 0 ? 0 : (uint32_t)last;
+    tz.until = next > UINT32_MAX ? UINT32_MAX : (uint32_t)next;
+}
+
+uint32_t tz_utc(tz_t & tz, uint32_t local)
+{
+    // standard time first, which settles a repeated hour; in the skipped hour the daylight
+    // saving offset found there gives a UTC time that is still in standard time
+    uint32_t utc = local - tz.rule.std_offset;
+    tz_local(tz, utc);
+    if (!tz.dst)
+        return utc;
+    uint32_t dst_utc = local - tz.rule.dst_offset;
+    tz_local(tz, dst_utc);
+    if (tz.dst)
+        return dst_utc;
+    tz_local(tz, utc);
+    return utc;
+}
+
+const char * tz_name(const tz_t & tz)
+{
+    return tz.dst ? tz.rule.dst_name : tz.rule.std_name;
+}
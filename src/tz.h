@@ -0,0 +1,78 @@
+/**
+ * tz.h
+ *
+ * Local time from UTC. The RTC counts UTC, the zone is a POSIX TZ rule such as
+ * "CET-1CEST,M3.5.0,M10.5.0/3" or "AEST-10AEDT,M10.1.0,M4.1.0/3", parsed once into a tz_rule_t.
+ *
+ * The offset in effect and the range of UTC seconds it holds for, up to the next daylight saving
+ * transition, are worked out once and cached, so converting a reading of the RTC is a compare
+ * and an add; only when the reading leaves the range are the year's transitions computed again.
+ *
+ * Supported: names alphabetic or in <>, offsets [+-]hh[:mm[:ss]], rules Mm.w.d, Jn and n, each
+ * with an optional /time that may be negative or past 24 hours. A zone with a daylight saving
+ * name and no rules follows the US rules, as glibc does. No SDK calls, so it runs on a host.
+ */
+
+#ifndef TZ_H
+#define TZ_H
+
+#include <stdint.h>
+#include "rv3028.h"
+
+// 2000-01-01 00:00:00 UTC, the RTC's calendar starts there
+#define TZ_UNIX_2000 946684800u
+
+struct tz_day_t {
+    enum Kind : uint8_t { MONTH_WEEK_DAY, JULIAN_NO_LEAP, JULIAN } kind;
+    uint8_t month;      // Mm.w.d: 1-12
+    uint8_t week;       // 1-5, 5 = the last one in the month
+    uint8_t weekday;    // 0 = Sunday
+    uint16_t day;       // Jn: 1-365, Feb 29 never counted; n: 0-365
+    int32_t time;       // seconds of local time after midnight that the change happens
+};
+
+struct tz_rule_t {
+    char std_name[8];
+    char dst_name[8];   // empty without daylight saving
+    int32_t std_offset; // seconds east of UTC, the opposite sign of the TZ string
+    int32_t dst_offset;
+    tz_day_t start;     // of daylight saving, in standard time
+    tz_day_t end;       // in daylight saving time
+};
+
+struct tz_t {
+    tz_rule_t rule;
+    // offset holds for UTC seconds from..until - 1
+    uint32_t from;
+    uint32_t until;
+    int32_t offset;
+    bool dst;
+};
+
+// false for a string outside the supported subset
+bool tz_parse(const char * spec, tz_rule_t & rule);
+void tz_init(tz_t & tz, const tz_rule_t & rule);
+// the offset around utc and the range it holds for
+void tz_update(tz_t & tz, uint32_t utc);
+
+static inline uint32_t tz_local(tz_t & tz, uint32_t utc)
+{
+    if (utc - tz.from >= tz.until - tz.from)
+        tz_update(tz, utc);
+    return utc + tz.offset;
+}
+
+// UTC for a local time. A local time that happens twice is taken in standard time, one skipped
+// by the change to daylight saving as if the clock hadn't been put forward yet.
+uint32_t tz_utc(tz_t & tz, uint32_t local);
+// of the offset in effect after the last tz_local() or tz_utc()
+const char * tz_name(const tz_t & tz);
+
+// seconds since 1970 from the RTC's calendar, years 2000-2099, and back; the weekday is
+// worked out from the date with 0 = Sunday
+uint32_t tz_unix(const rv3028::rv3028_date_t & date, const rv3028::rv3028_time_t & time);
+void tz_civil(uint32_t unix_time, rv3028::rv3028_date_t & date, rv3028::rv3028_time_t & time);
+// days in month m (1-12) of the full year y, leap years included
+uint32_t tz_month_days(int32_t y, uint32_t m);
+
+#endif // TZ_H
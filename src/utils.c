@@ -1,9 +0,0 @@
-/**
- * utils.c
- *
- * Collection of utility functions and macros for the pico2maple project.
- *
- * Copyright (c) 2024 Colin Luoma
- */
-
-#include "utils.h"
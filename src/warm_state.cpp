@@ -0,0 +1,53 @@
+/**
+ * warm_state.cpp
+ *
+ * Clock state snapshot in the watchdog scratch registers.
+ */
+
+#include "warm_state.h"
+
+#include "hardware/watchdog.h"
+
+// bumped whenever the layout below changes
+#define WARM_STATE_MAGIC   0x57A20002
+#define WARM_TIME_BITS     11
+#define WARM_TIME_MASK     ((1u << WARM_TIME_BITS) - 1)
+
+static uint32_t check(uint32_t w0, uint32_t w1, uint32_t w2)
+{
+    // power on leaves the scratch registers zero, which must not pass
+    return ~(w0 ^ (w1 << 8 | w1 >> 24) ^ (w2 << 16 | w2 >> 16));
+}
+
+bool warm_state_load(warm_state_t & s)
+{
+    uint32_t w0 = watchdog_hw->scratch[0];
+    uint32_t w1 = watchdog_hw->scratch[1];
+    uint32_t w2 = watchdog_hw->scratch[2];
+    if (w0 != WARM_STATE_MAGIC || watchdog_hw->scratch[3] != check(w0, w1, w2))
+        return false;
+
+    s.wakeup = w1 & WARM_TIME_MASK;
+    s.gotosleep = (w1 >> WARM_TIME_BITS) & WARM_TIME_MASK;
+    s.theme = (w1 >> 22) & 0x0F;
+    s.wakeup_today = w2 & WARM_TIME_MASK;
+    s.gotosleep_today = (w2 >> WARM_TIME_BITS) & WARM_TIME_MASK;
+    s.month = (w2 >> 22) & 0x0F;
+    s.date = (w2 >> 26) & 0x1F;
+    return true;
+}
+
+void warm_state_save(const warm_state_t & s)
+{
+    uint32_t w1 = (s.wakeup & WARM_TIME_MASK) | (uint32_t)(s.gotosleep & WARM_TIME_MASK) << WARM_TIME_BITS |
+                  (uint32_t)(s.theme & 0x0F) << 22;
+    uint32_t w2 = (s.wakeup_today & WARM_TIME_MASK) | (uint32_t)(s.gotosleep_today & WARM_TIME_MASK) << WARM_TIME_BITS |
+                  (uint32_t)(s.month & 0x0F) << 22 | (uint32_t)(s.date & 0x1F) << 26;
+
+    // invalid while it is being written, a reset in between finds no snapshot
+    watchdog_hw->scratch[0] = 0;
+    watchdog_hw->scratch[1] = w1;
+    watchdog_hw->scratch[2] = w2;
+    watchdog_hw->scratch[3] = check(WARM_STATE_MAGIC, w1, w2);
+    watchdog_hw->scratch[0] = WARM_STATE_MAGIC;
+}
@@ -0,0 +1,34 @@
+/**
+ * warm_state.h
+ *
+ * A small snapshot of the clock state kept in the RP2350 watchdog scratch registers, which
+ * survive a watchdog or software reset but not a power cycle. After a warm reset the clock
+ * starts from the snapshot instead of reading the RV3028 EEPROM, and skips the waits that are
+ * only needed when the panel has just been powered.
+ *
+ * Scratch 0-3 are used, 4-7 belong to the boot ROM. The mode and the brightness are not stored,
+ * they follow from the time and today's pair.
+ */
+
+#ifndef WARM_STATE_H
+#define WARM_STATE_H
+
+#include <stdint.h>
+
+struct warm_state_t {
+    // default pair, minutes since midnight
+    uint16_t wakeup;
+    uint16_t gotosleep;
+    // pair in effect on month/date, from the schedule profiles or the defaults
+    uint16_t wakeup_today;
+    uint16_t gotosleep_today;
+    uint8_t month;
+    uint8_t date;
+    uint8_t theme;      // asset_pack.h
+};
+
+// false when there is no valid snapshot, i.e. after power on
+bool warm_state_load(warm_state_t & s);
+void warm_state_save(const warm_state_t & s);
+
+#endif // WARM_STATE_H
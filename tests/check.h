@@ -0,0 +1,41 @@
+/**
+ * check.h
+ *
+ * Assertions for the host tests. A failed check prints where and what and the test goes on,
+ * main() returns check_result() so ctest sees the failure.
+ */
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+inline int check_failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            check_failures++; \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+// compared as long long, printed on a failure
+#define CHECK_EQ(a, b) \
+    do { \
+        long long check_a = (long long)(a), check_b = (long long)(b); \
+        if (check_a != check_b) { \
+            check_failures++; \
+            fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", \
+                    __FILE__, __LINE__, #a, #b, check_a, check_b); \
+        } \
+    } while (0)
+
+inline int check_result()
+{
+    if (check_failures)
+        fprintf(stderr, "%d check(s) failed\n", check_failures);
+    return check_failures ? 1 : 0;
+}
+
+#endif // CHECK_H
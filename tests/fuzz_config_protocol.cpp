@@ -0,0 +1,227 @@
+/**
+ * fuzz_config_protocol.cpp
+ *
+ * Fuzz target for the configuration parser. Built with clang it is a libFuzzer target:
+ *
+ *   CXX=clang++ cmake -S tests -B build-fuzz && cmake --build build-fuzz --target fuzz_config_protocol
+ *   build-fuzz/fuzz_config_protocol -max_len=256
+ *
+ * Otherwise the same target is linked with a driver that runs random inputs made from the
+ * command names, numbers and separators, and replays any files given, under the address and
+ * undefined behaviour sanitizers. ctest runs that.
+ *
+ * Besides not crashing, the parser must hold these on any input:
+ *   - a command only ever ends at '\n', '\r' or ';', and every result is in range
+ *   - no state carries over an end character: each command parses the same with a new parser
+ *   - the parser is idle exactly while only blanks came after the last end character
+ *   - an accepted command has the values strtoull() reads from its text, all of them in range
+ *   - an accepted command printed back and parsed again gives the same result
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "config_protocol.h"
+
+#define FUZZ_ASSERT(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            abort(); \
+        } \
+    } while (0)
+
+static const char * const names[] = {
+    "dt", "alarm", "sched", "stats", "selftest", "log", "theme", "pack", "tz", "power"
+};
+static const bool hex[] = {false, false, true, false, false, false, false, true, false, false};
+
+static bool isEnd(uint8_t c)
+{
+    return c == '\n' || c == '\r' || c == ';';
+}
+
+static bool sameResult(const ConfigParser::Result & a, const ConfigParser::Result & b)
+{
+    if (a.command != b.command || a.error != b.error || a.argc != b.argc)
+        return false;
+    return a.error != ConfigParser::OK || memcmp(a.argv, b.argv, a.argc * sizeof(a.argv[0])) == 0;
+}
+
+// the text of an accepted command, split at blanks, against the C library's reading of it
+static void checkValues(const ConfigParser::Result & r, const uint8_t * text, size_t len)
+{
+    if (r.error != ConfigParser::OK)
+        return;
+    std::string line((const char *)text, len);
+    std::vector<std::string> words;
+    size_t pos = 0;
+    while ((pos = line.find_first_not_of(" \t", pos)) != std::string::npos)
+    {
+        size_t end = line.find_first_of(" \t", pos);
+        words.push_back(line.substr(pos, end - pos));
+        pos = end;
+    }
+    FUZZ_ASSERT(words.size() == 1u + r.argc);
+    FUZZ_ASSERT(words[0] == names[r.command - 1]);
+    for (uint8_t i = 0; i < r.argc; i++)
+    {
+        const std::string & w = words[i + 1];
+        char * end;
+        unsigned long long v = strtoull(w.c_str(), &end, hex[r.command - 1] ? 16 : 10);
+        FUZZ_ASSERT(*end == '\0' && isxdigit((unsigned char)w[0]));
+        FUZZ_ASSERT(v <= UINT32_MAX);
+        FUZZ_ASSERT(v == r.argv[i]);
+    }
+}
+
+static void checkRoundTrip(const ConfigParser::Result & r)
+{
+    if (r.error != ConfigParser::OK)
+        return;
+    std::string line = names[r.command - 1];
+    for (uint8_t i = 0; i < r.argc; i++)
+    {
+        char number[16];
+        snprintf(number, sizeof(number), hex[r.command - 1] ? " %lx" : " %lu", (unsigned long)r.argv[i]);
+        line += number;
+    }
+    line += '\n';
+
+    ConfigParser p;
+    int done = 0;
+    for (char c : line)
+    {
+        if (p.feed(c))
+        {
+            done++;
+            FUZZ_ASSERT(sameResult(p.result(), r));
+        }
+    }
+    FUZZ_ASSERT(done == 1);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size)
+{
+    ConfigParser whole;
+    ConfigParser fresh;
+    size_t start = 0;
+    bool blank = true;
+    for (size_t i = 0; i < size; i++)
+    {
+        bool done = whole.feed((char)data[i]);
+        bool fresh_done = fresh.feed((char)data[i]);
+        FUZZ_ASSERT(done == fresh_done);
+        // idle, and so letting the trace out, only while nothing but blanks followed the last end
+        blank = isEnd(data[i]) || (blank && (data[i] == ' ' || data[i] == '\t'));
+        FUZZ_ASSERT(whole.idle() == blank);
+        if (!done)
+        {
+            if (isEnd(data[i]))
+                start = i + 1;
+            continue;
+        }
+        FUZZ_ASSERT(isEnd(data[i]));
+
+        const ConfigParser::Result & r = whole.result();
+        FUZZ_ASSERT(r.command <= ConfigParser::POWER);
+        FUZZ_ASSERT(r.error <= ConfigParser::ARG_COUNT);
+        FUZZ_ASSERT(r.argc <= ConfigParser::MAX_ARGS);
+        FUZZ_ASSERT((r.command == ConfigParser::NONE) == (r.error == ConfigParser::UNKNOWN_COMMAND));
+        FUZZ_ASSERT(strlen(ConfigParser::errorText(r.error)) > 0);
+        FUZZ_ASSERT(sameResult(r, fresh.result()));
+        checkValues(r, data + start, i - start);
+        checkRoundTrip(r);
+
+        // the next command starts from scratch
+        fresh.reset();
+        start = i + 1;
+    }
+    return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+
+// pieces the random inputs are made of, so that most of them get past the command name
+static const char * const blanks[] = {" ", "  ", "\t"};
+static const char * const ends[] = {";", "\n", "\r\n", "\r"};
+static const char * const numbers[] = {
+    "0", "7", "59", "0700", "ffffffff", "FFFFFFFF", "4294967295", "4294967296", "100000000",
+    "abcdef", "-1", "x",
+};
+static const char * const bad_names[] = {"DT", "selftests", "selftestselftest", "d7", ""};
+
+template <size_t N>
+static const char * pick(const char * const (&list)[N], uint32_t r)
+{
+    return list[r % N];
+}
+
+// commands of up to a dozen values, some of them garbled, and every so often a random byte
+static std::string randomInput(uint32_t & seed)
+{
+    auto next = [&seed]() {
+        // xorshift32, the same sequence on every host
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    };
+    std::string s;
+    uint32_t commands = next() % 6;
+    for (uint32_t i = 0; i < commands; i++)
+    {
+        s += next() % 4 ? "" : pick(blanks, next());
+        s += next() % 8 ? pick(names, next()) : pick(bad_names, next());
+        uint32_t values = next() % 13;
+        for (uint32_t v = 0; v < values; v++)
+        {
+            s += pick(blanks, next());
+            s += pick(numbers, next());
+        }
+        if (next() % 4 == 0)
+            s += pick(blanks, next());
+        if (!s.empty() && next() % 16 == 0)
+            s[next() % s.size()] = (char)next();
+        s += pick(ends, next());
+    }
+    return s;
+}
+
+int main(int argc, char ** argv)
+{
+    // replay the files given, or run the random inputs
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            FILE * f = fopen(argv[i], "rb");
+            if (!f)
+            {
+                fprintf(stderr, "can't open %s\n", argv[i]);
+                return 1;
+            }
+            std::vector<uint8_t> data;
+            int c;
+            while ((c = fgetc(f)) != EOF)
+                data.push_back((uint8_t)c);
+            fclose(f);
+            LLVMFuzzerTestOneInput(data.data(), data.size());
+        }
+        return 0;
+    }
+
+    uint32_t seed = 0x5EED1E55;
+    for (int i = 0; i < 200000; i++)
+    {
+        std::string s = randomInput(seed);
+        LLVMFuzzerTestOneInput((const uint8_t *)s.data(), s.size());
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,18 @@
+/**
+ * hardware/clocks.h
+ *
+ * Host stand-in, clk_sys at the SDK default.
+ */
+
+#ifndef HOST_HARDWARE_CLOCKS_H
+#define HOST_HARDWARE_CLOCKS_H
+
+#include "pico/types.h"
+
+enum clock_num { clk_gpout0, clk_gpout1, clk_gpout2, clk_gpout3, clk_ref, clk_sys, clk_peri, clk_hstx, clk_usb, clk_adc };
+
+#define HOST_SYS_CLK_HZ 150000000u
+
+static inline uint32_t clock_get_hz(enum clock_num clk) { return clk == clk_sys ? HOST_SYS_CLK_HZ : 12000000u; }
+
+#endif // HOST_HARDWARE_CLOCKS_H
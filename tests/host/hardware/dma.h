@@ -0,0 +1,75 @@
+/**
+ * hardware/dma.h
+ *
+ * Host stand-in. The fake i2c bus does its DMA writes at once; the channels here are a model
+ * for paced transfers to a register: host_dma_run() plays what was started, a whole transfer
+ * at a time, then triggers the chained channel and raises the channel's interrupt.
+ */
+
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+#include "pico/types.h"
+
+#define NUM_DMA_CHANNELS 16
+#define NUM_DMA_TIMERS 4
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+typedef struct {
+    enum dma_channel_transfer_size size;
+    bool read_increment;
+    bool write_increment;
+    uint dreq;
+    uint chain_to;
+} dma_channel_config;
+
+// abort: writing starts an abort that is complete at once; ints1: write 1 to clear
+struct host_dma_abort_reg {
+    host_dma_abort_reg & operator=(uint32_t mask);
+    uint32_t operator&(uint32_t mask) const { (void)mask; return 0; }
+};
+struct host_dma_w1c_reg {
+    uint32_t bits;
+    host_dma_w1c_reg & operator=(uint32_t mask) { bits &= ~mask; return *this; }
+    operator uint32_t() const { return bits; }
+};
+typedef struct {
+    host_dma_abort_reg abort;
+    host_dma_w1c_reg ints1;
+} dma_hw_t;
+extern dma_hw_t host_dma_hw;
+#define dma_hw (&host_dma_hw)
+
+int dma_claim_unused_channel(bool required);
+int dma_claim_unused_timer(bool required);
+void dma_channel_unclaim(uint channel);
+void dma_timer_unclaim(uint timer);
+static inline uint dma_get_timer_dreq(uint timer) { return 59 + timer; }
+void dma_timer_set_fraction(uint timer, uint16_t numerator, uint16_t denominator);
+
+static inline dma_channel_config dma_channel_get_default_config(uint channel)
+{
+    return {DMA_SIZE_32, true, false, 0x3F, channel};
+}
+static inline void channel_config_set_transfer_data_size(dma_channel_config * c, enum dma_channel_transfer_size size) { c->size = size; }
+static inline void channel_config_set_read_increment(dma_channel_config * c, bool incr) { c->read_increment = incr; }
+static inline void channel_config_set_write_increment(dma_channel_config * c, bool incr) { c->write_increment = incr; }
+static inline void channel_config_set_dreq(dma_channel_config * c, uint dreq) { c->dreq = dreq; }
+static inline void channel_config_set_chain_to(dma_channel_config * c, uint chain_to) { c->chain_to = chain_to; }
+
+void dma_channel_configure(uint channel, const dma_channel_config * config, volatile void * write_addr,
+                           const volatile void * read_addr, uint transfer_count, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void * read_addr, bool trigger);
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+void dma_channel_set_irq1_enabled(uint channel, bool enabled);
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void * read_addr, uint32_t transfer_count);
+
+// Runs the busy channels to their end, one transfer after the other, calling write for every
+// 32 bit word. Returns the number of transfers completed.
+typedef void (*host_dma_write_t)(volatile void * addr, uint32_t word, void * ctx);
+uint32_t host_dma_run(host_dma_write_t write, void * ctx);
+// the fraction a timer was set to
+void host_dma_timer_fraction(uint timer, uint16_t & numerator, uint16_t & denominator);
+
+#endif // HOST_HARDWARE_DMA_H
@@ -0,0 +1,28 @@
+/**
+ * hardware/flash.h
+ *
+ * Host stand-in: the flash is an array, read through XIP_BASE like on the chip. host_sdk.cpp
+ * implements flash_data_erase() and flash_data_program() on it.
+ */
+
+#ifndef HOST_HARDWARE_FLASH_H
+#define HOST_HARDWARE_FLASH_H
+
+#include "pico/types.h"
+
+#define FLASH_PAGE_SIZE         256u
+#define FLASH_SECTOR_SIZE       4096u
+#ifndef PICO_FLASH_SIZE_BYTES
+#define PICO_FLASH_SIZE_BYTES   (1024u * 1024u)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+#ifdef __cplusplus
+}
+#endif
+#define XIP_BASE ((uintptr_t)host_flash)
+
+#endif // HOST_HARDWARE_FLASH_H
@@ -0,0 +1,25 @@
+/**
+ * hardware/gpio.h
+ *
+ * Host stand-in, pins read as host_gpio_levels sets them.
+ */
+
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+#include "pico/types.h"
+
+enum gpio_function { GPIO_FUNC_I2C = 3, GPIO_FUNC_PWM = 4, GPIO_FUNC_SIO = 5 };
+#define GPIO_IN  false
+#define GPIO_OUT true
+
+extern uint32_t host_gpio_levels;
+static inline void gpio_init(uint pin) { (void)pin; }
+static inline void gpio_set_dir(uint pin, bool out) { (void)pin; (void)out; }
+static inline void gpio_pull_up(uint pin) { (void)pin; }
+static inline void gpio_pull_down(uint pin) { (void)pin; }
+static inline void gpio_set_function(uint pin, enum gpio_function f) { (void)pin; (void)f; }
+static inline bool gpio_get(uint pin) { return host_gpio_levels >> pin & 1; }
+static inline uint32_t gpio_get_all(void) { return host_gpio_levels; }
+
+#endif // HOST_HARDWARE_GPIO_H
@@ -0,0 +1,17 @@
+/**
+ * hardware/i2c.h
+ *
+ * Host stand-in. An instance is any object a test owns, the fake bus (host_i2c.h) routes
+ * transfers on it to the device models attached to it.
+ */
+
+#ifndef HOST_HARDWARE_I2C_H
+#define HOST_HARDWARE_I2C_H
+
+#include "pico/types.h"
+
+typedef struct i2c_inst {
+    int id;
+} i2c_inst_t;
+
+#endif // HOST_HARDWARE_I2C_H
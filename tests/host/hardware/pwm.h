@@ -0,0 +1,58 @@
+/**
+ * hardware/pwm.h
+ *
+ * Host stand-in. The compare registers are plain memory. A slice in PWM_DIV_B_RISING mode
+ * counts the rising edges of a signal the test gives with host_pwm_input(). Reading the counter
+ * takes POLL_US of the fake clock, as a poll loop on the chip takes time too.
+ */
+
+#ifndef HOST_HARDWARE_PWM_H
+#define HOST_HARDWARE_PWM_H
+
+#include "pico/types.h"
+
+#define HOST_PWM_POLL_US 5
+
+enum pwm_chan { PWM_CHAN_A = 0, PWM_CHAN_B = 1 };
+enum pwm_clkdiv_mode { PWM_DIV_FREE_RUNNING, PWM_DIV_B_HIGH, PWM_DIV_B_RISING, PWM_DIV_B_FALLING };
+
+typedef struct {
+    uint32_t csr, div, ctr, cc, top;
+} pwm_slice_hw_t;
+typedef struct {
+    pwm_slice_hw_t slice[8];
+} pwm_hw_t;
+extern pwm_hw_t host_pwm_hw;
+#define pwm_hw (&host_pwm_hw)
+
+typedef struct {
+    enum pwm_clkdiv_mode mode;
+    float div;
+    uint16_t wrap;
+} pwm_config;
+
+// rising edges of the input up to the fake time now_us
+typedef uint64_t (*host_pwm_edges_t)(uint64_t now_us, void * ctx);
+void host_pwm_input(uint slice, host_pwm_edges_t edges, void * ctx);
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) { return (gpio >> 1) & 7; }
+static inline enum pwm_chan pwm_gpio_to_channel(uint gpio) { return (enum pwm_chan)(gpio & 1); }
+static inline pwm_config pwm_get_default_config(void) { return {PWM_DIV_FREE_RUNNING, 1.f, 0xFFFF}; }
+static inline void pwm_config_set_clkdiv_mode(pwm_config * c, enum pwm_clkdiv_mode mode) { c->mode = mode; }
+static inline void pwm_config_set_clkdiv(pwm_config * c, float div) { c->div = div; }
+static inline void pwm_config_set_wrap(pwm_config * c, uint16_t wrap) { c->wrap = wrap; }
+
+// the compare register holds channel A in the low half, B in the high half
+static inline void pwm_set_gpio_level(uint gpio, uint16_t level)
+{
+    uint32_t & cc = host_pwm_hw.slice[pwm_gpio_to_slice_num(gpio)].cc;
+    uint shift = pwm_gpio_to_channel(gpio) == PWM_CHAN_B ? 16 : 0;
+    cc = (cc & ~(0xFFFFu << shift)) | (uint32_t)level << shift;
+}
+
+void pwm_init(uint slice, pwm_config * c, bool start);
+void pwm_set_enabled(uint slice, bool enabled);
+void pwm_set_counter(uint slice, uint16_t c);
+uint16_t pwm_get_counter(uint slice);
+
+#endif // HOST_HARDWARE_PWM_H
@@ -0,0 +1,28 @@
+/**
+ * host_i2c.h
+ *
+ * Fake i2c bus for the host tests. It implements i2c_bus.h: every transfer goes to the device
+ * model attached at that instance and address, a transfer to no device is not acknowledged.
+ * DMA writes are carried out at once.
+ */
+
+#ifndef HOST_I2C_H
+#define HOST_I2C_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hardware/i2c.h"
+
+class HostI2cDevice {
+public:
+    virtual ~HostI2cDevice() = default;
+    // false = not acknowledged
+    virtual bool write(const uint8_t * src, size_t len) = 0;
+    virtual bool read(uint8_t * dst, size_t len) { (void)dst; (void)len; return false; }
+};
+
+// replaces a device attached there before
+void host_i2c_attach(i2c_inst_t * i2c, uint8_t addr, HostI2cDevice * device);
+void host_i2c_detach_all();
+
+#endif // HOST_I2C_H
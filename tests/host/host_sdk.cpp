@@ -0,0 +1,398 @@
+/**
+ * host_sdk.cpp
+ *
+ * The SDK and board services the firmware sources need on the host: the fake clock with its
+ * repeating timers, the fake i2c bus, PWM slices, DMA channels and their interrupts, the flash
+ * array and a trace that records nothing.
+ */
+
+#include <string.h>
+#include <vector>
+
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/pwm.h"
+#include "pico/time.h"
+#include "flash_data.h"
+#include "host_i2c.h"
+#include "i2c_bus.h"
+#include "trace.h"
+
+// clock and timers
+
+static uint64_t now_us;
+static std::vector<repeating_timer_t *> timers;
+
+uint64_t time_us_64(void)
+{
+    return now_us;
+}
+
+void host_time_advance(uint64_t us)
+{
+    uint64_t until = now_us + us;
+    for (;;)
+    {
+        repeating_timer_t * next = nullptr;
+        for (repeating_timer_t * t : timers)
+            if (t->armed && t->next <= until && (!next || t->next < next->next))
+                next = t;
+        if (!next)
+            break;
+        now_us = next->next;
+        // a negative delay counts from the last start, a positive one from the callback's end
+        next->next += next->delay_us < 0 ? -next->delay_us : next->delay_us;
+        if (!next->callback(next))
+            next->armed = false;
+    }
+    now_us = until;
+}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void * user_data, repeating_timer_t * out)
+{
+    out->delay_us = delay_us;
+    out->next = now_us + (delay_us < 0 ? -delay_us : delay_us);
+    out->callback = callback;
+    out->user_data = user_data;
+    out->armed = true;
+    for (repeating_timer_t * t : timers)
+        if (t == out)
+            return true;
+    timers.push_back(out);
+    return true;
+}
+
+bool cancel_repeating_timer(repeating_timer_t * timer)
+{
+    for (size_t i = 0; i < timers.size(); i++)
+    {
+        if (timers[i] == timer)
+        {
+            bool was_armed = timer->armed;
+            timer->armed = false;
+            timers.erase(timers.begin() + i);
+            return was_armed;
+        }
+    }
+    return false;
+}
+
+// i2c
+
+struct attachment {
+    i2c_inst_t * i2c;
+    uint8_t addr;
+    HostI2cDevice * device;
+};
+static std::vector<attachment> devices;
+
+void host_i2c_attach(i2c_inst_t * i2c, uint8_t addr, HostI2cDevice * device)
+{
+    for (attachment & a : devices)
+    {
+        if (a.i2c == i2c && a.addr == addr)
+        {
+            a.device = device;
+            return;
+        }
+    }
+    devices.push_back({i2c, addr, device});
+}
+
+void host_i2c_detach_all()
+{
+    devices.clear();
+}
+
+static HostI2cDevice * find(i2c_inst_t * i2c, uint8_t addr)
+{
+    for (const attachment & a : devices)
+        if (a.i2c == i2c && a.addr == addr)
+            return a.device;
+    return nullptr;
+}
+
+int i2c_bus_write(i2c_inst_t * i2c, uint8_t addr, const uint8_t * src, size_t len, bool nostop)
+{
+    (void)nostop;
+    HostI2cDevice * d = find(i2c, addr);
+    return d && d->write(src, len) ? (int)len : -1;
+}
+
+int i2c_bus_read(i2c_inst_t * i2c, uint8_t addr, uint8_t * dst, size_t len, bool nostop)
+{
+    (void)nostop;
+    HostI2cDevice * d = find(i2c, addr);
+    return d && d->read(dst, len) ? (int)len : -1;
+}
+
+bool i2c_bus_write_dma(i2c_inst_t * i2c, uint8_t addr, const uint8_t * src, size_t len)
+{
+    return i2c_bus_write(i2c, addr, src, len, false) == (int)len;
+}
+
+bool i2c_bus_busy()
+{
+    return false;
+}
+
+void i2c_bus_wait()
+{
+}
+
+// flash, erased at start
+
+uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+
+static struct FlashEraser {
+    FlashEraser() { memset(host_flash, 0xFF, sizeof(host_flash)); }
+} flash_eraser;
+
+bool flash_data_erase(uint32_t offset)
+{
+    memset(&host_flash[offset], 0xFF, FLASH_SECTOR_SIZE);
+    return true;
+}
+
+bool flash_data_program(uint32_t offset, const uint8_t * page)
+{
+    // programming only ever clears bits
+    for (uint32_t i = 0; i < FLASH_PAGE_SIZE; i++)
+        host_flash[offset + i] &= page[i];
+    return true;
+}
+
+// PWM slices counting edges of a test signal
+
+struct pwm_slice {
+    pwm_config config;
+    bool enabled;
+    host_pwm_edges_t edges;
+    void * ctx;
+    // counter value at the edge count base
+    uint16_t counter;
+    uint64_t base;
+};
+static pwm_slice slices[8];
+
+void host_pwm_input(uint slice, host_pwm_edges_t edges, void * ctx)
+{
+    slices[slice].edges = edges;
+    slices[slice].ctx = ctx;
+}
+
+static uint64_t edgesNow(const pwm_slice & s)
+{
+    return s.edges ? s.edges(now_us, s.ctx) : 0;
+}
+
+void pwm_init(uint slice, pwm_config * c, bool start)
+{
+    slices[slice].config = *c;
+    pwm_set_counter(slice, 0);
+    pwm_set_enabled(slice, start);
+}
+
+void pwm_set_enabled(uint slice, bool enabled)
+{
+    pwm_slice & s = slices[slice];
+    if (enabled == s.enabled)
+        return;
+    // a stopped slice keeps its count, edges meanwhile are missed
+    if (enabled)
+        s.base = edgesNow(s);
+    else
+        s.counter = pwm_get_counter(slice);
+    s.enabled = enabled;
+}
+
+void pwm_set_counter(uint slice, uint16_t c)
+{
+    slices[slice].counter = c;
+    slices[slice].base = edgesNow(slices[slice]);
+}
+
+uint16_t pwm_get_counter(uint slice)
+{
+    host_time_advance(HOST_PWM_POLL_US);
+    const pwm_slice & s = slices[slice];
+    if (!s.enabled || s.config.mode != PWM_DIV_B_RISING)
+        return s.counter;
+    return (uint16_t)(s.counter + (edgesNow(s) - s.base));
+}
+
+pwm_hw_t host_pwm_hw;
+
+// DMA channels for paced transfers
+
+struct dma_channel {
+    bool claimed;
+    dma_channel_config config;
+    volatile void * write_addr;
+    const volatile uint32_t * read_addr;
+    uint32_t count;
+    bool irq1;
+    bool busy;
+};
+static dma_channel channels[NUM_DMA_CHANNELS];
+static bool timers_claimed[NUM_DMA_TIMERS];
+static uint16_t timer_fraction[NUM_DMA_TIMERS][2];
+dma_hw_t host_dma_hw;
+
+host_dma_abort_reg & host_dma_abort_reg::operator=(uint32_t mask)
+{
+    for (uint i = 0; i < NUM_DMA_CHANNELS; i++)
+        if (mask & 1u << i)
+            channels[i].busy = false;
+    return *this;
+}
+
+int dma_claim_unused_channel(bool required)
+{
+    (void)required;
+    for (int i = 0; i < NUM_DMA_CHANNELS; i++)
+    {
+        if (!channels[i].claimed)
+        {
+            channels[i].claimed = true;
+            return i;
+        }
+    }
+    return -1;
+}
+
+int dma_claim_unused_timer(bool required)
+{
+    (void)required;
+    for (int i = 0; i < NUM_DMA_TIMERS; i++)
+    {
+        if (!timers_claimed[i])
+        {
+            timers_claimed[i] = true;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel)
+{
+    channels[channel].claimed = false;
+}
+
+void dma_timer_unclaim(uint timer)
+{
+    timers_claimed[timer] = false;
+}
+
+void dma_timer_set_fraction(uint timer, uint16_t numerator, uint16_t denominator)
+{
+    timer_fraction[timer][0] = numerator;
+    timer_fraction[timer][1] = denominator;
+}
+
+void host_dma_timer_fraction(uint timer, uint16_t & numerator, uint16_t & denominator)
+{
+    numerator = timer_fraction[timer][0];
+    denominator = timer_fraction[timer][1];
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config * config, volatile void * write_addr,
+                           const volatile void * read_addr, uint transfer_count, bool trigger)
+{
+    dma_channel & c = channels[channel];
+    c.config = *config;
+    c.write_addr = write_addr;
+    c.read_addr = static_cast<const volatile uint32_t *>(read_addr);
+    c.count = transfer_count;
+    c.busy |= trigger;
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void * read_addr, bool trigger)
+{
+    channels[channel].read_addr = static_cast<const volatile uint32_t *>(read_addr);
+    channels[channel].busy |= trigger;
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger)
+{
+    channels[channel].count = trans_count;
+    channels[channel].busy |= trigger;
+}
+
+void dma_channel_set_irq1_enabled(uint channel, bool enabled)
+{
+    channels[channel].irq1 = enabled;
+}
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void * read_addr, uint32_t transfer_count)
+{
+    channels[channel].read_addr = static_cast<const volatile uint32_t *>(read_addr);
+    channels[channel].count = transfer_count;
+    channels[channel].busy = true;
+}
+
+uint32_t host_dma_run(host_dma_write_t write, void * ctx)
+{
+    uint32_t transfers = 0;
+    for (;;)
+    {
+        int ch = -1;
+        for (int i = 0; i < NUM_DMA_CHANNELS && ch < 0; i++)
+            if (channels[i].busy)
+                ch = i;
+        if (ch < 0)
+            return transfers;
+
+        // only 32 bit words from memory to a fixed register are modelled
+        dma_channel & c = channels[ch];
+        for (uint32_t i = 0; i < c.count; i++)
+            write(c.write_addr, c.read_addr[c.config.read_increment ? i : 0], ctx);
+        c.busy = false;
+        transfers++;
+
+        // the chained channel starts at once, the interrupt comes meanwhile
+        if (c.config.chain_to != (uint)ch)
+            channels[c.config.chain_to].busy = true;
+        if (c.irq1)
+        {
+            host_dma_hw.ints1.bits |= 1u << ch;
+            host_irq_raise(DMA_IRQ_1);
+        }
+    }
+}
+
+// interrupts
+
+static std::vector<irq_handler_t> handlers[64];
+static bool irq_enabled[64];
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority)
+{
+    (void)order_priority;
+    handlers[num].push_back(handler);
+}
+
+void irq_set_enabled(uint num, bool enabled)
+{
+    irq_enabled[num] = enabled;
+}
+
+void host_irq_raise(uint num)
+{
+    if (!irq_enabled[num])
+        return;
+    for (irq_handler_t h : handlers[num])
+        h();
+}
+
+// the rest
+
+uint32_t host_gpio_levels = 0xFFFFFFFF;
+
+void trace_emit(trace_id_t id, uint32_t a, uint32_t b, uint32_t c)
+{
+    (void)id; (void)a; (void)b; (void)c;
+}
@@ -0,0 +1,2 @@
+// host stand-in, nothing to record
+#include "pico/types.h"
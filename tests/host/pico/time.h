@@ -0,0 +1,44 @@
+/**
+ * pico/time.h
+ *
+ * Host stand-in: a fake microsecond clock that only moves when a test or a sleep moves it.
+ * Repeating timers fire from host_time_advance().
+ */
+
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+#include "pico/types.h"
+
+typedef uint64_t absolute_time_t;
+
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t * rt);
+struct repeating_timer {
+    int64_t delay_us;
+    absolute_time_t next;
+    repeating_timer_callback_t callback;
+    void * user_data;
+    bool armed;
+};
+
+uint64_t time_us_64(void);
+static inline uint32_t time_us_32(void) { return (uint32_t)time_us_64(); }
+static inline absolute_time_t get_absolute_time(void) { return time_us_64(); }
+static inline absolute_time_t make_timeout_time_us(uint64_t us) { return time_us_64() + us; }
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) { return time_us_64() + ms * 1000ull; }
+static inline bool time_reached(absolute_time_t t) { return time_us_64() >= t; }
+static inline uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000); }
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) { return (int64_t)(to - from); }
+
+// moves the clock, firing the repeating timers that come due on the way
+void host_time_advance(uint64_t us);
+static inline void sleep_until(absolute_time_t t) { if (t > time_us_64()) host_time_advance(t - time_us_64()); }
+static inline void sleep_us(uint64_t us) { host_time_advance(us); }
+static inline void sleep_ms(uint32_t ms) { host_time_advance(ms * 1000ull); }
+static inline void busy_wait_us(uint64_t us) { host_time_advance(us); }
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void * user_data, repeating_timer_t * out);
+bool cancel_repeating_timer(repeating_timer_t * timer);
+
+#endif // HOST_PICO_TIME_H
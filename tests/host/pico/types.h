@@ -0,0 +1,22 @@
+/**
+ * pico/types.h
+ *
+ * Host stand-in for the few SDK basics the firmware sources use.
+ */
+
+#ifndef HOST_PICO_TYPES_H
+#define HOST_PICO_TYPES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+#define _u(x) x ## u
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#define __unused __attribute__((unused))
+
+static inline void tight_loop_contents(void) {}
+
+#endif // HOST_PICO_TYPES_H
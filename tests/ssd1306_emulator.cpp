@@ -0,0 +1,151 @@
+/**
+ * ssd1306_emulator.cpp
+ *
+ * SSD1306/SSD1309 controller model.
+ */
+
+#include "ssd1306_emulator.h"
+
+#include "pico/time.h"
+
+bool Ssd1306Emulator::write(const uint8_t * src, size_t len)
+{
+    // control byte: Co = 0 and D/C = 1 is a data stream, D/C = 0 a command stream, Co = 1 a
+    // single command byte followed by another control byte
+    size_t i = 0;
+    while (i < len)
+    {
+        uint8_t control = src[i++];
+        bool single = control & 0x80;
+        bool is_data = control & 0x40;
+        size_t end = single ? (i + 1 < len ? i + 1 : len) : len;
+        for (; i < end; i++)
+        {
+            if (is_data)
+            {
+                data(src[i]);
+                continue;
+            }
+            _pending[_pending_len++] = src[i];
+            if (_pending_len == commandLength(_pending[0]))
+            {
+                command(_pending, _pending_len);
+                _pending_len = 0;
+            }
+        }
+    }
+    return true;
+}
+
+size_t Ssd1306Emulator::commandLength(uint8_t c) const
+{
+    switch (c)
+    {
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3: case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+            return 2;
+        case 0x21: case 0x22:
+            return 3;
+        case 0x2C: case 0x2D:
+            return 7;
+        case 0x26: case 0x27:
+            return 7;
+        default:
+            return 1;
+    }
+}
+
+void Ssd1306Emulator::command(const uint8_t * c, size_t n)
+{
+    (void)n;
+    uint8_t op = c[0];
+    if (op >= 0x40 && op <= 0x7F)
+    {
+        _start_line = op & 0x3F;
+        return;
+    }
+    switch (op)
+    {
+        case 0xAE: _on = false; return;
+        case 0xAF: _on = true; return;
+        case 0xA4: _entire_on = false; return;
+        case 0xA5: _entire_on = true; return;
+        case 0xA6: _inverse = false; return;
+        case 0xA7: _inverse = true; return;
+        case 0xA0: case 0xA1: case 0xC0: case 0xC8: case 0x2E: case 0x2F:
+            // the remap and scan direction mirror the glass, the driver sets them once
+            return;
+        case 0x81: _contrast = c[1]; return;
+        case 0xA8: _mux = c[1] & 0x3F; return;
+        case 0xD3: _offset = c[1] & 0x3F; return;
+        case 0xDA: _com_pins = c[1]; return;
+        case 0x20: case 0x8D: case 0xD5: case 0xD9: case 0xDB: case 0x26: case 0x27:
+            return;
+        case 0x21:
+            _col_start = _col = c[1] & 0x7F;
+            _col_end = c[2] & 0x7F;
+            return;
+        case 0x22:
+            _page_start = _page = c[1] & 0x07;
+            _page_end = c[2] & 0x07;
+            return;
+        case 0x2C: case 0x2D:
+            // A dummy, B start page, C one column, D end page, E start column, F end column
+            contentScroll(op == 0x2C, c[2] & 0x07, c[4] & 0x07, c[5] & 0x7F, c[6] & 0x7F);
+            return;
+        default:
+            unknown_commands++;
+            return;
+    }
+}
+
+void Ssd1306Emulator::contentScroll(bool right, uint8_t page_start, uint8_t page_end, uint8_t col_start, uint8_t col_end)
+{
+    scrolls++;
+    _settled_at = time_us_64() + SCROLL_SETTLE_US;
+    for (int p = page_start; p <= page_end; p++)
+    {
+        uint8_t * row = _ram[p];
+        if (right)
+        {
+            uint8_t wrapped = row[col_end];
+            for (int c = col_end; c > col_start; c--)
+                row[c] = row[c - 1];
+            row[col_start] = wrapped;
+        }
+        else
+        {
+            uint8_t wrapped = row[col_start];
+            for (int c = col_start; c < col_end; c++)
+                row[c] = row[c + 1];
+            row[col_end] = wrapped;
+        }
+    }
+}
+
+void Ssd1306Emulator::data(uint8_t b)
+{
+    if (time_us_64() < _settled_at)
+        early_writes++;
+    data_bytes++;
+
+    // horizontal addressing within the window, wrapping to its start
+    _ram[_page][_col] = b;
+    if (_col < _col_end)
+    {
+        _col++;
+        return;
+    }
+    _col = _col_start;
+    _page = _page < _page_end ? _page + 1 : _page_start;
+}
+
+bool Ssd1306Emulator::visible(int x, int y) const
+{
+    // only the first mux + 1 rows are scanned
+    if (!_on || x >= _width || y > _mux || y >= _height)
+        return false;
+    if (_entire_on)
+        return true;
+    int row = (y + _start_line + _offset) % 64;
+    return ramPixel(x, row) != _inverse;
+}
@@ -0,0 +1,69 @@
+/**
+ * ssd1306_emulator.h
+ *
+ * Model of an SSD1306/SSD1309 controller on the fake i2c bus, for the host tests. It keeps the
+ * 128x64 GDDRAM and the commands the driver sends (addressing window, display offset, start
+ * line, multiplex ratio, display on/off, content scroll) and shows what the glass would show.
+ *
+ * A one column content scroll takes a couple of frames on the real controller. A data write
+ * that arrives before it has settled is counted in early_writes, the driver must never do that.
+ */
+
+#ifndef SSD1306_EMULATOR_H
+#define SSD1306_EMULATOR_H
+
+#include <stdint.h>
+#include "host_i2c.h"
+
+class Ssd1306Emulator : public HostI2cDevice {
+public:
+    static constexpr int RAM_WIDTH = 128;
+    static constexpr int RAM_PAGES = 8;
+    // the driver waits 25 ms, two frames at the default clock
+    static constexpr uint64_t SCROLL_SETTLE_US = 20000;
+
+    Ssd1306Emulator(int width, int height) : _width(width), _height(height) {}
+
+    bool write(const uint8_t * src, size_t len) override;
+
+    // the pixel the glass shows at column x, row y, counted from the top left
+    bool visible(int x, int y) const;
+    bool ramPixel(int col, int row) const { return _ram[row / 8][col] >> (row % 8) & 1; }
+
+    bool on() const { return _on; }
+    uint8_t contrast() const { return _contrast; }
+    uint8_t muxRatio() const { return _mux; }
+    uint8_t comPins() const { return _com_pins; }
+
+    // counters since construction
+    uint32_t data_bytes = 0;
+    uint32_t scrolls = 0;
+    uint32_t early_writes = 0;
+    uint32_t unknown_commands = 0;
+
+private:
+    void command(const uint8_t * c, size_t n);
+    size_t commandLength(uint8_t c) const;
+    void data(uint8_t b);
+    void contentScroll(bool right, uint8_t page_start, uint8_t page_end, uint8_t col_start, uint8_t col_end);
+
+    int _width;
+    int _height;
+    uint8_t _ram[RAM_PAGES][RAM_WIDTH] = {};
+    bool _on = false;
+    bool _entire_on = false;
+    bool _inverse = false;
+    uint8_t _contrast = 0x7F;
+    uint8_t _mux = 63;
+    uint8_t _com_pins = 0x12;
+    uint8_t _start_line = 0;
+    uint8_t _offset = 0;
+    uint8_t _col_start = 0, _col_end = RAM_WIDTH - 1, _col = 0;
+    uint8_t _page_start = 0, _page_end = RAM_PAGES - 1, _page = 0;
+    uint64_t _settled_at = 0;
+    // a command whose arguments straddle two transfers
+    uint8_t _pending[8];
+    size_t _pending_len = 0;
+};
+
+#endif // SSD1306_EMULATOR_H
@@ -0,0 +1,162 @@
+/**
+ * test_asset_pack.cpp
+ *
+ * Asset packs uploaded chunk by chunk into the flash model the way the serial port writes them,
+ * and the check that decides whether the firmware draws from them: a good pack loads and draws
+ * its glyphs, a pack with a glyph that doesn't decode to exactly its own pages is refused whole,
+ * also when its CRC is right.
+ */
+
+#include <string.h>
+#include <vector>
+
+#include "asset_pack.h"
+#include "asset_pack_format.h"
+#include "check.h"
+#include "rle.h"
+extern "C" {
+#include "oled_static_data.h"
+}
+
+struct Glyph {
+    uint8_t glyph;
+    uint8_t encoding;
+    std::vector<uint8_t> data;
+    int size_change;            // entry size against the data, to damage the entry
+};
+
+// one theme, laid out as asset_pack_format.h describes
+static std::vector<uint8_t> makePack(const std::vector<Glyph> & glyphs, uint32_t bad_offset = 0)
+{
+    std::vector<uint8_t> pack(sizeof(asset_pack_header_t) + ASSET_PACK_NAME_LEN, 0);
+    strcpy((char *)&pack[sizeof(asset_pack_header_t)], "night");
+
+    size_t entries_at = pack.size();
+    pack.resize(pack.size() + glyphs.size() * sizeof(asset_pack_entry_t));
+    for (size_t i = 0; i < glyphs.size(); i++)
+    {
+        const Glyph & g = glyphs[i];
+        const oled_glyph_t & built_in = oled_glyphs[g.glyph];
+        asset_pack_entry_t e = {(uint32_t)pack.size(), (uint16_t)(g.data.size() + g.size_change), 1, g.glyph,
+                                built_in.width, built_in.pages, g.encoding, 0};
+        if (bad_offset)
+            e.offset = bad_offset;
+        memcpy(&pack[entries_at + i * sizeof(e)], &e, sizeof(e));
+        pack.insert(pack.end(), g.data.begin(), g.data.end());
+    }
+
+    pack.resize((pack.size() + ASSET_PACK_PAGE - 1) / ASSET_PACK_PAGE * ASSET_PACK_PAGE, 0xFF);
+    asset_pack_header_t h = {ASSET_PACK_MAGIC, ASSET_PACK_VERSION, OLED_GLYPH_COUNT, (uint32_t)pack.size(), 0,
+                             (uint16_t)glyphs.size(), 1, 0};
+    h.crc = asset_pack_crc(pack.data() + sizeof(h), pack.size() - sizeof(h));
+    memcpy(pack.data(), &h, sizeof(h));
+    return pack;
+}
+
+static void upload(const std::vector<uint8_t> & pack)
+{
+    for (uint32_t offset = 0; offset < pack.size(); offset += ASSET_PACK_CHUNK)
+        CHECK(asset_pack_write(offset, &pack[offset]));
+}
+
+// a picture of the size of a built-in glyph, different from it
+static std::vector<uint8_t> picture(uint8_t glyph)
+{
+    const oled_glyph_t & g = oled_glyphs[glyph];
+    std::vector<uint8_t> image(g.width * g.pages);
+    for (size_t i = 0; i < image.size(); i++)
+        image[i] = i % g.width < g.width / 3 ? 0xFF : (uint8_t)(i * 37 >> 2);
+    return image;
+}
+
+static std::vector<uint8_t> decoded(const oled_glyph_t & g)
+{
+    std::vector<uint8_t> out(g.width * g.pages);
+    oled_glyph_decode(&g, out.data(), g.width);
+    return out;
+}
+
+static void testGoodPack()
+{
+    const std::vector<uint8_t> moon = picture(OLED_GLYPH_MOON);
+    const std::vector<uint8_t> one = picture(OLED_GLYPH_SMALL_ONE);
+    upload(makePack({
+        {OLED_GLYPH_MOON, OLED_GLYPH_RLE, rleEncode(moon, oled_glyphs[OLED_GLYPH_MOON].width), 0},
+        {OLED_GLYPH_SMALL_ONE, OLED_GLYPH_RAW, one, 0},
+    }));
+
+    CHECK(asset_pack_size() > 0);
+    CHECK_EQ(asset_theme_count(), 2);
+    CHECK(strcmp(asset_theme_name(1), "night") == 0);
+    CHECK(asset_theme_load(1));
+    CHECK_EQ(asset_theme(), 1);
+    CHECK(asset_theme_replaces(OLED_GLYPH_MOON));
+    CHECK(asset_theme_replaces(OLED_GLYPH_SMALL_ONE));
+    CHECK(!asset_theme_replaces(OLED_GLYPH_SUN));
+    CHECK(decoded(asset_glyphs()[OLED_GLYPH_MOON]) == moon);
+    CHECK(decoded(asset_glyphs()[OLED_GLYPH_SMALL_ONE]) == one);
+    CHECK(asset_glyphs()[OLED_GLYPH_SUN].data == oled_glyphs[OLED_GLYPH_SUN].data);
+
+    // back to the built-in artwork
+    CHECK(asset_theme_load(0));
+    CHECK(decoded(asset_glyphs()[OLED_GLYPH_MOON]) == decoded(oled_glyphs[OLED_GLYPH_MOON]));
+}
+
+// a valid CRC over a glyph that would make the decoder read or write where it mustn't
+static void expectRefused(const std::vector<uint8_t> & pack, const char * what)
+{
+    upload(pack);
+    if (asset_pack_size() != 0)
+        fprintf(stderr, "pack accepted: %s\n", what);
+    CHECK_EQ(asset_pack_size(), 0);
+    CHECK_EQ(asset_theme_count(), 1);
+    CHECK(!asset_theme_load(1));
+    CHECK_EQ(asset_theme(), 0);
+    CHECK(asset_glyphs() == oled_glyphs);
+}
+
+static void testBadGlyphs()
+{
+    const uint8_t width = oled_glyphs[OLED_GLYPH_MOON].width;
+    const std::vector<uint8_t> rle = rleEncode(picture(OLED_GLYPH_MOON), width);
+    auto moon = [](std::vector<uint8_t> data, int size_change = 0) {
+        return Glyph{OLED_GLYPH_MOON, OLED_GLYPH_RLE, data, size_change};
+    };
+
+    // the stream ends early, the last token reaching past the entry
+    expectRefused(makePack({moon(rle, -1)}), "entry one byte short");
+    expectRefused(makePack({moon(std::vector<uint8_t>(rle.begin(), rle.end() - 1))}), "last token cut");
+    // bytes left over after the last page
+    std::vector<uint8_t> longer = rle;
+    longer.push_back(0x00);
+    longer.push_back(0x55);
+    expectRefused(makePack({moon(longer)}), "a token past the last page");
+    expectRefused(makePack({moon(rle, 1)}), "entry one byte long");
+
+    // a run across the end of the first page, the same number of bytes in all
+    auto run = [](int n) { return (uint8_t)(OLED_RLE_RUN_FLAG | (n - OLED_RLE_MIN_RUN)); };
+    std::vector<uint8_t> across = {run(width + 2), 0xAA, run(width - 2), 0x55};
+    for (int page = 2; page < oled_glyphs[OLED_GLYPH_MOON].pages; page++)
+        across.insert(across.end(), {run(width), 0});
+    expectRefused(makePack({moon(across)}), "a run across a page");
+
+    // raw glyphs of the wrong size, an unknown encoding
+    std::vector<uint8_t> one = picture(OLED_GLYPH_SMALL_ONE);
+    expectRefused(makePack({{OLED_GLYPH_SMALL_ONE, OLED_GLYPH_RAW, one, -1}}), "raw glyph short");
+    expectRefused(makePack({{OLED_GLYPH_MOON, 2, rle, 0}}), "unknown encoding");
+
+    // an offset that wraps around when the size is added
+    expectRefused(makePack({moon(rle)}, 0xFFFFFFF0), "offset wraps");
+
+    // one bad glyph refuses the whole pack
+    expectRefused(makePack({{OLED_GLYPH_SMALL_ONE, OLED_GLYPH_RAW, one, 0}, moon(rle, -1)}), "second glyph bad");
+}
+
+int main()
+{
+    testGoodPack();
+    testBadGlyphs();
+    // and a good pack after the bad ones
+    testGoodPack();
+    return check_result();
+}
@@ -0,0 +1,542 @@
+/**
+ * test_buttons_pio.cpp
+ *
+ * The button debounce, src/buttons.pio, run by a small interpreter for the PIO instructions it
+ * uses. The program is read from the source file, so the test follows any change to it. Its
+ * pushes are compared with a plain C model of the debounce rule from the file's header, on the
+ * very samples the program took, and checked against the bounce traces that went in: no bounce
+ * may reach the FIFO, glitches shorter than the settle time are never reported, and every real
+ * press or release is reported within the settle time after the contacts come to rest.
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+#define SAMPLE_HZ       1000    // DEBOUNCE_SAMPLE_HZ in button.cpp
+#define CYCLES_PER_SAMPLE 10
+#define CYCLE_US        (1000000.0 / (SAMPLE_HZ * CYCLES_PER_SAMPLE))
+#define PINS_MASK       0xFu    // four buttons
+#define IDLE_LEVELS     0xFu    // pulled up, a press pulls a pin low
+#define FIFO_DEPTH      8       // RX joined
+
+// input levels over time, as a list of changes
+struct Trace {
+    std::vector<std::pair<double, uint32_t>> changes;   // time in us, levels from then on
+
+    uint32_t at(double t) const
+    {
+        uint32_t levels = IDLE_LEVELS;
+        for (const auto & c : changes)
+        {
+            if (c.first > t)
+                break;
+            levels = c.second;
+        }
+        return levels;
+    }
+};
+
+// the PIO program, just the instructions buttons.pio uses
+
+struct Instruction {
+    enum Op { MOV, SET, JMP, PUSH } op;
+    std::string dst, src;       // mov and set operands, the jmp condition
+    uint32_t value;             // set value, jmp target
+    uint32_t delay;
+};
+
+struct Program {
+    std::vector<Instruction> code;
+    uint32_t wrap_target = 0;
+    uint32_t wrap = 0;
+    std::map<std::string, int> defines;
+};
+
+static std::string trim(const std::string & s)
+{
+    size_t a = s.find_first_not_of(" \t\r");
+    size_t b = s.find_last_not_of(" \t\r");
+    return a == std::string::npos ? "" : s.substr(a, b - a + 1);
+}
+
+// numbers, defines, + and - and parentheses
+static int evaluate(const std::string & e, const Program & p, size_t & pos)
+{
+    auto skip = [&]() { while (pos < e.size() && isspace((unsigned char)e[pos])) pos++; };
+    auto term = [&]() -> int {
+        skip();
+        if (e[pos] == '(')
+        {
+            pos++;
+            int v = evaluate(e, p, pos);
+            skip();
+            pos++;  // ')'
+            return v;
+        }
+        size_t start = pos;
+        while (pos < e.size() && (isalnum((unsigned char)e[pos]) || e[pos] == '_'))
+            pos++;
+        std::string word = e.substr(start, pos - start);
+        if (isdigit((unsigned char)word[0]))
+            return (int)strtol(word.c_str(), nullptr, 0);
+        auto d = p.defines.find(word);
+        CHECK(d != p.defines.end());
+        return d == p.defines.end() ? 0 : d->second;
+    };
+    int v = term();
+    for (;;)
+    {
+        skip();
+        if (pos >= e.size() || (e[pos] != '+' && e[pos] != '-'))
+            return v;
+        char op = e[pos++];
+        int t = term();
+        v = op == '+' ? v + t : v - t;
+    }
+}
+
+static int evaluate(const std::string & e, const Program & p)
+{
+    size_t pos = 0;
+    return evaluate(e, p, pos);
+}
+
+static bool load(const char * path, Program & p)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        fprintf(stderr, "can't open %s\n", path);
+        return false;
+    }
+
+    // two passes, jumps may go forward
+    std::vector<std::string> lines;
+    std::map<std::string, uint32_t> labels;
+    bool in_program = false;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        line = trim(line.substr(0, line.find(';')));
+        if (line.empty())
+            continue;
+        if (line.rfind("% c-sdk", 0) == 0)
+            break;
+        if (line.rfind(".program", 0) == 0)
+        {
+            in_program = true;
+            continue;
+        }
+        if (!in_program)
+            continue;
+        if (line.rfind(".define", 0) == 0)
+        {
+            std::istringstream d(line.substr(7));
+            std::string name, value;
+            d >> name >> value;
+            p.defines[name] = evaluate(value, p);
+            continue;
+        }
+        if (line == ".wrap_target")
+        {
+            p.wrap_target = lines.size();
+            continue;
+        }
+        if (line == ".wrap")
+        {
+            p.wrap = lines.size() - 1;
+            continue;
+        }
+        if (line.back() == ':')
+        {
+            labels[line.substr(0, line.size() - 1)] = lines.size();
+            continue;
+        }
+        lines.push_back(line);
+    }
+
+    for (const std::string & l : lines)
+    {
+        Instruction i = {};
+        std::string text = l;
+        size_t bracket = text.find('[');
+        if (bracket != std::string::npos)
+        {
+            i.delay = evaluate(text.substr(bracket + 1, text.find(']') - bracket - 1), p);
+            text = trim(text.substr(0, bracket));
+        }
+        std::string op = text.substr(0, text.find(' '));
+        std::string args = text.find(' ') == std::string::npos ? "" : trim(text.substr(text.find(' ')));
+        std::string first = trim(args.substr(0, args.find(',')));
+        std::string second = args.find(',') == std::string::npos ? "" : trim(args.substr(args.find(',') + 1));
+
+        if (op == "mov")
+        {
+            i.op = Instruction::MOV;
+            i.dst = first;
+            i.src = second;
+        }
+        else if (op == "set")
+        {
+            i.op = Instruction::SET;
+            i.dst = first;
+            i.value = evaluate(second, p);
+            CHECK(i.value < 32);
+        }
+        else if (op == "jmp")
+        {
+            i.op = Instruction::JMP;
+            // jmp [condition][,] target, split at the comma above or else at the space
+            std::string condition, target = second;
+            if (second.empty())
+            {
+                size_t space = first.find(' ');
+                condition = space == std::string::npos ? "" : first.substr(0, space);
+                target = space == std::string::npos ? first : trim(first.substr(space));
+            }
+            else
+                condition = first;
+            i.src = condition;
+            CHECK(labels.count(target));
+            i.value = labels[target];
+        }
+        else if (op == "push" && args == "noblock")
+        {
+            i.op = Instruction::PUSH;
+        }
+        else
+        {
+            fprintf(stderr, "buttons.pio: the model doesn't know \"%s\"\n", l.c_str());
+            return false;
+        }
+        p.code.push_back(i);
+    }
+    return !p.code.empty();
+}
+
+struct Push {
+    double time;
+    uint32_t levels;
+    size_t sample;      // index of the sample that completed it
+};
+
+struct Run {
+    std::vector<double> sample_times;
+    std::vector<uint32_t> samples;
+    std::vector<Push> pushes;
+    uint32_t dropped = 0;
+};
+
+// One state machine, reset state: all registers zero. The reader empties the FIFO within a
+// millisecond, as the interrupt does.
+static Run execute(const Program & p, const Trace & trace, double until_us)
+{
+    Run run;
+    uint32_t x = 0, y = 0, isr = 0, osr = 0;
+    uint32_t pc = 0;
+    uint64_t cycle = 0;
+    std::vector<Push> fifo;
+    double read_at = 0;
+
+    auto reg = [&](const std::string & name) -> uint32_t & {
+        static uint32_t none;
+        if (name == "x") return x;
+        if (name == "y") return y;
+        if (name == "isr") return isr;
+        if (name == "osr") return osr;
+        fprintf(stderr, "buttons.pio: the model doesn't know register %s\n", name.c_str());
+        CHECK(false);
+        return none;
+    };
+
+    while (cycle * CYCLE_US < until_us)
+    {
+        double now = cycle * CYCLE_US;
+        if (now >= read_at)
+        {
+            for (const Push & f : fifo)
+                run.pushes.push_back(f);
+            fifo.clear();
+            read_at = now + 1000;
+        }
+
+        const Instruction & i = p.code[pc];
+        uint32_t next = pc == p.wrap ? p.wrap_target : pc + 1;
+        switch (i.op)
+        {
+            case Instruction::MOV:
+            {
+                uint32_t v;
+                if (i.src == "pins")
+                {
+                    v = trace.at(now) & PINS_MASK;
+                    run.sample_times.push_back(now);
+                    run.samples.push_back(v);
+                }
+                else
+                {
+                    v = reg(i.src);
+                }
+                reg(i.dst) = v;
+                break;
+            }
+            case Instruction::SET:
+                reg(i.dst) = i.value;
+                break;
+            case Instruction::JMP:
+            {
+                bool taken;
+                if (i.src.empty()) taken = true;
+                else if (i.src == "x!=y") taken = x != y;
+                else if (i.src == "!x") taken = x == 0;
+                else if (i.src == "!y") taken = y == 0;
+                else if (i.src == "x--") taken = x-- != 0;
+                else if (i.src == "y--") taken = y-- != 0;
+                else
+                {
+                    fprintf(stderr, "buttons.pio: the model doesn't know jmp %s\n", i.src.c_str());
+                    CHECK(false);
+                    taken = false;
+                }
+                if (taken)
+                    next = i.value;
+                break;
+            }
+            case Instruction::PUSH:
+                if (fifo.size() < FIFO_DEPTH)
+                    fifo.push_back({now, isr, run.samples.size() - 1});
+                else
+                    run.dropped++;
+                isr = 0;
+                break;
+        }
+        pc = next;
+        cycle += 1 + i.delay;
+    }
+    for (const Push & f : fifo)
+        run.pushes.push_back(f);
+    return run;
+}
+
+// The rule from the header of buttons.pio: levels that differ from the last reported ones must
+// hold for SETTLE samples in a row before they are reported, any change starts the count again.
+static std::vector<Push> reference(const std::vector<uint32_t> & samples, int settle)
+{
+    std::vector<Push> pushes;
+    uint32_t reported = 0;      // the state machine starts with OSR clear
+    bool settling = false;
+    uint32_t candidate = 0;
+    int count = 0;
+    for (size_t s = 0; s < samples.size(); s++)
+    {
+        if (!settling)
+        {
+            if (samples[s] != reported)
+            {
+                settling = true;
+                candidate = samples[s];
+                count = 0;
+            }
+            continue;
+        }
+        if (samples[s] != candidate)
+        {
+            candidate = samples[s];
+            count = 0;
+            continue;
+        }
+        if (++count < settle)
+            continue;
+        settling = false;
+        reported = candidate;
+        pushes.push_back({0, candidate, s});
+    }
+    return pushes;
+}
+
+// a deterministic random source, the same traces on every host
+struct Random {
+    uint32_t state;
+    uint32_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    double uniform(double lo, double hi) { return lo + (hi - lo) * (next() % 100000) / 100000.0; }
+};
+
+// contact bounce: the pin toggles at shrinking intervals for up to bounce_us, ending at level
+static void bounce(Trace & t, uint32_t & levels, uint32_t bit, bool level, double at, double bounce_us, Random & r)
+{
+    double time = at;
+    double interval = bounce_us / 4;
+    bool contact = level;
+    while (time < at + bounce_us && interval > 20)
+    {
+        levels = contact ? levels | bit : levels & ~bit;
+        t.changes.push_back({time, levels});
+        time += r.uniform(0.2, 1.0) * interval;
+        interval *= 0.7;
+        contact = !contact;
+    }
+    levels = level ? levels | bit : levels & ~bit;
+    t.changes.push_back({time, levels});
+}
+
+struct Intended {
+    double settled;     // contacts at rest from here
+    uint32_t levels;
+};
+
+static void check(const Program & p, const Trace & trace, const std::vector<Intended> & intended, double until_us)
+{
+    const int settle = p.defines.at("SETTLE");
+    Run run = execute(p, trace, until_us);
+    CHECK_EQ(run.dropped, 0);
+
+    // the program reports exactly what the rule says on the samples it took
+    std::vector<Push> expected = reference(run.samples, settle);
+    CHECK_EQ(run.pushes.size(), expected.size());
+    for (size_t i = 0; i < run.pushes.size() && i < expected.size(); i++)
+    {
+        CHECK_EQ(run.pushes[i].levels, expected[i].levels);
+        CHECK_EQ(run.pushes[i].sample, expected[i].sample);
+    }
+
+    // about once a millisecond, exactly while nothing changes
+    size_t regular = 0;
+    for (size_t i = 1; i < run.sample_times.size(); i++)
+    {
+        double gap = run.sample_times[i] - run.sample_times[i - 1];
+        CHECK(gap >= 500 && gap <= 2000);
+        regular += gap == 1000;
+    }
+    CHECK(regular * 10 > run.sample_times.size() * 9);
+
+    // no bounce reaches the FIFO: every report was sampled SETTLE times in a row, and it is
+    // what the pins show
+    for (const Push & push : run.pushes)
+    {
+        CHECK(push.sample + 1 >= (size_t)settle);
+        for (size_t s = push.sample + 1 - settle; s <= push.sample && push.sample + 1 >= (size_t)settle; s++)
+            CHECK_EQ(run.samples[s], push.levels);
+        CHECK_EQ(trace.at(run.sample_times[push.sample]) & PINS_MASK, push.levels);
+    }
+
+    // every intended change is reported in order, once the contacts rest, and nothing else;
+    // a repeat of the reported levels after a glitch changes nothing for the reader
+    std::vector<Push> changes;
+    uint32_t reported = 0;
+    for (const Push & push : run.pushes)
+    {
+        if (push.levels != reported)
+            changes.push_back(push);
+        reported = push.levels;
+    }
+    CHECK_EQ(changes.size(), intended.size());
+    for (size_t i = 0; i < changes.size() && i < intended.size(); i++)
+    {
+        CHECK_EQ(changes[i].levels, intended[i].levels);
+        CHECK(changes[i].time >= intended[i].settled);
+        CHECK(changes[i].time <= intended[i].settled + (settle + 3) * 1000.0);
+    }
+}
+
+// Random presses and releases of the four buttons, chords included, each with up to 8 ms of
+// bounce, and glitches on idle pins shorter than the settle time.
+static void testRandomTraces(const Program & p)
+{
+    const int settle = p.defines.at("SETTLE");
+    Random r = {0xB077045};
+    for (int run = 0; run < 40; run++)
+    {
+        Trace trace;
+        std::vector<Intended> intended = {{0, IDLE_LEVELS}};
+        uint32_t levels = IDLE_LEVELS;
+        double t = 50000;
+        for (int event = 0; event < 30; event++)
+        {
+            uint32_t bit = 1u << (r.next() % 4);
+            if (r.next() % 4 == 0)
+            {
+                // a glitch, too short to count
+                double length = r.uniform(100, (settle - 6) * 1000.0);
+                uint32_t before = levels;
+                levels ^= bit;
+                trace.changes.push_back({t, levels});
+                levels = before;
+                trace.changes.push_back({t + length, levels});
+                t += length + r.uniform(settle * 1000.0 + 5000, 200000);
+                continue;
+            }
+            double bounce_us = r.uniform(0, 8000);
+            bool level = !(levels & bit);
+            bounce(trace, levels, bit, level, t, bounce_us, r);
+            double rest = trace.changes.back().first;
+            // a second button joining before the first one is reported makes a chord, only
+            // the two together are reported
+            if (r.next() % 5 == 0)
+            {
+                uint32_t other = 1u << (r.next() % 4);
+                if (other != bit)
+                {
+                    bounce(trace, levels, other, !(levels & other), rest + r.uniform(0, 3000), r.uniform(0, 3000), r);
+                    rest = trace.changes.back().first;
+                }
+            }
+            intended.push_back({rest, levels});
+            t = rest + r.uniform(settle * 1000.0 + 5000, 1500000);
+        }
+        check(p, trace, intended, t + 100000);
+    }
+}
+
+// Hand written traces in the shape tact switches show on a scope: a short burst of contacts on
+// press, a longer and slower chatter on release, and a press too short to be one.
+static void testBounceShapes(const Program & p)
+{
+    const uint32_t hours = 1u << 0;
+    Trace trace;
+    trace.changes = {
+        // press: 0.9 ms of chatter
+        {100000, IDLE_LEVELS & ~hours}, {100040, IDLE_LEVELS}, {100130, IDLE_LEVELS & ~hours},
+        {100190, IDLE_LEVELS}, {100420, IDLE_LEVELS & ~hours}, {100450, IDLE_LEVELS},
+        {100900, IDLE_LEVELS & ~hours},
+        // release: 6 ms of slower chatter, some of it longer than a sample
+        {400000, IDLE_LEVELS}, {401200, IDLE_LEVELS & ~hours}, {402700, IDLE_LEVELS},
+        {403100, IDLE_LEVELS & ~hours}, {405600, IDLE_LEVELS}, {405800, IDLE_LEVELS & ~hours},
+        {406000, IDLE_LEVELS},
+        // a 20 ms tap with bounce at both ends, not a press
+        {700000, IDLE_LEVELS & ~hours}, {700300, IDLE_LEVELS}, {700500, IDLE_LEVELS & ~hours},
+        {719000, IDLE_LEVELS}, {719400, IDLE_LEVELS & ~hours}, {719600, IDLE_LEVELS},
+    };
+    std::vector<Intended> intended = {
+        {0, IDLE_LEVELS},
+        {100900, IDLE_LEVELS & ~hours},
+        {406000, IDLE_LEVELS},
+    };
+    check(p, trace, intended, 900000);
+}
+
+int main()
+{
+    Program p;
+    CHECK(load(BUTTONS_PIO, p));
+    CHECK(p.defines.count("SETTLE"));
+    if (!check_failures)
+    {
+        testBounceShapes(p);
+        testRandomTraces(p);
+    }
+    return check_result();
+}
@@ -0,0 +1,232 @@
+/**
+ * test_chime.cpp
+ *
+ * The chime synthesis against a floating point rendering of the same tune, and its playback
+ * through the DMA channel model: what reaches the PWM compare register must be the rendered PCM,
+ * sample for sample, and stop at the end of the tune or soon after chime_stop().
+ */
+
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "chime.h"
+#include "check.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/pwm.h"
+
+#define BLOCK           256                         // samples per DMA buffer
+#define ATTACK          (CHIME_SAMPLE_HZ / 200)
+#define BIAS_RAMP       (CHIME_SAMPLE_HZ / 20)
+
+// the PCM as chime.h describes it, computed in double
+static double reference(const chime_t & c, uint32_t t)
+{
+    uint32_t pass = 0;
+    for (uint8_t i = 0; i < c.count; i++)
+        pass += c.notes[i].eighths * CHIME_SAMPLE_HZ / 8;
+    uint32_t length = pass * c.repeats + BIAS_RAMP;
+    if (t >= length)
+        return 0;
+
+    double bias = CHIME_SILENCE;
+    if (t < BIAS_RAMP)
+        bias = floor(CHIME_SILENCE * (double)t / BIAS_RAMP);
+    else if (length - t < BIAS_RAMP)
+        bias = floor(CHIME_SILENCE * (double)(length - t) / BIAS_RAMP);
+    if (pass == 0 || t >= pass * c.repeats)
+        return bias;
+
+    uint32_t tn = t % pass;
+    uint8_t i = 0;
+    while (tn >= c.notes[i].eighths * CHIME_SAMPLE_HZ / 8u)
+        tn -= c.notes[i++].eighths * CHIME_SAMPLE_HZ / 8;
+    const chime_note_t & n = c.notes[i];
+    double len = n.eighths * CHIME_SAMPLE_HZ / 8;
+    double f = 440.0 * pow(2.0, (n.midi - 69) / 12.0);
+    if (n.midi == 0 || f >= CHIME_SAMPLE_HZ / 2)
+        return bias;
+
+    double env = tn < ATTACK ? (double)tn / ATTACK : (len - tn) * (len - tn) / (len * len);
+    double fade_len = c.fade_ms * (CHIME_SAMPLE_HZ / 1000.0);
+    double fade = t < fade_len ? t / fade_len : 1;
+    // a parabola for each half period
+    double cycles = f * tn / CHIME_SAMPLE_HZ;
+    double u = 2 * (cycles - floor(cycles));
+    double w = u < 1 ? 4 * u * (1 - u) : -4 * (u - 1) * (2 - u);
+
+    double v = bias + 128 * w * env * fade * c.volume / 256;
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+static std::vector<uint8_t> render(const chime_t & c, uint32_t first, uint32_t count)
+{
+    std::vector<uint8_t> out(count);
+    chime_render(c, first, out.data(), count);
+    return out;
+}
+
+// every sample of the tune and some past its end, within the rounding of the fixed point
+static void testPcm(const chime_t & c)
+{
+    uint32_t length = chime_length(c);
+    std::vector<uint8_t> pcm = render(c, 0, length + 1000);
+    int worst = 0;
+    uint32_t worst_t = 0;
+    for (uint32_t t = 0; t < pcm.size(); t++)
+    {
+        int d = abs(pcm[t] - (int)lround(reference(c, t)));
+        if (d > worst)
+        {
+            worst = d;
+            worst_t = t;
+        }
+    }
+    if (worst > 2)
+        fprintf(stderr, "sample %u: %u, reference %.2f\n", worst_t, pcm[worst_t], reference(c, worst_t));
+    CHECK(worst <= 2);
+
+    // from 0 up to the speaker rest level and back, nothing after the end
+    CHECK_EQ(pcm[0], 0);
+    CHECK_EQ(pcm[length - 1], 0);
+    for (uint32_t t = length; t < pcm.size(); t++)
+        CHECK_EQ(pcm[t], 0);
+}
+
+static void testLength()
+{
+    // five notes of 28 eighths, four times, and the ramp down
+    CHECK_EQ(chime_length(chime_wakeup), 4 * 28 * CHIME_SAMPLE_HZ / 8 + BIAS_RAMP);
+    static const chime_note_t rest[] = {{0, 3}};
+    CHECK_EQ(chime_length({rest, 1, 2, 100, 0}), 2 * 3 * CHIME_SAMPLE_HZ / 8 + BIAS_RAMP);
+    CHECK_EQ(chime_length({rest, 0, 5, 100, 0}), BIAS_RAMP);
+}
+
+// rendering in blocks of any size gives the same samples as rendering in one go
+static void testBlocks()
+{
+    uint32_t length = chime_length(chime_wakeup);
+    std::vector<uint8_t> whole = render(chime_wakeup, 0, length + BLOCK);
+    for (uint32_t size : {256u, 97u, 1u})
+    {
+        std::vector<uint8_t> pieces;
+        uint32_t end = size == 1 ? 3000 : length + BLOCK;
+        for (uint32_t pos = 0; pos < end; pos += size)
+        {
+            std::vector<uint8_t> b = render(chime_wakeup, pos, size);
+            pieces.insert(pieces.end(), b.begin(), b.end());
+        }
+        pieces.resize(end);
+        CHECK(std::equal(pieces.begin(), pieces.end(), whole.begin()));
+    }
+}
+
+// The compare register written by the DMA channels, a sample per transfer. Optionally stops the
+// chime after stop_after samples.
+struct Speaker {
+    uint pin;
+    std::vector<uint8_t> levels;
+    uint32_t stop_after;
+    bool stopped_playing;
+};
+
+static void speakerWrite(volatile void * addr, uint32_t word, void * ctx)
+{
+    Speaker & s = *static_cast<Speaker *>(ctx);
+    uint shift = pwm_gpio_to_channel(s.pin) == PWM_CHAN_B ? 16 : 0;
+    CHECK(addr == &pwm_hw->slice[pwm_gpio_to_slice_num(s.pin)].cc);
+    // the other half of the register is left at 0
+    CHECK_EQ(word & ~(0xFFu << shift), 0);
+    *static_cast<volatile uint32_t *>(addr) = word;
+    s.levels.push_back(word >> shift);
+    s.stopped_playing |= !chime_playing();
+    if (s.levels.size() == s.stop_after)
+        chime_stop();
+}
+
+// each chime_init() claims the next free DMA timer
+static void testPlayback(uint pin, uint timer)
+{
+    CHECK(chime_init(pin));
+    uint16_t num = 0, den = 0;
+    host_dma_timer_fraction(timer, num, den);
+    CHECK_EQ(num, 1);
+    CHECK_EQ(den, HOST_SYS_CLK_HZ / CHIME_SAMPLE_HZ);
+
+    // the whole tune, then the speaker is let go
+    uint32_t length = chime_length(chime_wakeup);
+    Speaker s = {pin, {}, 0, false};
+    chime_play(chime_wakeup);
+    CHECK(chime_playing());
+    host_dma_run(speakerWrite, &s);
+    CHECK(!chime_playing());
+    CHECK(!s.stopped_playing);
+    CHECK(s.levels.size() >= length);
+    CHECK(s.levels.size() < length + BLOCK);
+    CHECK(s.levels == render(chime_wakeup, 0, s.levels.size()));
+    CHECK_EQ(pwm_hw->slice[pwm_gpio_to_slice_num(pin)].cc, 0);
+
+    // again, stopped halfway: the block playing is the last one
+    uint32_t stop_after = length / 2 + 33;
+    Speaker t = {pin, {}, stop_after, false};
+    chime_play(chime_wakeup);
+    host_dma_run(speakerWrite, &t);
+    CHECK(!chime_playing());
+    CHECK(t.levels.size() >= stop_after);
+    CHECK(t.levels.size() <= stop_after + BLOCK);
+    CHECK(t.levels == render(chime_wakeup, 0, t.levels.size()));
+    CHECK(t.levels.back() != 0);
+    CHECK_EQ(pwm_hw->slice[pwm_gpio_to_slice_num(pin)].cc, 0);
+
+    // and a stop without a chime changes nothing
+    chime_stop();
+    Speaker u = {pin, {}, 0, false};
+    chime_play(chime_wakeup);
+    host_dma_run(speakerWrite, &u);
+    CHECK(u.levels == s.levels);
+}
+
+// with the DMA timers taken, chime_init() fails and leaves the channels it got free
+static void testInitFails()
+{
+    std::vector<int> timers;
+    for (int t; (t = dma_claim_unused_timer(false)) >= 0;)
+        timers.push_back(t);
+
+    int first_free = dma_claim_unused_channel(false);
+    CHECK(first_free >= 0);
+    dma_channel_unclaim(first_free);
+    CHECK(!chime_init(16));
+    CHECK_EQ(dma_claim_unused_channel(false), first_free);
+    CHECK_EQ(dma_claim_unused_channel(false), first_free + 1);
+    dma_channel_unclaim(first_free);
+    dma_channel_unclaim(first_free + 1);
+
+    // nothing plays after the failed init
+    chime_play(chime_wakeup);
+    CHECK(!chime_playing());
+    for (int t : timers)
+        dma_timer_unclaim(t);
+}
+
+int main()
+{
+    testLength();
+    testPcm(chime_wakeup);
+
+    // a rest, a note above the Nyquist frequency, full volume clipping, no fade in
+    static const chime_note_t odd_notes[] = {{0, 1}, {127, 2}, {57, 3}, {69, 1}};
+    testPcm({odd_notes, 4, 2, 255, 0});
+    // a fade in longer than the tune
+    static const chime_note_t short_notes[] = {{72, 2}};
+    testPcm({short_notes, 1, 3, 200, 5000});
+
+    testBlocks();
+    // channel A and channel B of a slice
+    testPlayback(14, 0);
+    testPlayback(3, 1);
+    testInitFails();
+    return check_result();
+}
@@ -0,0 +1,151 @@
+/**
+ * test_config_protocol.cpp
+ *
+ * The configuration command parser, fed a character at a time the way the uart delivers them.
+ */
+
+#include <string.h>
+#include <vector>
+
+#include "check.h"
+#include "config_protocol.h"
+
+using Result = ConfigParser::Result;
+
+static std::vector<Result> parse(ConfigParser & p, const char * text)
+{
+    std::vector<Result> results;
+    for (const char * c = text; *c; c++)
+        if (p.feed(*c))
+            results.push_back(p.result());
+    return results;
+}
+
+static std::vector<Result> parse(const char * text)
+{
+    ConfigParser p;
+    return parse(p, text);
+}
+
+// a single command with the given outcome
+static void expect(const char * text, ConfigParser::Command command, ConfigParser::Error error,
+                   std::vector<uint32_t> args = {})
+{
+    std::vector<Result> r = parse(text);
+    CHECK_EQ(r.size(), 1);
+    if (r.size() != 1)
+    {
+        fprintf(stderr, "  in \"%s\"\n", text);
+        return;
+    }
+    CHECK_EQ(r[0].command, command);
+    CHECK_EQ(r[0].error, error);
+    if (error != ConfigParser::OK)
+        return;
+    CHECK_EQ(r[0].argc, args.size());
+    for (size_t i = 0; i < args.size() && i < ConfigParser::MAX_ARGS; i++)
+        CHECK_EQ(r[0].argv[i], args[i]);
+}
+
+static void testReads()
+{
+    expect("dt\n", ConfigParser::DATE_TIME, ConfigParser::OK);
+    expect("alarm\n", ConfigParser::ALARM, ConfigParser::OK);
+    expect("sched\n", ConfigParser::SCHEDULE, ConfigParser::OK);
+    expect("stats\n", ConfigParser::STATS, ConfigParser::OK);
+    expect("selftest\n", ConfigParser::SELFTEST, ConfigParser::OK);
+    expect("log\n", ConfigParser::LOG, ConfigParser::OK);
+    expect("theme\n", ConfigParser::THEME, ConfigParser::OK);
+    expect("pack\n", ConfigParser::PACK, ConfigParser::OK);
+    expect("tz\n", ConfigParser::TIME_ZONE, ConfigParser::OK);
+    expect("power\n", ConfigParser::POWER, ConfigParser::OK);
+    // blanks around the name and a command ended by ';' or '\r'
+    expect("  \tdt \t \r", ConfigParser::DATE_TIME, ConfigParser::OK);
+    expect("stats;", ConfigParser::STATS, ConfigParser::OK);
+}
+
+static void testSets()
+{
+    expect("dt 26 10 18 0 7 30 0\n", ConfigParser::DATE_TIME, ConfigParser::OK, {26, 10, 18, 0, 7, 30, 0});
+    expect("alarm 0700  1930\n", ConfigParser::ALARM, ConfigParser::OK, {700, 1930});
+    expect("theme 2\n", ConfigParser::THEME, ConfigParser::OK, {2});
+    expect("power\t3\n", ConfigParser::POWER, ConfigParser::OK, {3});
+    expect("sched 7e0d2528 FFFFFFFF 0 1 2 3 4 5 abcdef01\n", ConfigParser::SCHEDULE, ConfigParser::OK,
+           {0x7e0d2528, 0xffffffff, 0, 1, 2, 3, 4, 5, 0xabcdef01});
+    expect("pack 1e0 1 2 3 4 5 6 7 8\n", ConfigParser::PACK, ConfigParser::OK, {0x1e0, 1, 2, 3, 4, 5, 6, 7, 8});
+    // the largest values that fit
+    expect("theme 4294967295\n", ConfigParser::THEME, ConfigParser::OK, {4294967295u});
+    expect("pack ffffffff 0 0 0 0 0 0 0 0\n", ConfigParser::PACK, ConfigParser::OK, {0xffffffff, 0, 0, 0, 0, 0, 0, 0, 0});
+}
+
+static void testErrors()
+{
+    expect("time\n", ConfigParser::NONE, ConfigParser::UNKNOWN_COMMAND);
+    expect("DT\n", ConfigParser::NONE, ConfigParser::UNKNOWN_COMMAND);
+    expect("selftests\n", ConfigParser::NONE, ConfigParser::UNKNOWN_COMMAND);
+    expect("selftestselftest\n", ConfigParser::NONE, ConfigParser::UNKNOWN_COMMAND);
+    expect("d7 1\n", ConfigParser::NONE, ConfigParser::UNKNOWN_COMMAND);
+    expect("dt 26 10 18 0 7 30\n", ConfigParser::DATE_TIME, ConfigParser::ARG_COUNT);
+    expect("dt 26 10 18 0 7 30 0 0\n", ConfigParser::DATE_TIME, ConfigParser::ARG_COUNT);
+    expect("stats 1\n", ConfigParser::STATS, ConfigParser::ARG_COUNT);
+    expect("sched 0 0 0 0 0 0 0 0 0 0\n", ConfigParser::SCHEDULE, ConfigParser::ARG_COUNT);
+    expect("theme 1a\n", ConfigParser::THEME, ConfigParser::BAD_NUMBER);
+    expect("theme -1\n", ConfigParser::THEME, ConfigParser::BAD_NUMBER);
+    expect("theme 4294967296\n", ConfigParser::THEME, ConfigParser::BAD_NUMBER);
+    expect("pack 100000000 0 0 0 0 0 0 0 0\n", ConfigParser::PACK, ConfigParser::BAD_NUMBER);
+    expect("sched 0x1 0 0 0 0 0 0 0 0\n", ConfigParser::SCHEDULE, ConfigParser::BAD_NUMBER);
+}
+
+// several commands on one line, errors don't spill over into the next command
+static void testSequences()
+{
+    std::vector<Result> r = parse("dt 26 10 18 0 7 30 0; alarm 0700 1930;bogus 1;; \r\n\r\ntheme 1\r\n");
+    CHECK_EQ(r.size(), 4);
+    if (r.size() == 4)
+    {
+        CHECK_EQ(r[0].command, ConfigParser::DATE_TIME);
+        CHECK_EQ(r[0].argc, 7);
+        CHECK_EQ(r[1].command, ConfigParser::ALARM);
+        CHECK_EQ(r[1].argv[1], 1930);
+        CHECK_EQ(r[2].error, ConfigParser::UNKNOWN_COMMAND);
+        CHECK_EQ(r[3].command, ConfigParser::THEME);
+        CHECK_EQ(r[3].error, ConfigParser::OK);
+        CHECK_EQ(r[3].argv[0], 1);
+    }
+
+    // the result stays readable until the next command starts
+    ConfigParser p;
+    CHECK_EQ(parse(p, "theme 5\n  ").size(), 1);
+    CHECK_EQ(p.result().command, ConfigParser::THEME);
+    CHECK_EQ(p.result().argv[0], 5);
+    CHECK(p.idle());
+    parse(p, "t");
+    CHECK_EQ(p.result().command, ConfigParser::NONE);
+    CHECK(!p.idle());
+
+    // a half received command is dropped by reset(), the trace waits while the parser isn't idle
+    parse(p, "alarm 07");
+    CHECK(!p.idle());
+    p.reset();
+    CHECK(p.idle());
+    r = parse(p, "00 1930\n");
+    CHECK_EQ(r.size(), 1);
+    CHECK_EQ(r[0].error, ConfigParser::UNKNOWN_COMMAND);
+}
+
+static void testErrorText()
+{
+    CHECK(strcmp(ConfigParser::errorText(ConfigParser::OK), "ok") == 0);
+    CHECK(strcmp(ConfigParser::errorText(ConfigParser::ARG_COUNT), "wrong number of values") == 0);
+    CHECK(strcmp(ConfigParser::errorText((ConfigParser::Error)99), "?") == 0);
+}
+
+int main()
+{
+    testReads();
+    testSets();
+    testErrors();
+    testSequences();
+    testErrorText();
+    return check_result();
+}
@@ -0,0 +1,293 @@
+/**
+ * test_oled_glyph.cpp
+ *
+ * The glyph decoder against a plain reading of the RLE format in oled_glyph.h, on the built-in
+ * glyphs, on what the asset compiler's encoder makes of random images, and on damaged streams.
+ * Glyph data is placed right before an unreadable page, so a decoder reading past the size of
+ * a glyph crashes the test. The delta encoded animations are played from their key frame.
+ */
+
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <optional>
+#include <vector>
+
+#include "check.h"
+#include "rle.h"
+extern "C" {
+#include "oled_animations.h"
+#include "oled_glyph.h"
+#include "oled_static_data.h"
+}
+
+// bytes copied to the end of a readable page, the next page can't be read
+class Fenced {
+public:
+    explicit Fenced(const std::vector<uint8_t> & bytes)
+    {
+        size_t page = sysconf(_SC_PAGESIZE);
+        _map = (uint8_t *)mmap(nullptr, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        mprotect(_map + page, page, PROT_NONE);
+        _data = _map + page - bytes.size();
+        memcpy(_data, bytes.data(), bytes.size());
+        _page = page;
+    }
+    ~Fenced() { munmap(_map, 2 * _page); }
+    const uint8_t * data() const { return _data; }
+
+private:
+    uint8_t * _map;
+    uint8_t * _data;
+    size_t _page;
+};
+
+// the format as documented, nothing when the stream doesn't make up exactly the glyph
+static std::optional<std::vector<uint8_t>> reference(const std::vector<uint8_t> & rle, int width, int pages)
+{
+    std::vector<uint8_t> out;
+    size_t i = 0;
+    for (int page = 0; page < pages; page++)
+    {
+        size_t page_end = out.size() + width;
+        while (out.size() < page_end)
+        {
+            if (i >= rle.size())
+                return std::nullopt;
+            uint8_t token = rle[i++];
+            if (token >= 0x80)
+            {
+                if (i >= rle.size())
+                    return std::nullopt;
+                out.insert(out.end(), token - 0x80 + 3, rle[i++]);
+            }
+            else
+            {
+                if (i + token + 1 > rle.size())
+                    return std::nullopt;
+                out.insert(out.end(), rle.begin() + i, rle.begin() + i + token + 1);
+                i += token + 1;
+            }
+            if (out.size() > page_end)
+                return std::nullopt;
+        }
+    }
+    if (i != rle.size())
+        return std::nullopt;
+    return out;
+}
+
+#define GUARD 0xA5
+
+// Decodes into the middle of a wider buffer and checks that nothing outside the glyph's
+// columns changed. Returns the glyph's pages.
+static std::vector<uint8_t> decode(const oled_glyph_t & g)
+{
+    const int margin = 5, stride = g.width + 2 * margin;
+    std::vector<uint8_t> buf(stride * (g.pages + 2), GUARD);
+    oled_glyph_decode(&g, &buf[stride + margin], stride);
+
+    std::vector<uint8_t> out;
+    for (int y = 0; y < g.pages + 2; y++)
+    {
+        for (int x = 0; x < stride; x++)
+        {
+            uint8_t b = buf[y * stride + x];
+            if (y >= 1 && y <= g.pages && x >= margin && x < margin + g.width)
+                out.push_back(b);
+            else
+                CHECK_EQ(b, GUARD);
+        }
+    }
+    return out;
+}
+
+// a valid glyph decodes to the reference, and byte by byte to the same
+static void checkGlyph(const oled_glyph_t & g, const std::vector<uint8_t> & expected)
+{
+    CHECK(oled_glyph_valid(&g));
+    CHECK(decode(g) == expected);
+    for (int page = 0; page < g.pages; page++)
+        for (int col = 0; col < g.width; col++)
+            CHECK_EQ(oled_glyph_byte(&g, col, page), expected[page * g.width + col]);
+}
+
+// every built-in glyph is valid and decodes as the format says
+static void testBuiltIn()
+{
+    for (int i = 0; i < OLED_GLYPH_COUNT; i++)
+    {
+        const oled_glyph_t & g = oled_glyphs[i];
+        std::vector<uint8_t> bytes(g.data, g.data + g.size);
+        std::vector<uint8_t> expected = bytes;
+        if (g.encoding == OLED_GLYPH_RLE)
+        {
+            auto r = reference(bytes, g.width, g.pages);
+            CHECK(r.has_value());
+            if (!r)
+                continue;
+            expected = *r;
+        }
+        CHECK_EQ(expected.size(), g.width * g.pages);
+
+        Fenced f(bytes);
+        oled_glyph_t fenced = {f.data(), g.size, g.width, g.pages, g.encoding};
+        checkGlyph(fenced, expected);
+    }
+}
+
+static uint32_t seed = 0x6C7F1A3D;
+
+static uint32_t next()
+{
+    // xorshift32, the same sequence on every host
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+// Random images the encoder has to cut into literals and runs of every length, the longest
+// runs and literals included, and pages that end in the middle of either.
+static void testEncoder()
+{
+    for (int n = 0; n < 2000; n++)
+    {
+        int width = 1 + next() % 128, pages = 1 + next() % 8;
+        std::vector<uint8_t> image(width * pages);
+        uint8_t value = 0;
+        for (size_t i = 0; i < image.size(); i++)
+        {
+            // stretches of repeats or of noise
+            if (next() % 8 == 0)
+                value = next() % 4 ? next() : (uint8_t)(value + 1);
+            image[i] = next() % 2 && n % 3 ? (uint8_t)next() : value;
+        }
+        if (n == 0)
+            image.assign(image.size(), 0);
+
+        std::vector<uint8_t> rle = rleEncode(image, width);
+        CHECK(reference(rle, width, pages) == image);
+        Fenced f(rle);
+        oled_glyph_t g = {f.data(), (uint16_t)rle.size(), (uint8_t)width, (uint8_t)pages, OLED_GLYPH_RLE};
+        checkGlyph(g, image);
+    }
+}
+
+// Damaged streams: cut short, a token or a byte changed, a byte too many. The check agrees with
+// the reference, and whatever the data, decoding stays within the data and the glyph.
+static void testDamaged()
+{
+    const oled_glyph_t & moon = oled_glyphs[OLED_GLYPH_MOON];
+    CHECK_EQ(moon.encoding, OLED_GLYPH_RLE);
+    const std::vector<uint8_t> good(moon.data, moon.data + moon.size);
+
+    std::vector<std::vector<uint8_t>> streams;
+    for (size_t len = 0; len < good.size(); len++)
+        streams.emplace_back(good.begin(), good.begin() + len);
+    for (size_t i = 0; i < good.size(); i++)
+    {
+        for (uint8_t v : {0x00, 0x01, 0x7F, 0x80, 0x81, 0xFF})
+        {
+            std::vector<uint8_t> s = good;
+            s[i] = v;
+            streams.push_back(s);
+        }
+        std::vector<uint8_t> s = good;
+        s[i] ^= 0x80;
+        streams.push_back(s);
+    }
+    streams.push_back(good);
+    streams.back().push_back(0);
+
+    int invalid = 0;
+    for (const auto & s : streams)
+    {
+        Fenced f(s);
+        oled_glyph_t g = {f.data(), (uint16_t)s.size(), moon.width, moon.pages, OLED_GLYPH_RLE};
+        auto r = reference(s, moon.width, moon.pages);
+        CHECK_EQ(oled_glyph_valid(&g), r.has_value());
+        std::vector<uint8_t> out = decode(g);
+        if (r)
+            CHECK(out == *r);
+        else
+            invalid++;
+        for (int page = 0; page < g.pages; page++)
+            for (int col = 0; col < g.width; col++)
+                oled_glyph_byte(&g, col, page);
+    }
+    CHECK(invalid > (int)good.size());
+
+    // the right number of bytes in all, but a run or a literal across the end of a page
+    static const std::vector<uint8_t> across[] = {
+        {0x02, 1, 2, 3, 0x82, 9},
+        {0x82, 7, 0x02, 1, 2, 3},
+        {0x05, 1, 2, 3, 4, 5, 6, 0x80, 9},
+    };
+    for (const auto & s : across)
+    {
+        Fenced f(s);
+        oled_glyph_t g = {f.data(), (uint16_t)s.size(), 4, 2, OLED_GLYPH_RLE};
+        CHECK(!oled_glyph_valid(&g));
+        decode(g);
+    }
+
+    // raw glyphs are valid at their exact size only, and read no further than it
+    const uint8_t * one = oled_glyphs[OLED_GLYPH_SMALL_ONE].data;
+    for (size_t len : {0, 15, 16, 17})
+    {
+        std::vector<uint8_t> raw(one, one + (len < 16 ? len : 16));
+        raw.resize(len, 0);
+        Fenced f(raw);
+        oled_glyph_t g = {f.data(), (uint16_t)len, 8, 2, OLED_GLYPH_RAW};
+        CHECK_EQ(oled_glyph_valid(&g), len == 16);
+        decode(g);
+        CHECK_EQ(oled_glyph_byte(&g, 7, 1), len >= 16 ? raw[15] : 0);
+    }
+    oled_glyph_t unknown = {good.data(), (uint16_t)good.size(), moon.width, moon.pages, 2};
+    CHECK(!oled_glyph_valid(&unknown));
+}
+
+// Each frame's spans lie within the sprite and change what they cover, the spans of the last
+// frame lead back to the key frame, and the span data is used from end to end.
+static void testAnimation(const sprite_anim_t & a)
+{
+    CHECK_EQ(a.key_frame->width, a.width);
+    CHECK_EQ(a.key_frame->pages, a.pages);
+    CHECK(a.frame_count > 1);
+    CHECK_EQ(a.frame_spans[0], 0);
+
+    const std::vector<uint8_t> key = decode(*a.key_frame);
+    std::vector<uint8_t> frame = key;
+    uint16_t data_end = 0;
+    for (int f = 0; f < a.frame_count; f++)
+    {
+        CHECK(a.frame_spans[f + 1] > a.frame_spans[f]);
+        for (uint16_t i = a.frame_spans[f]; i < a.frame_spans[f + 1]; i++)
+        {
+            const sprite_span_t & s = a.spans[i];
+            CHECK(s.page < a.pages);
+            CHECK(s.len > 0 && s.col + s.len <= a.width);
+            CHECK_EQ(s.offset, data_end);
+            data_end = s.offset + s.len;
+            if (s.page >= a.pages || s.col + s.len > a.width)
+                return;
+
+            uint8_t * dst = &frame[s.page * a.width + s.col];
+            CHECK(memcmp(dst, &a.data[s.offset], s.len) != 0);
+            memcpy(dst, &a.data[s.offset], s.len);
+        }
+        if (f < a.frame_count - 1)
+            CHECK(frame != key);
+    }
+    CHECK(frame == key);
+}
+
+int main()
+{
+    testBuiltIn();
+    testEncoder();
+    testDamaged();
+    testAnimation(oled_moon_twinkle);
+    return check_result();
+}
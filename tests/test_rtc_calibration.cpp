@@ -0,0 +1,125 @@
+/**
+ * test_rtc_calibration.cpp
+ *
+ * The calibration measurement against a simulated RTC clock output with a known crystal error,
+ * timed by a reference that may be off itself.
+ */
+
+#include <math.h>
+
+#include "check.h"
+#include "hardware/pwm.h"
+#include "pico/time.h"
+#include "rtc_calibration.h"
+#include "rv3028.h"
+
+#define CLKOUT_PIN  13
+#define CLKOUT_HZ   1024
+
+// the RTC output and the RP2350 crystal, with their errors in ppm
+struct SkewedClock {
+    double rtc_ppm;
+    double reference_ppm;
+    double phase;           // fraction of a period before the first edge
+    uint64_t stop_us;       // the output stops here, 0 = never
+};
+
+static uint64_t skewedEdges(uint64_t now_us, void * ctx)
+{
+    const SkewedClock & c = *static_cast<const SkewedClock *>(ctx);
+    if (c.stop_us && now_us > c.stop_us)
+        now_us = c.stop_us;
+    // the timer runs at the reference's rate, the RTC at its own
+    double seconds = now_us / (1 + c.reference_ppm * 1e-6) / 1e6;
+    double edges = seconds * CLKOUT_HZ * (1 + c.rtc_ppm * 1e-6) - c.phase;
+    return edges < 0 ? 0 : (uint64_t)edges + 1;
+}
+
+static void progress(uint32_t done, uint32_t total, void * ctx)
+{
+    uint32_t & last = *static_cast<uint32_t *>(ctx);
+    CHECK(done > last && done < total);
+    last = done;
+}
+
+// the error is found within a fraction of an EEOffset step, and so is the offset that fixes it
+static void testSkew(double rtc_ppm, double reference_ppm, uint32_t seconds)
+{
+    SkewedClock clock = {rtc_ppm, reference_ppm, 0.37, 0};
+    host_pwm_input(pwm_gpio_to_slice_num(CLKOUT_PIN), skewedEdges, &clock);
+    sleep_ms(123);
+
+    uint32_t edges = 0, reported = 0;
+    uint64_t elapsed_us = 0;
+    CHECK(rtc_calibration_measure(CLKOUT_PIN, seconds, edges, elapsed_us, progress, &reported));
+    CHECK_EQ(reported, seconds - 1);
+    CHECK(elapsed_us >= seconds * 1000000ull);
+    CHECK(elapsed_us < seconds * 1000000ull + 2000);
+
+    // an edge is timed to a poll, a few microseconds over the whole window
+    double ppm = rtc_calibration_ppm(edges, elapsed_us, CLKOUT_HZ, reference_ppm);
+    double tolerance = 2.0 * HOST_PWM_POLL_US / seconds + 0.01;
+    if (fabs(ppm - rtc_ppm) > tolerance)
+        fprintf(stderr, "rtc %+.3f ppm, reference %+.3f ppm: measured %+.3f ppm\n", rtc_ppm, reference_ppm, ppm);
+    CHECK(fabs(ppm - rtc_ppm) <= tolerance);
+
+    int16_t steps = rtc_calibration_steps(ppm);
+    double residual = rtc_ppm - steps * rv3028::OFFSET_STEP_PPM;
+    if (steps > rv3028::OFFSET_MIN && steps < rv3028::OFFSET_MAX)
+        CHECK(fabs(residual) <= rv3028::OFFSET_STEP_PPM / 2 + tolerance);
+    else
+        // out of range, the largest correction of the right sign
+        CHECK(residual * rtc_ppm > 0);
+}
+
+static void testNoSignal()
+{
+    SkewedClock clock = {0, 0, 0, 1};
+    host_pwm_input(pwm_gpio_to_slice_num(CLKOUT_PIN), skewedEdges, &clock);
+    uint32_t edges = 0;
+    uint64_t elapsed_us = 0;
+    uint64_t start = time_us_64();
+    CHECK(!rtc_calibration_measure(CLKOUT_PIN, 5, edges, elapsed_us, nullptr, nullptr));
+    CHECK(time_us_64() - start < 200000);
+}
+
+// the output stopping halfway is a failed measurement, not a slow clock
+static void testSignalLost()
+{
+    SkewedClock clock = {10, 0, 0.5, time_us_64() + 2500000};
+    host_pwm_input(pwm_gpio_to_slice_num(CLKOUT_PIN), skewedEdges, &clock);
+    uint32_t edges = 0;
+    uint64_t elapsed_us = 0;
+    CHECK(!rtc_calibration_measure(CLKOUT_PIN, 5, edges, elapsed_us, nullptr, nullptr));
+}
+
+static void testPpm()
+{
+    CHECK_EQ(rtc_calibration_ppm(CLKOUT_HZ * 100, 100000000, CLKOUT_HZ, 0), 0);
+    CHECK(fabs(rtc_calibration_ppm(CLKOUT_HZ * 100 + 1, 100000000, CLKOUT_HZ, 0) - 1e6 / (CLKOUT_HZ * 100)) < 1e-6);
+    CHECK(fabs(rtc_calibration_ppm(CLKOUT_HZ * 100, 100000000, CLKOUT_HZ, 3.5) - 3.5) < 1e-9);
+    CHECK_EQ(rtc_calibration_ppm(100, 0, CLKOUT_HZ, 0), 0);
+
+    CHECK_EQ(rtc_calibration_steps(0), 0);
+    CHECK_EQ(rtc_calibration_steps(rv3028::OFFSET_STEP_PPM * 3), 3);
+    CHECK_EQ(rtc_calibration_steps(-rv3028::OFFSET_STEP_PPM * 7.4), -7);
+    CHECK_EQ(rtc_calibration_steps(1e6), rv3028::OFFSET_MAX);
+    CHECK_EQ(rtc_calibration_steps(-1e6), rv3028::OFFSET_MIN);
+}
+
+int main()
+{
+    testPpm();
+
+    static const double rtc[] = {0, 3.2, -11.7, 48.9, -130.4, 300};
+    static const double reference[] = {0, 6.5, -2.25};
+    for (double r : rtc)
+        for (double ref : reference)
+            testSkew(r, ref, 10);
+    // long enough for the 16 bit counter to wrap
+    testSkew(-20.6, 1.5, 80);
+
+    testNoSignal();
+    testSignalLost();
+    return check_result();
+}
@@ -0,0 +1,207 @@
+/**
+ * test_schedule.cpp
+ *
+ * The mode for every (wakeup, goto sleep, minute) there is, against the two-branch code it
+ * replaced: the same everywhere but the goto sleep minute of a night across midnight, which the
+ * old code still counted as wakeup time. Each pair is checked as a whole day at a time, the
+ * inner loops run over plain arrays of minutes so the compiler vectorises them, and the
+ * 1440 x 1440 x 1440 sweep takes seconds. Next to it, invariants of the mode and of the sleep
+ * progress bar, and the entries of the EEPROM table.
+ */
+
+#include <initializer_list>
+
+#include "check.h"
+#include "schedule.h"
+
+#define DAY (24 * 60)
+
+// isWakeupTime() before it moved into Schedule
+static bool oldIsWakeup(uint16_t minute, uint16_t wakeup, uint16_t gotosleep)
+{
+    if (wakeup <= gotosleep)
+        return minute >= wakeup && minute < gotosleep;
+    else
+        return minute >= wakeup || minute <= gotosleep;
+}
+
+// the icon before it followed the mode: compareTime(), strict at both ends, no wrap
+static bool oldIcon(uint16_t minute, uint16_t wakeup, uint16_t gotosleep)
+{
+    return minute > wakeup && minute < gotosleep;
+}
+
+// what one pair does over a day, counted over all its minutes
+struct Day {
+    uint32_t wakeup;            // minutes in wakeup mode
+    uint32_t transitions;       // minutes in another mode than the one before, around midnight
+    uint32_t not_old;           // minutes where the old code differs, bar the fixed minute
+    uint32_t old_fixed;         // minutes where it differs on the goto sleep minute across midnight
+    uint32_t icon;              // minutes where the old icon differs, bar its documented minutes
+    uint32_t not_progress;      // minutes where the bar's window isn't the complement of the mode
+    uint32_t done_past;         // minutes of the sleep window with the bar at or past its end
+};
+
+static uint16_t minutes[DAY], before[DAY];
+
+// Plain arithmetic on 16 bit lanes without branches, so the loop vectorises. The branch of
+// oldIsWakeup() only depends on the pair, it is taken once, outside the loop.
+template <bool across>
+static Day sweep(uint16_t w, uint16_t g)
+{
+    const Schedule::Times t = {w, g};
+    uint16_t wakeup = 0, transitions = 0, not_old = 0, old_fixed = 0, icon = 0, not_progress = 0, done_past = 0;
+    for (int i = 0; i < DAY; i++)
+    {
+        const uint16_t m = minutes[i];
+        const bool mode = Schedule::isWakeup(m, t);
+        const bool old = across ? m >= w || m <= g : m >= w && m < g;
+        const bool changed = mode != old;
+        const bool fixed = across & (m == g);
+        uint16_t done, total;
+        Schedule::sleepProgress(m, t, done, total);
+
+        wakeup += mode;
+        transitions += mode != Schedule::isWakeup(before[i], t);
+        not_old += changed & !fixed;
+        old_fixed += changed & fixed;
+        // the old icon was off the whole day across midnight, and on the wakeup minute
+        icon += !across & (mode != oldIcon(m, w, g)) & (m != w);
+        not_progress += (done < total) == mode;
+        done_past += !mode & (done >= total);
+    }
+    return {wakeup, transitions, not_old, old_fixed, icon, not_progress, done_past};
+}
+
+// every pair, each over the whole day
+static void testSweep()
+{
+    for (int i = 0; i < DAY; i++)
+    {
+        minutes[i] = i;
+        before[i] = i == 0 ? DAY - 1 : i - 1;
+    }
+
+    uint64_t old_fixed = 0, wrong = 0;
+    for (uint16_t w = 0; w < DAY; w++)
+    {
+        for (uint16_t g = 0; g < DAY; g++)
+        {
+            const Day d = w > g ? sweep<true>(w, g) : sweep<false>(w, g);
+            // wakeup mode lasts from the wakeup minute up to goto sleep, nothing when they're equal
+            const uint32_t length = (g + DAY - w) % DAY;
+            bool ok = d.wakeup == length && d.transitions == (w == g ? 0u : 2u) && d.not_old == 0 &&
+                      d.old_fixed == (w > g ? 1u : 0u) && d.icon == 0 && d.not_progress == 0 && d.done_past == 0;
+            if (!ok && wrong++ < 10)
+                fprintf(stderr, "wakeup %u goto sleep %u: %u minutes awake, %u transitions, %u %u %u %u %u\n",
+                        w, g, d.wakeup, d.transitions, d.not_old, d.old_fixed, d.icon, d.not_progress, d.done_past);
+            old_fixed += d.old_fixed;
+        }
+    }
+    CHECK_EQ(wrong, 0);
+    // one minute for every pair with goto sleep before wakeup
+    CHECK_EQ(old_fixed, DAY * (DAY - 1) / 2);
+}
+
+// The minutes around each transition, where the two modes meet, with the day's edges. Two
+// transitions on the configured minutes and a wakeup window of the right length leave no other
+// place for a change, this pins down which way round each one goes.
+static void testEdges()
+{
+    static const uint16_t picks[] = {0, 1, 2, 59, 60, 359, 360, 719, 720, 1319, 1320, 1380, 1437, 1438, 1439};
+    for (uint16_t w : picks)
+    {
+        for (uint16_t g : picks)
+        {
+            const Schedule::Times t = {w, g};
+            const uint16_t w_before = (w + DAY - 1) % DAY, g_before = (g + DAY - 1) % DAY;
+            uint16_t done, total;
+            if (w == g)
+            {
+                // goto sleep all day, the bar spans the whole day from the goto sleep minute
+                for (uint16_t m : {(uint16_t)0, w_before, w, (uint16_t)((w + 1) % DAY), (uint16_t)(DAY - 1)})
+                    CHECK(!Schedule::isWakeup(m, t));
+                Schedule::sleepProgress(w, t, done, total);
+                CHECK_EQ(done, 0);
+                CHECK_EQ(total, DAY);
+                Schedule::sleepProgress(w_before, t, done, total);
+                CHECK_EQ(done, DAY - 1);
+                continue;
+            }
+
+            CHECK(Schedule::isWakeup(w, t));
+            CHECK(!Schedule::isWakeup(w_before, t));
+            CHECK(!Schedule::isWakeup(g, t));
+            CHECK(Schedule::isWakeup(g_before, t));
+
+            // the bar starts empty on the goto sleep minute and is one short of full before wakeup
+            Schedule::sleepProgress(g, t, done, total);
+            CHECK_EQ(done, 0);
+            CHECK_EQ(total, (w + DAY - g) % DAY);
+            Schedule::sleepProgress(w_before, t, done, total);
+            CHECK_EQ(done, total - 1);
+            Schedule::sleepProgress(w, t, done, total);
+            CHECK_EQ(done, total);
+
+            // midnight itself is just another minute
+            const bool across = w > g;
+            CHECK_EQ(Schedule::isWakeup(0, t), across ? g != 0 : w == 0);
+            CHECK_EQ(Schedule::isWakeup(DAY - 1, t), across);
+        }
+    }
+
+    // the defaults and the old failure: 20:00 to 07:00, 07:00 was still wakeup time
+    const Schedule::Times night = {20 * 60, 7 * 60};
+    CHECK(Schedule::isWakeup(6 * 60 + 59, night));
+    CHECK(!Schedule::isWakeup(7 * 60, night));
+    CHECK(oldIsWakeup(7 * 60, night.wakeup, night.gotosleep));
+    CHECK(!Schedule::isWakeup(19 * 60 + 59, night));
+    CHECK(Schedule::isWakeup(20 * 60, night));
+}
+
+// entries survive the EEPROM format, bad fields are refused
+static void testEntries()
+{
+    for (uint16_t w = 0; w < DAY; w += 7)
+    {
+        uint16_t g = (w * 13 + 5) % DAY;
+        Schedule::Entry weekday = {false, (uint8_t)(w % 127 + 1), 0, 0, {w, g}};
+        Schedule::Entry date = {true, 0, (uint8_t)(w % 12 + 1), (uint8_t)(w % 31 + 1), {g, w}};
+        for (const Schedule::Entry & e : {weekday, date})
+        {
+            Schedule::Entry back;
+            CHECK(Schedule::decode(Schedule::encode(e), back));
+            CHECK_EQ(back.by_date, e.by_date);
+            CHECK_EQ(back.times.wakeup, e.times.wakeup);
+            CHECK_EQ(back.times.gotosleep, e.times.gotosleep);
+            if (e.by_date)
+            {
+                CHECK_EQ(back.month, e.month);
+                CHECK_EQ(back.day, e.day);
+            }
+            else
+                CHECK_EQ(back.weekdays, e.weekdays);
+        }
+    }
+
+    Schedule::Entry e;
+    CHECK(!Schedule::decode(Schedule::UNUSED, e));
+    // an empty weekday mask, a minute past the day
+    CHECK(!Schedule::decode(0x00000000, e));
+    CHECK(!Schedule::decode(0x7F000000 | DAY << 11, e));
+    CHECK(!Schedule::decode(0x7F000000 | DAY, e));
+    CHECK(Schedule::decode(0x7F000000 | (DAY - 1) << 11 | (DAY - 1), e));
+    // dates: month 0 and 13, day 0
+    CHECK(!Schedule::decode(1u << 31 | 0u << 27 | 1u << 22, e));
+    CHECK(!Schedule::decode(1u << 31 | 13u << 27 | 1u << 22, e));
+    CHECK(!Schedule::decode(1u << 31 | 12u << 27 | 0u << 22, e));
+    CHECK(Schedule::decode(1u << 31 | 12u << 27 | 31u << 22, e));
+}
+
+int main()
+{
+    testSweep();
+    testEdges();
+    testEntries();
+    return check_result();
+}
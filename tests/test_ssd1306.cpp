@@ -0,0 +1,309 @@
+/**
+ * test_ssd1306.cpp
+ *
+ * The display driver against the controller model, built once for each panel profile. What the
+ * glass shows is compared with a second driver that drew the expected picture directly.
+ */
+
+#include <string.h>
+#include <vector>
+
+#include "asset_pack.h"
+#include "check.h"
+#include "host_i2c.h"
+#include "ssd1306.h"
+#include "ssd1306_emulator.h"
+
+using Panel = Display::Profile;
+
+static i2c_inst_t bus0 = {0};
+static i2c_inst_t bus1 = {1};
+
+struct Rig {
+    Ssd1306Emulator panel{Panel::width, Panel::height};
+    Display * display;
+
+    explicit Rig(i2c_inst_t * i2c)
+    {
+        host_i2c_attach(i2c, Panel::i2c_addr, &panel);
+        display = new Display(i2c, false, false);
+    }
+    ~Rig() { delete display; }
+};
+
+// the glass, row by row
+static std::vector<bool> glass(const Ssd1306Emulator & e)
+{
+    std::vector<bool> pixels;
+    for (int y = 0; y < Panel::height; y++)
+        for (int x = 0; x < Panel::width; x++)
+            pixels.push_back(e.visible(x, y));
+    return pixels;
+}
+
+static bool inRegion(const Region & r, int x, int y)
+{
+    return x >= r.col && x <= r.colEnd() && y >= r.page * 8 && y < (r.pageEnd() + 1) * 8;
+}
+
+// the panel is set up for its geometry and starts out blank
+static void testInit()
+{
+    host_i2c_detach_all();
+    Rig rig(&bus0);
+
+    CHECK(rig.panel.on());
+    CHECK_EQ(rig.panel.muxRatio(), Panel::height - 1);
+    CHECK_EQ(rig.panel.comPins(), Panel::com_pins);
+    CHECK_EQ(rig.panel.unknown_commands, 0);
+    // the first frame covers the whole panel, and the RAM below a shorter one that the pixel
+    // shift brings in is cleared
+    const int below = Panel::shift_rows > 0 ? 128 * (64 - Panel::height) / 8 : 0;
+    CHECK_EQ(rig.panel.data_bytes, Panel::width * Panel::height / 8 + below);
+    for (bool pixel : glass(rig.panel))
+        CHECK(!pixel);
+}
+
+// every digit of the time lands in its region of the profile's layout, the rest stays dark
+static void testTimeLayout()
+{
+    constexpr const ScreenLayout & l = Panel::layout;
+    host_i2c_detach_all();
+    Rig rig(&bus0);
+    rig.display->renderTime(23, 58);
+
+    uint8_t expected[Panel::width * Panel::height / 8] = {};
+    struct { const Region & r; int glyph; } drawn[] = {
+        {l.hour_tens, OLED_GLYPH_ONE},
+        {l.hour_ones, OLED_GLYPH_ZERO + 1},
+        {l.colon, OLED_GLYPH_COLON},
+        {l.minute_tens, OLED_GLYPH_ZERO + 5},
+        {l.minute_ones, OLED_GLYPH_ZERO + 8},
+        {l.meridiem, OLED_GLYPH_PM},
+    };
+    for (const auto & d : drawn)
+        oled_glyph_decode(&asset_glyphs()[d.glyph], &expected[d.r.page * Panel::width + d.r.col], Panel::width);
+
+    for (int y = 0; y < Panel::height; y++)
+        for (int x = 0; x < Panel::width; x++)
+            CHECK_EQ(rig.panel.visible(x, y), expected[y / 8 * Panel::width + x] >> (y % 8) & 1);
+}
+
+// The pixel shift moves the whole picture one column or one row at a time, by content scroll
+// and display offset only, and what is drawn while shifted lands in the shifted place. Panels
+// without content scroll only move vertically. The rows that wrap to the top stay dark.
+static void testPixelShift()
+{
+    host_i2c_detach_all();
+    Rig rig(&bus0), ref(&bus1);
+    rig.display->renderTime(10, 0);
+    rig.display->renderIcon(Display::SUN);
+    ref.display->renderIcon(Display::SUN);
+
+    int dx = 0, dy = 0;
+    for (int step = 0; step < 40; step++)
+    {
+        uint32_t data_before = rig.panel.data_bytes;
+        rig.display->pixelShiftStep();
+        CHECK_EQ(rig.panel.data_bytes, data_before);
+
+        // a new minute and the bar, drawn onto the shifted panel
+        rig.display->renderTime(10, step);
+        ref.display->renderTime(10, step);
+        rig.display->renderProgress(step, 40);
+        ref.display->renderProgress(step, 40);
+        std::vector<bool> expected = glass(ref.panel);
+
+        auto matches = [&](int sx, int sy) {
+            for (int y = 0; y < Panel::height; y++)
+                for (int x = 0; x < Panel::width; x++)
+                    if (rig.panel.visible((x + sx) % Panel::width, y) != (y >= sy && expected[(y - sy) * Panel::width + x]))
+                        return false;
+            return true;
+        };
+        bool found = false;
+        static const int moves[][2] = {{0, 0}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+        for (const auto & m : moves)
+        {
+            int sx = dx + m[0], sy = dy + m[1];
+            if (sx < 0 || sy < 0 || (!Panel::content_scroll && sx != 0))
+                continue;
+            if (matches(sx, sy))
+            {
+                dx = sx;
+                dy = sy;
+                found = true;
+                break;
+            }
+        }
+        CHECK(found);
+        CHECK(dx <= 3 && dy <= Panel::shift_rows);
+        sleep_ms(60 * 1000);
+    }
+    CHECK_EQ(rig.panel.early_writes, 0);
+    if (!Panel::content_scroll)
+        CHECK_EQ(rig.panel.scrolls, 0);
+}
+
+// a band of pages is moved to the top of the glass and only its rows are scanned
+static void testActiveBand()
+{
+    const int band_start = 1, band_pages = 2;
+    host_i2c_detach_all();
+    Rig rig(&bus0), ref(&bus1);
+    rig.display->setActiveBand(band_start, band_pages);
+    rig.display->renderTime(12, 34);
+    ref.display->renderTime(12, 34);
+    CHECK_EQ(rig.panel.muxRatio(), band_pages * 8 - 1);
+
+    std::vector<bool> expected = glass(ref.panel);
+    for (int y = 0; y < Panel::height; y++)
+        for (int x = 0; x < Panel::width; x++)
+            CHECK_EQ(rig.panel.visible(x, y), y < band_pages * 8 && expected[(y + band_start * 8) * Panel::width + x]);
+
+    // back to the full panel, pages written meanwhile included
+    rig.display->setActiveBand(0, 0);
+    CHECK(glass(rig.panel) == expected);
+}
+
+// Slide from the sun to the moon, dx columns into the pixel shift orbit. At every step the icon
+// region must show the new icon's rightmost columns followed by the old icon, the rest of the
+// panel must not change, and no data may reach the RAM while a content scroll is moving it.
+static void testTransition(int shift_steps)
+{
+    constexpr const Region & r = Panel::layout.icon;
+    host_i2c_detach_all();
+    Rig rig(&bus0), sun(&bus1);
+    sun.display->renderIcon(Display::SUN);
+    Rig moon(&bus1);
+    moon.display->renderIcon(Display::MOON);
+
+    rig.display->renderTime(12, 34);
+    rig.display->renderIcon(Display::SUN);
+    for (int i = 0; i < shift_steps; i++)
+    {
+        rig.display->pixelShiftStep();
+        sleep_ms(100);
+    }
+    // the orbit starts along the top row, one column per step
+    const int dx = shift_steps;
+
+    std::vector<bool> before = glass(rig.panel);
+    std::vector<bool> old_icon = glass(sun.panel);
+    std::vector<bool> new_icon = glass(moon.panel);
+    uint32_t data_before = rig.panel.data_bytes;
+    uint32_t scrolls_before = rig.panel.scrolls;
+
+    rig.display->transitionIcon(Display::MOON);
+    int steps = 0;
+    bool running = true;
+    while (running)
+    {
+        running = rig.display->transitionStep();
+        steps++;
+        CHECK(steps < 100000);
+        if (steps >= 100000)
+            break;
+
+        uint32_t scrolls = rig.panel.scrolls - scrolls_before;
+        uint32_t written = (rig.panel.data_bytes - data_before) / r.pages;
+        CHECK(scrolls == written || scrolls == written + 1);
+
+        std::vector<bool> now = glass(rig.panel);
+        for (int y = 0; y < Panel::height; y++)
+        {
+            for (int x = 0; x < Panel::width; x++)
+            {
+                // logical column x is on glass column x + dx
+                int gx = (x + dx) % Panel::width;
+                bool shown = now[y * Panel::width + gx];
+                if (!inRegion(r, x, y))
+                {
+                    CHECK_EQ(shown, before[y * Panel::width + gx]);
+                    continue;
+                }
+                int c = x - r.col;
+                bool expected;
+                if (scrolls == written)
+                    expected = c < (int)written ? new_icon[y * Panel::width + r.col + c + r.width - written]
+                                                : old_icon[y * Panel::width + r.col + c - written];
+                else if (c == 0)
+                    // the column that wrapped around, not overwritten yet
+                    expected = old_icon[y * Panel::width + r.col + r.width - 1 - written];
+                else
+                    expected = c <= (int)written ? new_icon[y * Panel::width + r.col + c - 1 + r.width - written]
+                                                 : old_icon[y * Panel::width + r.col + c - 1 - written];
+                CHECK_EQ(shown, expected);
+            }
+        }
+        sleep_ms(1);
+    }
+
+    // one column of the new icon per step and nothing else
+    CHECK_EQ(rig.panel.scrolls - scrolls_before, r.width);
+    CHECK_EQ(rig.panel.data_bytes - data_before, r.bytes());
+    CHECK_EQ(rig.panel.early_writes, 0);
+    CHECK(!rig.display->isTransitioning());
+
+    // afterwards the driver draws onto the slid RAM as if it had drawn the moon itself
+    rig.display->renderTime(7, 5);
+    moon.display->renderTime(7, 5);
+    std::vector<bool> now = glass(rig.panel);
+    std::vector<bool> expected = glass(moon.panel);
+    for (int y = 0; y < Panel::height; y++)
+        for (int x = 0; x < Panel::width; x++)
+            CHECK_EQ(now[y * Panel::width + (x + dx) % Panel::width], expected[y * Panel::width + x]);
+}
+
+// turning the panel off in the middle of a slide finishes it at once
+static void testTransitionDisplayOff()
+{
+    host_i2c_detach_all();
+    Rig rig(&bus0), moon(&bus1);
+    moon.display->renderIcon(Display::MOON);
+
+    rig.display->renderIcon(Display::SUN);
+    rig.display->transitionIcon(Display::MOON);
+    for (int i = 0; i < 200 && rig.display->transitionStep(); i++)
+        sleep_ms(1);
+    rig.display->setDisplayOn(false);
+    CHECK(!rig.display->transitionStep());
+    CHECK(!rig.display->isTransitioning());
+    rig.display->setDisplayOn(true);
+
+    CHECK(glass(rig.panel) == glass(moon.panel));
+    CHECK_EQ(rig.panel.early_writes, 0);
+}
+
+// a controller without content scroll gets the new icon drawn in one go
+static void testTransitionWithoutScroll()
+{
+    host_i2c_detach_all();
+    Rig rig(&bus0), moon(&bus1);
+    moon.display->renderIcon(Display::MOON);
+
+    rig.display->renderIcon(Display::SUN);
+    rig.display->transitionIcon(Display::MOON);
+    CHECK(!rig.display->transitionStep());
+    CHECK_EQ(rig.panel.scrolls, 0);
+    CHECK(glass(rig.panel) == glass(moon.panel));
+}
+
+int main()
+{
+    testInit();
+    testTimeLayout();
+    testPixelShift();
+    testActiveBand();
+    if (Panel::content_scroll)
+    {
+        testTransition(0);
+        testTransition(3);
+        testTransitionDisplayOff();
+    }
+    else
+    {
+        testTransitionWithoutScroll();
+    }
+    return check_result();
+}
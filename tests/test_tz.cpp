@@ -0,0 +1,291 @@
+/**
+ * test_tz.cpp
+ *
+ * Time zone rules against the transitions of the real zones, both hemispheres, every minute of
+ * 2024-2027 and the seconds around each change, and against the C library's own reading of the
+ * same POSIX TZ strings over the whole range of the RTC's calendar.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "check.h"
+#include "tz.h"
+
+#define HOUR 3600
+
+static uint32_t utcOf(int y, int m, int d, int hh, int mm)
+{
+    struct tm t = {};
+    t.tm_year = y - 1900;
+    t.tm_mon = m - 1;
+    t.tm_mday = d;
+    t.tm_hour = hh;
+    t.tm_min = mm;
+    return (uint32_t)timegm(&t);
+}
+
+struct Change {
+    int y, m, d, hh, mm;    // UTC
+    int32_t offset;         // from then on
+};
+
+struct Zone {
+    const char * spec;
+    int32_t offset;         // at the start of 2024
+    Change changes[8];      // 2024-2027, from the tz database
+};
+
+static const Zone zones[] = {
+    // Europe/Berlin, at 01:00 UTC both ways
+    {"CET-1CEST,M3.5.0,M10.5.0/3", 1 * HOUR, {
+        {2024, 3, 31, 1, 0, 2 * HOUR}, {2024, 10, 27, 1, 0, 1 * HOUR},
+        {2025, 3, 30, 1, 0, 2 * HOUR}, {2025, 10, 26, 1, 0, 1 * HOUR},
+        {2026, 3, 29, 1, 0, 2 * HOUR}, {2026, 10, 25, 1, 0, 1 * HOUR},
+        {2027, 3, 28, 1, 0, 2 * HOUR}, {2027, 10, 31, 1, 0, 1 * HOUR},
+    }},
+    // America/New_York, the US rules without spelling them out
+    {"EST5EDT", -5 * HOUR, {
+        {2024, 3, 10, 7, 0, -4 * HOUR}, {2024, 11, 3, 6, 0, -5 * HOUR},
+        {2025, 3, 9, 7, 0, -4 * HOUR}, {2025, 11, 2, 6, 0, -5 * HOUR},
+        {2026, 3, 8, 7, 0, -4 * HOUR}, {2026, 11, 1, 6, 0, -5 * HOUR},
+        {2027, 3, 14, 7, 0, -4 * HOUR}, {2027, 11, 7, 6, 0, -5 * HOUR},
+    }},
+    // Australia/Sydney, the year starts in daylight saving, the changes are on Saturday in UTC
+    {"AEST-10AEDT,M10.1.0,M4.1.0/3", 11 * HOUR, {
+        {2024, 4, 6, 16, 0, 10 * HOUR}, {2024, 10, 5, 16, 0, 11 * HOUR},
+        {2025, 4, 5, 16, 0, 10 * HOUR}, {2025, 10, 4, 16, 0, 11 * HOUR},
+        {2026, 4, 4, 16, 0, 10 * HOUR}, {2026, 10, 3, 16, 0, 11 * HOUR},
+        {2027, 4, 3, 16, 0, 10 * HOUR}, {2027, 10, 2, 16, 0, 11 * HOUR},
+    }},
+    // Australia/Lord_Howe, half an hour of daylight saving
+    {"<+1030>-10:30<+11>-11,M10.1.0,M4.1.0", 11 * HOUR, {
+        {2024, 4, 6, 15, 0, 10 * HOUR + 1800}, {2024, 10, 5, 15, 30, 11 * HOUR},
+        {2025, 4, 5, 15, 0, 10 * HOUR + 1800}, {2025, 10, 4, 15, 30, 11 * HOUR},
+        {2026, 4, 4, 15, 0, 10 * HOUR + 1800}, {2026, 10, 3, 15, 30, 11 * HOUR},
+        {2027, 4, 3, 15, 0, 10 * HOUR + 1800}, {2027, 10, 2, 15, 30, 11 * HOUR},
+    }},
+};
+
+// the offset the table gives for a UTC time in 2024-2027, at[] holds the UTC of the changes
+static int32_t tableOffset(const Zone & z, const uint32_t (&at)[8], uint32_t utc)
+{
+    int32_t offset = z.offset;
+    for (int i = 0; i < 8; i++)
+        if (utc >= at[i])
+            offset = z.changes[i].offset;
+    return offset;
+}
+
+static void testZone(const Zone & z)
+{
+    tz_rule_t rule;
+    CHECK(tz_parse(z.spec, rule));
+    tz_t tz;
+    tz_init(tz, rule);
+    uint32_t at[8];
+    for (int i = 0; i < 8; i++)
+    {
+        const Change & c = z.changes[i];
+        at[i] = utcOf(c.y, c.m, c.d, c.hh, c.mm);
+    }
+
+    // every minute, in order as the clock runs
+    const uint32_t start = utcOf(2024, 1, 1, 0, 0), end = utcOf(2028, 1, 1, 0, 0);
+    int wrong = 0;
+    for (uint32_t utc = start; utc < end; utc += 60)
+    {
+        int32_t expected = tableOffset(z, at, utc);
+        if ((int32_t)(tz_local(tz, utc) - utc) != expected ||
+            strcmp(tz_name(tz), expected == rule.std_offset ? rule.std_name : rule.dst_name) != 0)
+        {
+            if (wrong++ < 5)
+                fprintf(stderr, "%s: utc %u: offset %d, expected %d\n", z.spec, utc, (int)(tz_local(tz, utc) - utc), expected);
+        }
+    }
+    CHECK_EQ(wrong, 0);
+
+    for (int i = 0; i < 8; i++)
+    {
+        const Change & c = z.changes[i];
+        int32_t before = tableOffset(z, at, at[i] - 1);
+
+        // the last second before the change and the change itself, from a fresh cache and
+        // from one that holds the other side
+        tz_t fresh;
+        tz_init(fresh, rule);
+        CHECK_EQ(tz_local(fresh, at[i] - 1), at[i] - 1 + before);
+        CHECK_EQ(tz_local(fresh, at[i]), at[i] + c.offset);
+        tz_init(fresh, rule);
+        CHECK_EQ(tz_local(fresh, at[i]), at[i] + c.offset);
+        CHECK_EQ(tz_local(fresh, at[i] - 1), at[i] - 1 + before);
+
+        // Local times back to UTC around the change. Those that happen twice are taken in
+        // standard time, those skipped as if the clock were still on the old offset.
+        uint32_t local_before = at[i] + before, local_after = at[i] + c.offset;
+        uint32_t first = (local_before < local_after ? local_before : local_after) - HOUR;
+        uint32_t last = (local_before > local_after ? local_before : local_after) + HOUR;
+        for (uint32_t local = first; local <= last; local += 60)
+        {
+            bool earlier = local - before < at[i];         // the old offset gives a time before the change
+            bool later = local - c.offset >= at[i];        // the new one a time after it
+            int32_t std = rule.std_offset;
+            uint32_t expected;
+            if (earlier && later)
+                expected = local - std;
+            else if (earlier)
+                expected = local - before;
+            else if (later)
+                expected = local - c.offset;
+            else
+                expected = local - std;
+            CHECK_EQ(tz_utc(tz, local), expected);
+        }
+    }
+}
+
+// the examples of the documentation: the skipped and the repeated half hour, both hemispheres
+static void testLocalToUtc()
+{
+    struct { const char * spec; int y, m, d, hh, mm; uint32_t utc; } cases[] = {
+        {"EST5EDT", 2026, 3, 8, 2, 30, utcOf(2026, 3, 8, 7, 30)},       // skipped
+        {"EST5EDT", 2026, 11, 1, 1, 30, utcOf(2026, 11, 1, 6, 30)},     // twice, EST
+        {"EST5EDT", 2026, 11, 1, 0, 30, utcOf(2026, 11, 1, 4, 30)},     // EDT
+        {"CET-1CEST,M3.5.0,M10.5.0/3", 2026, 3, 29, 2, 30, utcOf(2026, 3, 29, 1, 30)},
+        {"CET-1CEST,M3.5.0,M10.5.0/3", 2026, 10, 25, 2, 30, utcOf(2026, 10, 25, 1, 30)},
+        {"AEST-10AEDT,M10.1.0,M4.1.0/3", 2026, 10, 4, 2, 30, utcOf(2026, 10, 3, 16, 30)},
+        {"AEST-10AEDT,M10.1.0,M4.1.0/3", 2026, 4, 5, 2, 30, utcOf(2026, 4, 4, 16, 30)},
+        {"AEST-10AEDT,M10.1.0,M4.1.0/3", 2026, 1, 1, 0, 0, utcOf(2025, 12, 31, 13, 0)},
+    };
+    for (const auto & c : cases)
+    {
+        tz_rule_t rule;
+        CHECK(tz_parse(c.spec, rule));
+        tz_t tz;
+        tz_init(tz, rule);
+        CHECK_EQ(tz_utc(tz, utcOf(c.y, c.m, c.d, c.hh, c.mm)), c.utc);
+    }
+}
+
+// The same strings read by the C library, every 15 minutes of 2000-2099. Zones without rules are
+// left out, the C library would look those up in the tz database with its older US rules, and so
+// are changes close to the new year: glibc takes a rule's year from the UTC date.
+static void testAgainstLibc()
+{
+    static const char * const specs[] = {
+        "CET-1CEST,M3.5.0,M10.5.0/3",
+        "EST5EDT,M3.2.0,M11.1.0",
+        "AEST-10AEDT,M10.1.0,M4.1.0/3",
+        "NZST-12NZDT,M9.5.0,M4.1.0/3",
+        "<+1030>-10:30<+11>-11,M10.1.0,M4.1.0",
+        "<-02>2<-01>,M3.5.0/-1,M10.5.0/0",
+        "IST-2IDT,M3.4.4/26,M10.5.0",
+        "WET0WEST,M3.5.0/1,M10.5.0",
+        "XXX3YYY,J60,J300",
+        "XXX3YYY,59,300/1:30",
+        "<+0545>-5:45<+0645>,J32/0,J334/23",
+        "JST-9",
+        "<+0530>-5:30",
+        "<-0330>3:30",
+    };
+    const uint32_t start = TZ_UNIX_2000, end = utcOf(2100, 1, 1, 0, 0);
+    for (const char * spec : specs)
+    {
+        tz_rule_t rule;
+        CHECK(tz_parse(spec, rule));
+        tz_t tz;
+        tz_init(tz, rule);
+        setenv("TZ", spec, 1);
+        tzset();
+
+        int wrong = 0;
+        for (uint32_t utc = start; utc < end; utc += 900)
+        {
+            time_t t = utc;
+            struct tm lt;
+            localtime_r(&t, &lt);
+            uint32_t local = tz_local(tz, utc);
+            if ((int32_t)(local - utc) != lt.tm_gmtoff || tz.dst != (lt.tm_isdst > 0))
+            {
+                if (wrong++ < 5)
+                    fprintf(stderr, "%s: utc %u: offset %d, libc %ld\n", spec, utc, (int)(local - utc), lt.tm_gmtoff);
+            }
+        }
+        CHECK_EQ(wrong, 0);
+    }
+    unsetenv("TZ");
+    tzset();
+}
+
+static void testParse()
+{
+    tz_rule_t r;
+    CHECK(tz_parse("UTC0", r));
+    CHECK_EQ(r.std_offset, 0);
+    CHECK_EQ(r.dst_name[0], '\0');
+    CHECK(tz_parse("<+0530>-5:30", r));
+    CHECK_EQ(r.std_offset, 5 * HOUR + 1800);
+    CHECK(strcmp(r.std_name, "+0530") == 0);
+    CHECK(tz_parse("EST5EDT4,M3.2.0/2:00:00,M11.1.0/2:00:00", r));
+    CHECK_EQ(r.dst_offset, -4 * HOUR);
+    CHECK_EQ(r.start.month, 3);
+    CHECK_EQ(r.start.week, 2);
+    CHECK_EQ(r.end.time, 2 * HOUR);
+
+    static const char * const bad[] = {
+        "", "UT0", "CET", "CET-1CEST,M3.5.0", "CET-1CEST,M13.5.0,M10.5.0", "CET-1CEST,M3.6.0,M10.5.0",
+        "CET-1CEST,M3.5.7,M10.5.0", "CET-1CEST,J0,J10", "CET-1CEST,J366,J10", "CET-1CEST,M3.5.0,M10.5.0/168",
+        "CET-25", "CET-1:60", "<+05", "TOOLONGNAME-1", "CET-1CEST,M3.5.0,M10.5.0,", "CET-1 ",
+    };
+    for (const char * s : bad)
+    {
+        if (tz_parse(s, r))
+            fprintf(stderr, "accepted \"%s\"\n", s);
+        CHECK(!tz_parse(s, r));
+    }
+}
+
+// the RTC's calendar against the C library's, every day of 2000-2099
+static void testCalendar()
+{
+    for (uint32_t day = TZ_UNIX_2000; day < utcOf(2100, 1, 1, 0, 0); day += 86400)
+    {
+        uint32_t t = day + 12 * HOUR + 34 * 60 + 56;
+        time_t tt = t;
+        struct tm g;
+        gmtime_r(&tt, &g);
+
+        rv3028::rv3028_date_t date;
+        rv3028::rv3028_time_t time;
+        tz_civil(t, date, time);
+        CHECK_EQ(date.year, g.tm_year - 100);
+        CHECK_EQ(date.month, g.tm_mon + 1);
+        CHECK_EQ(date.date, g.tm_mday);
+        CHECK_EQ(date.weekday, g.tm_wday);
+        CHECK_EQ(time.hours, 12);
+        CHECK_EQ(time.minutes, 34);
+        CHECK_EQ(time.seconds, 56);
+        CHECK_EQ(tz_unix(date, time), t);
+    }
+
+    // month lengths, the leap years the RTC sees and the century rules around them
+    for (int y = 1900; y <= 2400; y++)
+        for (uint32_t m = 1; m <= 12; m++)
+            CHECK_EQ(tz_month_days(y, m), (utcOf(m == 12 ? y + 1 : y, m == 12 ? 1 : m + 1, 1, 0, 0) - utcOf(y, m, 1, 0, 0)) / 86400);
+    CHECK_EQ(tz_month_days(2024, 2), 29);
+    CHECK_EQ(tz_month_days(2026, 2), 28);
+    CHECK_EQ(tz_month_days(2000, 2), 29);
+    CHECK_EQ(tz_month_days(2100, 2), 28);
+}
+
+int main()
+{
+    testParse();
+    testCalendar();
+    for (const Zone & z : zones)
+        testZone(z);
+    testLocalToUtc();
+    testAgainstLibc();
+    return check_result();
+}
@@ -0,0 +1,76 @@
+/**
+ * animation.cpp
+ *
+ * Delta encoding of looping sprite animations.
+ */
+
+#include "animation.h"
+
+#include <cmath>
+#include <stdexcept>
+
+size_t Animation::memory() const
+{
+    // sizeof(sprite_span_t) is 6 on the target
+    return data.size() + 6 * spans.size() + 2 * frame_spans.size();
+}
+
+unsigned Animation::bytesPerSecond() const
+{
+    size_t bytes = 0;
+    for (const Span & s : spans)
+        bytes += s.len + SPAN_OVERHEAD;
+    return std::lround(bytes / (frame_count * frame_ms / 1000.0));
+}
+
+Animation encodeAnimation(const std::vector<std::vector<uint8_t>> & frames, int width, int frame_ms, int max_gap)
+{
+    Animation a;
+    a.key = frames.front();
+    a.width = width;
+    a.pages = frames.front().size() / width;
+    a.frame_count = frames.size();
+    a.frame_ms = frame_ms;
+
+    for (size_t f = 0; f < frames.size(); f++)
+    {
+        const auto & from = frames[f];
+        const auto & to = frames[(f + 1) % frames.size()];
+        if (from.size() != to.size())
+            throw std::runtime_error("animation frames differ in size");
+
+        a.frame_spans.push_back(a.spans.size());
+        for (int page = 0; page < a.pages; page++)
+        {
+            const uint8_t * pf = &from[page * width];
+            const uint8_t * pt = &to[page * width];
+            int col = 0;
+            while (col < width)
+            {
+                if (pf[col] == pt[col])
+                {
+                    col++;
+                    continue;
+                }
+
+                // extend the span while the next change is close enough
+                int start = col;
+                int end = col;
+                for (int c = col + 1; c < width && c - end <= max_gap; c++)
+                    if (pf[c] != pt[c])
+                        end = c;
+
+                Span s;
+                s.page = page;
+                s.col = start;
+                s.len = end - start + 1;
+                s.offset = a.data.size();
+                a.spans.push_back(s);
+                a.data.insert(a.data.end(), pt + start, pt + end + 1);
+                col = end + 1;
+            }
+        }
+    }
+    a.frame_spans.push_back(a.spans.size());
+    return a;
+}
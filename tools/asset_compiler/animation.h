@@ -0,0 +1,45 @@
+/**
+ * animation.h
+ *
+ * Delta encoding of looping sprite animations, see src/sprite_anim.h for the format.
+ */
+
+#ifndef ASSET_COMPILER_ANIMATION_H
+#define ASSET_COMPILER_ANIMATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// i2c bytes spent on each span besides its data: two address bytes, two control bytes and the
+// six column/page window commands
+#define SPAN_OVERHEAD 10
+
+struct Span {
+    uint8_t page;
+    uint8_t col;
+    uint8_t len;
+    uint16_t offset;
+};
+
+struct Animation {
+    std::vector<uint8_t> key;
+    std::vector<uint8_t> data;
+    std::vector<Span> spans;
+    std::vector<uint16_t> frame_spans;
+    int width = 0;
+    int pages = 0;
+    int frame_count = 0;
+    int frame_ms = 0;
+
+    // flash used, without the key frame
+    size_t memory() const;
+    // i2c bytes per second while playing
+    unsigned bytesPerSecond() const;
+};
+
+// Changed bytes on a page at most max_gap columns apart share a span, resending a few unchanged
+// bytes is cheaper than opening a new window.
+Animation encodeAnimation(const std::vector<std::vector<uint8_t>> & frames, int width, int frame_ms, int max_gap = 8);
+
+#endif // ASSET_COMPILER_ANIMATION_H
@@ -0,0 +1,195 @@
+/**
+ * image.cpp
+ *
+ * Loading PNG images and converting them to page packed SSD1306 buffers.
+ */
+
+#include "image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <png.h>
+#include <stdexcept>
+#include <string>
+
+GreyImage loadPng(const std::string & filename)
+{
+    png_image png = {};
+    png.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&png, filename.c_str()))
+        throw std::runtime_error(filename + ": " + png.message);
+
+    png.format = PNG_FORMAT_RGBA;
+    std::vector<uint8_t> rgba(PNG_IMAGE_SIZE(png));
+    if (!png_image_finish_read(&png, nullptr, rgba.data(), 0, nullptr))
+    {
+        png_image_free(&png);
+        throw std::runtime_error(filename + ": " + png.message);
+    }
+
+    GreyImage img;
+    img.width = png.width;
+    img.height = png.height;
+    img.pixels.resize(img.width * img.height);
+    for (size_t i = 0; i < img.pixels.size(); i++)
+    {
+        const uint8_t * p = &rgba[i * 4];
+        float luma = (0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2]) / 255.0f;
+        img.pixels[i] = luma * p[3] / 255.0f;
+    }
+    return img;
+}
+
+GreyImage shrink(const GreyImage & img, int factor)
+{
+    if (factor < 1 || img.width % factor || img.height % factor)
+        throw std::runtime_error("size is not a multiple of shrink=" + std::to_string(factor));
+
+    GreyImage out;
+    out.width = img.width / factor;
+    out.height = img.height / factor;
+    out.pixels.resize(out.width * out.height);
+    for (int y = 0; y < out.height; y++)
+        for (int x = 0; x < out.width; x++)
+        {
+            float sum = 0;
+            for (int dy = 0; dy < factor; dy++)
+                for (int dx = 0; dx < factor; dx++)
+                    sum += img.pixels[(y * factor + dy) * img.width + x * factor + dx];
+            out.pixels[y * out.width + x] = sum / (factor * factor);
+        }
+    return out;
+}
+
+GreyImage crop(const GreyImage & img, int x, int width)
+{
+    if (x < 0 || width < 1 || x + width > img.width)
+        throw std::runtime_error("crop outside the image");
+
+    GreyImage out;
+    out.width = width;
+    out.height = img.height;
+    out.pixels.resize(out.width * out.height);
+    for (int y = 0; y < out.height; y++)
+        std::copy_n(&img.pixels[y * img.width + x], width, &out.pixels[y * width]);
+    return out;
+}
+
+static std::vector<bool> toBits(const GreyImage & img, const ConvertOptions & opt)
+{
+    std::vector<bool> bits(img.pixels.size());
+
+    switch (opt.dither)
+    {
+        case Dither::NONE:
+            for (size_t i = 0; i < bits.size(); i++)
+                bits[i] = img.pixels[i] > opt.threshold;
+            break;
+
+        case Dither::ORDERED:
+        {
+            // 4x4 Bayer matrix, centred on the threshold
+            static const int bayer[4][4] = {
+                { 0,  8,  2, 10},
+                {12,  4, 14,  6},
+                { 3, 11,  1,  9},
+                {15,  7, 13,  5},
+            };
+            for (int y = 0; y < img.height; y++)
+                for (int x = 0; x < img.width; x++)
+                {
+                    float t = opt.threshold + (bayer[y % 4][x % 4] - 7.5f) / 16.0f;
+                    bits[y * img.width + x] = img.pixels[y * img.width + x] > t;
+                }
+            break;
+        }
+
+        case Dither::FLOYD_STEINBERG:
+        {
+            std::vector<float> px = img.pixels;
+            auto spread = [&](int x, int y, float err) {
+                if (x >= 0 && x < img.width && y < img.height)
+                    px[y * img.width + x] += err;
+            };
+            for (int y = 0; y < img.height; y++)
+                for (int x = 0; x < img.width; x++)
+                {
+                    float v = px[y * img.width + x];
+                    bool lit = v > opt.threshold;
+                    bits[y * img.width + x] = lit;
+                    float err = v - (lit ? 1.0f : 0.0f);
+                    spread(x + 1, y,     err * 7 / 16);
+                    spread(x - 1, y + 1, err * 3 / 16);
+                    spread(x,     y + 1, err * 5 / 16);
+                    spread(x + 1, y + 1, err * 1 / 16);
+                }
+            break;
+        }
+    }
+
+    if (opt.invert)
+        bits.flip();
+    return bits;
+}
+
+std::vector<uint8_t> toOledBuffer(const GreyImage & img, const ConvertOptions & opt)
+{
+    if (img.height % 8 != 0)
+        throw std::runtime_error("image height " + std::to_string(img.height) + " is not a multiple of 8");
+
+    std::vector<bool> bits = toBits(img, opt);
+    std::vector<uint8_t> buf;
+    buf.reserve(img.width * img.height / 8);
+    for (int page = 0; page < img.height / 8; page++)
+        for (int x = 0; x < img.width; x++)
+        {
+            uint8_t b = 0;
+            for (int row = 0; row < 8; row++)
+                if (bits[(page * 8 + row) * img.width + x])
+                    b |= 1 << row;
+            buf.push_back(b);
+        }
+    return buf;
+}
+
+std::vector<std::vector<uint8_t>> toGrayPlanes(const GreyImage & img, int bits)
+{
+    int levels = (1 << bits) - 1;
+    std::vector<std::vector<uint8_t>> planes;
+    for (int p = 0; p < bits; p++)
+    {
+        GreyImage plane = img;
+        for (size_t i = 0; i < img.pixels.size(); i++)
+        {
+            int level = std::lround(std::clamp(img.pixels[i], 0.0f, 1.0f) * levels);
+            plane.pixels[i] = (level >> p) & 1;
+        }
+        planes.push_back(toOledBuffer(plane, ConvertOptions{0.5f}));
+    }
+    return planes;
+}
+
+std::vector<uint8_t> graySchedule(int bits)
+{
+    std::vector<uint8_t> schedule;
+    for (int i = 1; i < (1 << bits); i++)
+        schedule.push_back(bits - 1 - __builtin_ctz(i));
+    return schedule;
+}
+
+float grayMaxError(const GreyImage & img, const std::vector<std::vector<uint8_t>> & planes,
+                   const std::vector<uint8_t> & schedule)
+{
+    float max_error = 0;
+    for (int y = 0; y < img.height; y++)
+        for (int x = 0; x < img.width; x++)
+        {
+            int on = 0;
+            for (uint8_t p : schedule)
+                on += (planes[p][(y / 8) * img.width + x] >> (y % 8)) & 1;
+            float average = (float)on / schedule.size();
+            float source = std::clamp(img.pixels[y * img.width + x], 0.0f, 1.0f);
+            max_error = std::max(max_error, std::fabs(average - source));
+        }
+    return max_error;
+}
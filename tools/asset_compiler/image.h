@@ -0,0 +1,60 @@
+/**
+ * image.h
+ *
+ * Loading PNG images and converting them to page packed SSD1306 buffers.
+ */
+
+#ifndef ASSET_COMPILER_IMAGE_H
+#define ASSET_COMPILER_IMAGE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class Dither {
+    NONE,
+    FLOYD_STEINBERG,
+    ORDERED
+};
+
+struct ConvertOptions {
+    float threshold = 0.3f;    // luminance above which a pixel is lit
+    Dither dither = Dither::NONE;
+    bool invert = false;
+};
+
+// grey levels in 0..1, row major
+struct GreyImage {
+    int width = 0;
+    int height = 0;
+    std::vector<float> pixels;
+};
+
+// Load a PNG as luminance, transparent pixels count as black. Throws std::runtime_error.
+GreyImage loadPng(const std::string & filename);
+
+// Box filter down by an integer factor, for smaller variants of the same artwork. Width and
+// height must be multiples of factor.
+GreyImage shrink(const GreyImage & img, int factor);
+
+// Keep only the columns x to x + width - 1, to trim blank borders off artwork.
+GreyImage crop(const GreyImage & img, int x, int width);
+
+// Threshold or dither to 1 bit and pack into SSD1306 pages: one byte per column per 8 rows,
+// least significant bit on top. Height must be a multiple of 8.
+std::vector<uint8_t> toOledBuffer(const GreyImage & img, const ConvertOptions & opt);
+
+// Quantise to 2^bits gray levels and split into one page packed buffer per bit plane, least
+// significant first.
+std::vector<std::vector<uint8_t>> toGrayPlanes(const GreyImage & img, int bits);
+
+// Order in which the planes are shown over one cycle, plane p appears 2^p times. Frame i shows
+// plane bits - 1 - ctz(i), which spreads the heavy planes evenly: 1 0 1, or 2 1 2 0 2 1 2.
+std::vector<uint8_t> graySchedule(int bits);
+
+// Emulate a cycle of the panel showing the planes and return the largest difference between
+// the time averaged brightness of a pixel and the source image, in 0..1.
+float grayMaxError(const GreyImage & img, const std::vector<std::vector<uint8_t>> & planes,
+                   const std::vector<uint8_t> & schedule);
+
+#endif // ASSET_COMPILER_IMAGE_H
@@ -0,0 +1,551 @@
+/**
+ * main.cpp
+ *
+ * asset_compiler: converts the PNG images listed in a manifest into arrays of raw data that can
+ * be fed directly to the SSD1306 OLED driver. Runs as a build step of the firmware.
+ *
+ * usage: asset_compiler <manifest> <output dir>
+ *
+ * Manifest lines, paths are relative to the manifest:
+ *   image <array name> <png> [threshold=0.3] [dither=none|floyd|ordered] [invert] [rle]
+ *   anim  <array name> <png>... frame_ms=<ms> [key=<image array name>] [threshold=...] [dither=...]
+ *   gray  <array name> <png> [bits=2]
+ *   theme <name>
+ *
+ * Any entry may take crop=<x>,<width>, which keeps only those columns of the PNG, and
+ * shrink=<n>, which then scales it down by n so smaller panels can reuse the same artwork.
+ *
+ * The image entries after a theme line belong to that theme and replace the built-in image of
+ * the same name, at the same size. Themes go to an asset pack instead of the firmware, see
+ * src/asset_pack_format.h: asset_pack.bin, and asset_pack.txt with the serial commands that
+ * write it into the clock's flash.
+ *
+ * Writes oled_static_data.c/.h with every image plus a glyph table, and oled_animations.c/.h.
+ * Images marked rle are run length encoded (see src/oled_glyph.h) when that makes them smaller,
+ * they are then only reachable through the glyph table. Gray images are split into bit planes
+ * for temporal dithering, see oled_gray_t in src/oled_glyph.h.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "animation.h"
+#include "image.h"
+#include "rle.h"
+
+extern "C" {
+#include "oled_glyph.h"
+}
+#include "asset_pack_format.h"
+
+namespace fs = std::filesystem;
+
+#define STATIC_NAME "oled_static_data"
+#define ANIM_NAME   "oled_animations"
+#define PACK_NAME   "asset_pack"
+
+struct ImageAsset {
+    std::string name;
+    int width;
+    int pages;
+    std::vector<uint8_t> buf;
+    std::vector<uint8_t> rle;   // empty unless encoding made it smaller
+
+    const std::vector<uint8_t> & data() const { return rle.empty() ? buf : rle; }
+    std::string dataName() const { return rle.empty() ? name : name + "_rle"; }
+};
+
+struct GrayAsset {
+    std::string name;
+    int width;
+    int pages;
+    int bits;
+    std::vector<std::vector<uint8_t>> planes;
+    std::vector<uint8_t> schedule;
+};
+
+struct ThemeAsset {
+    std::string name;
+    std::vector<ImageAsset> images;
+    std::vector<int> glyphs;    // index of the built-in image each one replaces
+};
+
+struct AnimAsset {
+    std::string name;
+    std::string key_name;   // empty when the key frame is emitted with the animation
+    Animation anim;
+};
+
+static std::string upper(std::string s)
+{
+    for (char & c : s)
+        c = toupper(c);
+    return s;
+}
+
+static std::string glyphId(const std::string & name)
+{
+    std::string id = name.rfind("oled_", 0) == 0 ? name.substr(5) : name;
+    return "OLED_GLYPH_" + upper(id);
+}
+
+static std::string glyphInit(const std::string & data_name, size_t size, int width, int pages, bool rle)
+{
+    return "{" + data_name + ", " + std::to_string(size) + ", " + std::to_string(width) + ", "
+           + std::to_string(pages) + (rle ? ", OLED_GLYPH_RLE}" : ", OLED_GLYPH_RAW}");
+}
+
+static std::string cArray(const std::string & decl, const std::string & name, const std::vector<uint8_t> & data)
+{
+    std::string s = decl + " " + name + "[" + std::to_string(data.size()) + "] = {\n\t";
+    char hex[8];
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        snprintf(hex, sizeof(hex), i + 1 < data.size() ? "0x%02X," : "0x%02X\n", data[i]);
+        s += hex;
+        if ((i + 1) % 32 == 0 && i + 1 < data.size())
+            s += "\n\t";
+    }
+    return s + "};\n";
+}
+
+// only touch outputs that changed, so unchanged assets don't trigger a rebuild
+static void writeIfChanged(const fs::path & path, const std::string & content)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (in)
+    {
+        std::stringstream old;
+        old << in.rdbuf();
+        if (old.str() == content)
+            return;
+    }
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        throw std::runtime_error("cannot write " + path.string());
+    out << content;
+}
+
+static ConvertOptions parseOptions(std::vector<std::string> & args, std::map<std::string, std::string> & extra)
+{
+    // pulls key=value and flag options out of args, leaving the positional arguments
+    ConvertOptions opt;
+    std::vector<std::string> positional;
+    for (const auto & a : args)
+    {
+        auto eq = a.find('=');
+        if (a == "invert")
+            opt.invert = true;
+        else if (a == "rle")
+            extra[a] = "1";
+        else if (eq == std::string::npos)
+            positional.push_back(a);
+        else
+        {
+            std::string key = a.substr(0, eq);
+            std::string val = a.substr(eq + 1);
+            if (key == "threshold")
+                opt.threshold = std::stof(val);
+            else if (key == "dither" && val == "none")
+                opt.dither = Dither::NONE;
+            else if (key == "dither" && val == "floyd")
+                opt.dither = Dither::FLOYD_STEINBERG;
+            else if (key == "dither" && val == "ordered")
+                opt.dither = Dither::ORDERED;
+            else if (key == "dither")
+                throw std::runtime_error("unknown dither " + val);
+            else
+                extra[key] = val;
+        }
+    }
+    args = positional;
+    return opt;
+}
+
+static GreyImage loadImage(const fs::path & path, std::map<std::string, std::string> & extra)
+{
+    GreyImage img = loadPng(path.string());
+    if (extra.count("crop"))
+    {
+        const std::string & c = extra["crop"];
+        auto comma = c.find(',');
+        if (comma == std::string::npos)
+            throw std::runtime_error("crop needs <x>,<width>");
+        img = crop(img, std::stoi(c.substr(0, comma)), std::stoi(c.substr(comma + 1)));
+    }
+    if (extra.count("shrink"))
+        img = shrink(img, std::stoi(extra["shrink"]));
+    return img;
+}
+
+static std::string graySource(const std::vector<GrayAsset> & grays)
+{
+    std::string c;
+    for (const auto & g : grays)
+    {
+        std::vector<uint8_t> planes;
+        for (const auto & p : g.planes)
+            planes.insert(planes.end(), p.begin(), p.end());
+        c += cArray("static const uint8_t", g.name + "_planes", planes) + "\n";
+        c += cArray("static const uint8_t", g.name + "_schedule", g.schedule) + "\n";
+        c += "const oled_gray_t " + g.name + " = {\n\t" + g.name + "_planes, " + g.name + "_schedule, "
+             + std::to_string(g.width) + ", " + std::to_string(g.pages) + ", " + std::to_string(g.bits) + ", "
+             + std::to_string(g.schedule.size()) + "\n};\n\n";
+    }
+    return c;
+}
+
+static std::string staticSource(const std::vector<ImageAsset> & images, const std::vector<GrayAsset> & grays)
+{
+    std::string c = "// This file is autogenerated by asset_compiler\n#include \"" STATIC_NAME ".h\"\n\n";
+    for (const auto & img : images)
+        c += cArray(img.rle.empty() ? "const uint8_t" : "static const uint8_t", img.dataName(), img.data()) + "\n";
+
+    c += "const oled_glyph_t oled_glyphs[OLED_GLYPH_COUNT] = {\n";
+    // appended in pieces, a literal + temporary string trips -Wrestrict in GCC 12
+    for (const auto & img : images)
+    {
+        c += '\t';
+        c += glyphInit(img.dataName(), img.data().size(), img.width, img.pages, !img.rle.empty());
+        c += ",\n";
+    }
+    c += "};\n";
+    if (!grays.empty())
+        c += "\n" + graySource(grays);
+    return c;
+}
+
+static std::string staticHeader(const std::vector<ImageAsset> & images, const std::vector<GrayAsset> & grays)
+{
+    std::string guard = upper(STATIC_NAME) + "_H";
+    std::string h = "// This file is autogenerated by asset_compiler\n#ifndef " + guard + "\n#define " + guard + "\n";
+    h += "#include <stdint.h>\n#include \"oled_glyph.h\"\n\n";
+    for (const auto & img : images)
+        if (img.rle.empty())
+            h += "extern const uint8_t " + img.name + "[" + std::to_string(img.buf.size()) + "];\n\n";
+
+    h += "enum {\n";
+    for (const auto & img : images)
+        h += "    " + glyphId(img.name) + ",\n";
+    h += "    OLED_GLYPH_COUNT\n};\n\n";
+    h += "extern const oled_glyph_t oled_glyphs[OLED_GLYPH_COUNT];\n\n";
+    for (const auto & g : grays)
+        h += "extern const oled_gray_t " + g.name + ";\n\n";
+    h += "#endif // " + guard + "\n";
+    return h;
+}
+
+static std::string animSource(const std::vector<AnimAsset> & anims)
+{
+    std::string c = "// This file is autogenerated by asset_compiler\n#include <stdint.h>\n"
+                    "#include \"" STATIC_NAME ".h\"\n#include \"" ANIM_NAME ".h\"\n\n";
+    for (const auto & a : anims)
+    {
+        std::string key = "&oled_glyphs[" + glyphId(a.key_name) + "]";
+        if (a.key_name.empty())
+        {
+            c += cArray("static const uint8_t", a.name + "_key_data", a.anim.key) + "\n";
+            c += "static const oled_glyph_t " + a.name + "_key = "
+                 + glyphInit(a.name + "_key_data", a.anim.key.size(), a.anim.width, a.anim.pages, false) + ";\n\n";
+            key = "&" + a.name + "_key";
+        }
+        c += cArray("static const uint8_t", a.name + "_data", a.anim.data) + "\n";
+
+        c += "static const sprite_span_t " + a.name + "_spans[" + std::to_string(a.anim.spans.size()) + "] = {\n";
+        for (size_t i = 0; i < a.anim.spans.size(); i++)
+        {
+            const Span & s = a.anim.spans[i];
+            c += "\t{" + std::to_string(s.page) + ", " + std::to_string(s.col) + ", " + std::to_string(s.len) + ", "
+                 + std::to_string(s.offset) + "}" + (i + 1 < a.anim.spans.size() ? ",\n" : "\n");
+        }
+        c += "};\n\n";
+
+        c += "static const uint16_t " + a.name + "_frames[" + std::to_string(a.anim.frame_spans.size()) + "] = {\n\t";
+        for (size_t i = 0; i < a.anim.frame_spans.size(); i++)
+            c += std::to_string(a.anim.frame_spans[i]) + (i + 1 < a.anim.frame_spans.size() ? ", " : "\n");
+        c += "};\n\n";
+
+        c += "const sprite_anim_t " + a.name + " = {\n";
+        c += "\t" + key + ", " + a.name + "_data, " + a.name + "_spans, " + a.name + "_frames,\n";
+        c += "\t" + std::to_string(a.anim.width) + ", " + std::to_string(a.anim.pages) + ", "
+             + std::to_string(a.anim.frame_count) + ", " + std::to_string(a.anim.frame_ms) + "\n};\n\n";
+    }
+    return c;
+}
+
+static std::string animReport(const AnimAsset & a)
+{
+    size_t memory = a.anim.memory() + (a.key_name.empty() ? a.anim.key.size() : 0);
+    return a.name + ": " + std::to_string(a.anim.frame_count) + " frames every " + std::to_string(a.anim.frame_ms)
+           + " ms, " + std::to_string(memory) + " bytes of flash, " + std::to_string(a.anim.bytesPerSecond())
+           + " bytes/s on the bus";
+}
+
+static std::string animHeader(const std::vector<AnimAsset> & anims)
+{
+    std::string guard = upper(ANIM_NAME) + "_H";
+    std::string h = "// This file is autogenerated by asset_compiler\n#ifndef " + guard + "\n#define " + guard + "\n";
+    h += "#include \"sprite_anim.h\"\n\n";
+    for (const auto & a : anims)
+        h += "// " + animReport(a) + "\nextern const sprite_anim_t " + a.name + ";\n\n";
+    h += "#endif // " + guard + "\n";
+    return h;
+}
+
+static_assert(sizeof(asset_pack_header_t) == 20 && sizeof(asset_pack_entry_t) == 12,
+              "the pack layout is written as the structs are laid out on a little endian host");
+
+template <class T>
+static void putAt(std::vector<uint8_t> & out, size_t offset, const T & value)
+{
+    memcpy(out.data() + offset, &value, sizeof(value));
+}
+
+static std::vector<uint8_t> packData(const std::vector<ThemeAsset> & themes, size_t glyph_count)
+{
+    if (themes.size() > ASSET_PACK_MAX_THEMES)
+        throw std::runtime_error("more than " + std::to_string(ASSET_PACK_MAX_THEMES) + " themes");
+
+    size_t entry_count = 0;
+    for (const auto & t : themes)
+        entry_count += t.images.size();
+    size_t names = sizeof(asset_pack_header_t);
+    size_t entries = names + themes.size() * ASSET_PACK_NAME_LEN;
+    std::vector<uint8_t> pack(entries + entry_count * sizeof(asset_pack_entry_t));
+
+    size_t e = 0;
+    for (size_t t = 0; t < themes.size(); t++)
+    {
+        memcpy(pack.data() + names + t * ASSET_PACK_NAME_LEN, themes[t].name.data(), themes[t].name.size());
+        for (size_t i = 0; i < themes[t].images.size(); i++)
+        {
+            const ImageAsset & img = themes[t].images[i];
+            asset_pack_entry_t entry = {(uint32_t)pack.size(), (uint16_t)img.data().size(), (uint8_t)(t + 1),
+                                        (uint8_t)themes[t].glyphs[i], (uint8_t)img.width, (uint8_t)img.pages,
+                                        (uint8_t)(img.rle.empty() ? OLED_GLYPH_RAW : OLED_GLYPH_RLE), 0};
+            putAt(pack, entries + e++ * sizeof(entry), entry);
+            pack.insert(pack.end(), img.data().begin(), img.data().end());
+        }
+    }
+
+    // whole flash pages, padded as erased flash reads
+    pack.resize((pack.size() + ASSET_PACK_PAGE - 1) / ASSET_PACK_PAGE * ASSET_PACK_PAGE, 0xFF);
+    if (pack.size() > ASSET_PACK_MAX_SIZE)
+        throw std::runtime_error("asset pack of " + std::to_string(pack.size()) + " bytes doesn't fit its partition");
+
+    asset_pack_header_t h = {ASSET_PACK_MAGIC, ASSET_PACK_VERSION, (uint16_t)glyph_count, (uint32_t)pack.size(), 0,
+                             (uint16_t)entry_count, (uint8_t)themes.size(), 0};
+    h.crc = asset_pack_crc(pack.data() + sizeof(h), pack.size() - sizeof(h));
+    putAt(pack, 0, h);
+    return pack;
+}
+
+// one pack command per 32 bytes, each to be sent once the clock answered the one before
+static std::string packCommands(const std::vector<uint8_t> & pack)
+{
+    std::string s;
+    char word[32];  // "pack " and up to 16 hex digits
+    for (size_t offset = 0; offset < pack.size(); offset += 32)
+    {
+        snprintf(word, sizeof(word), "pack %zx", offset);
+        s += word;
+        for (size_t i = offset; i < offset + 32; i += 4)
+        {
+            uint32_t w = pack[i] | pack[i + 1] << 8 | pack[i + 2] << 16 | (uint32_t)pack[i + 3] << 24;
+            snprintf(word, sizeof(word), " %08x", w);
+            s += word;
+        }
+        s += "\n";
+    }
+    return s;
+}
+
+static void compress(ImageAsset & img)
+{
+    std::vector<uint8_t> rle = rleEncode(img.buf, img.width);
+    if (rle.size() >= img.buf.size())
+    {
+        printf("asset_compiler: %s: %zu bytes, not compressible\n", img.name.c_str(), img.buf.size());
+        return;
+    }
+
+    // decode with the firmware's decoder, a few times to get a measurable time
+    oled_glyph_t g = {rle.data(), (uint16_t)rle.size(), (uint8_t)img.width, (uint8_t)img.pages, OLED_GLYPH_RLE};
+    std::vector<uint8_t> check(img.buf.size());
+    const int rounds = 1000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+        oled_glyph_decode(&g, check.data(), img.width);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rounds;
+    if (check != img.buf || !oled_glyph_valid(&g))
+        throw std::runtime_error("rle round trip failed");
+
+    printf("asset_compiler: %s: %zu -> %zu bytes (%.0f%%), decodes in %.2f us on the host\n",
+           img.name.c_str(), img.buf.size(), rle.size(), 100.0 * rle.size() / img.buf.size(), us);
+    img.rle = std::move(rle);
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s <manifest> <output dir>\n", argv[0]);
+        return 2;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    fs::path manifest = argv[1];
+    fs::path out_dir = argv[2];
+    fs::path base = manifest.parent_path();
+
+    std::vector<ImageAsset> images;
+    std::vector<GrayAsset> grays;
+    std::vector<AnimAsset> anims;
+    std::vector<ThemeAsset> themes;
+    std::vector<uint8_t> pack;
+
+    try
+    {
+        std::ifstream in(manifest);
+        if (!in)
+            throw std::runtime_error("cannot read " + manifest.string());
+
+        std::string line;
+        int line_no = 0;
+        while (std::getline(in, line))
+        {
+            line_no++;
+            auto hash = line.find('#');
+            if (hash != std::string::npos)
+                line.resize(hash);
+
+            std::istringstream ls(line);
+            std::string kind;
+            if (!(ls >> kind))
+                continue;
+
+            std::vector<std::string> args;
+            for (std::string a; ls >> a;)
+                args.push_back(a);
+            std::map<std::string, std::string> extra;
+            ConvertOptions opt = parseOptions(args, extra);
+
+            try
+            {
+                if (kind == "theme" && args.size() == 1)
+                {
+                    if (args[0].size() >= ASSET_PACK_NAME_LEN)
+                        throw std::runtime_error("theme names have at most " + std::to_string(ASSET_PACK_NAME_LEN - 1) + " characters");
+                    themes.push_back({args[0], {}, {}});
+                }
+                else if (!themes.empty() && kind != "image")
+                {
+                    throw std::runtime_error("themes only hold images");
+                }
+                else if (kind == "image" && args.size() == 2)
+                {
+                    GreyImage img = loadImage(base / args[1], extra);
+                    ImageAsset asset = {args[0], img.width, img.height / 8, toOledBuffer(img, opt), {}};
+                    if (extra.count("rle"))
+                        compress(asset);
+                    if (themes.empty())
+                    {
+                        images.push_back(asset);
+                        continue;
+                    }
+
+                    // a theme image takes the place of a built-in one, the layout stays
+                    ThemeAsset & theme = themes.back();
+                    int glyph = 0;
+                    while (glyph < (int)images.size() && images[glyph].name != asset.name)
+                        glyph++;
+                    if (glyph == (int)images.size())
+                        throw std::runtime_error("no built-in image " + asset.name);
+                    if (asset.width != images[glyph].width || asset.pages != images[glyph].pages)
+                        throw std::runtime_error(asset.name + " is not the size of the built-in one");
+                    for (int g : theme.glyphs)
+                        if (g == glyph)
+                            throw std::runtime_error(asset.name + " twice in theme " + theme.name);
+                    theme.images.push_back(asset);
+                    theme.glyphs.push_back(glyph);
+                }
+                else if (kind == "gray" && args.size() == 2)
+                {
+                    GreyImage img = loadImage(base / args[1], extra);
+                    int bits = extra.count("bits") ? std::stoi(extra["bits"]) : 2;
+                    if (bits < 1 || bits > 3)
+                        throw std::runtime_error("gray images have 1 to 3 bits");
+                    GrayAsset g = {args[0], img.width, img.height / 8, bits, toGrayPlanes(img, bits), graySchedule(bits)};
+
+                    // the average over a cycle may only be off by the quantisation step
+                    float error = grayMaxError(img, g.planes, g.schedule);
+                    if (error > 0.5f / ((1 << bits) - 1) + 1e-4f)
+                        throw std::runtime_error("gray planes don't average to the image");
+                    printf("asset_compiler: %s: %d bit gray, %zu planes of %zu bytes, max error %.3f\n",
+                           g.name.c_str(), bits, g.planes.size(), g.planes[0].size(), error);
+                    grays.push_back(std::move(g));
+                }
+                else if (kind == "anim" && args.size() >= 3 && extra.count("frame_ms"))
+                {
+                    std::vector<std::vector<uint8_t>> frames;
+                    int width = 0;
+                    for (size_t i = 1; i < args.size(); i++)
+                    {
+                        GreyImage img = loadImage(base / args[i], extra);
+                        width = img.width;
+                        frames.push_back(toOledBuffer(img, opt));
+                    }
+                    anims.push_back({args[0], extra.count("key") ? extra["key"] : "",
+                                     encodeAnimation(frames, width, std::stoi(extra["frame_ms"]))});
+                }
+                else
+                {
+                    throw std::runtime_error("malformed " + kind + " entry");
+                }
+            }
+            catch (const std::exception & e)
+            {
+                throw std::runtime_error(manifest.string() + ":" + std::to_string(line_no) + ": " + e.what());
+            }
+        }
+
+        fs::create_directories(out_dir);
+        writeIfChanged(out_dir / STATIC_NAME ".c", staticSource(images, grays));
+        writeIfChanged(out_dir / STATIC_NAME ".h", staticHeader(images, grays));
+        writeIfChanged(out_dir / ANIM_NAME ".c", animSource(anims));
+        writeIfChanged(out_dir / ANIM_NAME ".h", animHeader(anims));
+        if (!themes.empty())
+        {
+            pack = packData(themes, images.size());
+            writeIfChanged(out_dir / PACK_NAME ".bin", std::string(pack.begin(), pack.end()));
+            writeIfChanged(out_dir / PACK_NAME ".txt", packCommands(pack));
+        }
+    }
+    catch (const std::exception & e)
+    {
+        fprintf(stderr, "asset_compiler: %s\n", e.what());
+        return 1;
+    }
+
+    size_t image_bytes = 0;
+    for (const auto & img : images)
+        image_bytes += img.data().size();
+    for (const auto & a : anims)
+        printf("asset_compiler: %s\n", animReport(a).c_str());
+
+    if (!pack.empty())
+        printf("asset_compiler: %zu themes in an asset pack of %zu bytes\n", themes.size(), pack.size());
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("asset_compiler: %zu images (%zu bytes) and %zu animations in %.1f ms\n",
+           images.size(), image_bytes, anims.size(), ms);
+    return 0;
+}
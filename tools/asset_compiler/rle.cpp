@@ -0,0 +1,59 @@
+/**
+ * rle.cpp
+ *
+ * Page oriented run length encoding of glyphs.
+ */
+
+#include "rle.h"
+
+#include <cstddef>
+
+extern "C" {
+#include "oled_glyph.h"
+}
+
+#define MAX_LITERAL 128
+#define MAX_RUN     (0x7F + OLED_RLE_MIN_RUN)
+
+std::vector<uint8_t> rleEncode(const std::vector<uint8_t> & buf, int width)
+{
+    std::vector<uint8_t> out;
+    std::vector<uint8_t> literal;
+
+    auto flushLiteral = [&]() {
+        if (literal.empty())
+            return;
+        out.push_back(literal.size() - 1);
+        out.insert(out.end(), literal.begin(), literal.end());
+        literal.clear();
+    };
+
+    for (size_t page = 0; page < buf.size() / width; page++)
+    {
+        const uint8_t * p = &buf[page * width];
+        int col = 0;
+        while (col < width)
+        {
+            int run = 1;
+            while (col + run < width && run < MAX_RUN && p[col + run] == p[col])
+                run++;
+
+            if (run >= OLED_RLE_MIN_RUN)
+            {
+                flushLiteral();
+                out.push_back(OLED_RLE_RUN_FLAG | (run - OLED_RLE_MIN_RUN));
+                out.push_back(p[col]);
+                col += run;
+            }
+            else
+            {
+                literal.push_back(p[col++]);
+                if (literal.size() == MAX_LITERAL)
+                    flushLiteral();
+            }
+        }
+        // runs and literals never cross a page
+        flushLiteral();
+    }
+    return out;
+}
@@ -0,0 +1,15 @@
+/**
+ * rle.h
+ *
+ * Page oriented run length encoding of glyphs, the format is described in src/oled_glyph.h.
+ */
+
+#ifndef ASSET_COMPILER_RLE_H
+#define ASSET_COMPILER_RLE_H
+
+#include <cstdint>
+#include <vector>
+
+std::vector<uint8_t> rleEncode(const std::vector<uint8_t> & buf, int width);
+
+#endif // ASSET_COMPILER_RLE_H
@@ -0,0 +1,151 @@
+/**
+ * trace_decoder
+ *
+ * Reads the uart output of the clock, from a file or stdin, and prints the trace records in it
+ * as text with their time since boot and the time since the previous record. Everything that
+ * isn't a valid record frame is printed as it is. At the end of the input a summary lists how
+ * often each tracepoint fired.
+ *
+ *   trace_decoder [capture]
+ *   picocom -b 115200 /dev/ttyACM0 | trace_decoder
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+
+#include "trace.h"
+
+struct Stats {
+    uint32_t count = 0;
+    uint64_t first_us = 0;
+    uint64_t last_us = 0;
+};
+
+static bool at_line_start = true;
+
+static bool parseFrame(const std::deque<uint8_t> & in, trace_record_t & rec)
+{
+    uint8_t bytes[sizeof(trace_record_t)];
+    uint8_t check = 0;
+    for (size_t i = 0; i < sizeof(bytes); i++)
+    {
+        bytes[i] = in[1 + i];
+        check ^= bytes[i];
+    }
+    if (check != in[TRACE_FRAME_LEN - 1])
+        return false;
+
+    memcpy(&rec, bytes, sizeof(rec));
+    return (rec.id & ~TRACE_CORE1_BIT) < TRACE_COUNT;
+}
+
+// the first argument is stored in 16 bits, a signed one needs its sign back
+static bool firstArgSigned(const char * format)
+{
+    for (const char * p = strchr(format, '%'); p; p = strchr(p + 2, '%'))
+    {
+        if (p[1] == '%')
+            continue;
+        p += strspn(p + 1, "-+ #0123456789.") + 1;
+        return *p == 'd' || *p == 'i';
+    }
+    return false;
+}
+
+static void printRecord(const trace_record_t & rec, uint64_t time_us, uint64_t delta_us)
+{
+    char text[256];
+    uint16_t id = rec.id & ~TRACE_CORE1_BIT;
+    unsigned a = firstArgSigned(trace_formats[id]) ? (unsigned)(int16_t)rec.a : rec.a;
+    snprintf(text, sizeof(text), trace_formats[id], a, (unsigned)rec.b, (unsigned)rec.c);
+
+    if (!at_line_start)
+        putchar('\n');
+    printf("[%6llu.%06llu +%8llu us] c%d %s\n", (unsigned long long)(time_us / 1000000),
+           (unsigned long long)(time_us % 1000000), (unsigned long long)delta_us,
+           rec.id & TRACE_CORE1_BIT ? 1 : 0, text);
+    at_line_start = true;
+}
+
+int main(int argc, char * argv[])
+{
+    FILE * f = stdin;
+    if (argc > 1 && !(f = fopen(argv[1], "rb")))
+    {
+        fprintf(stderr, "can't open %s\n", argv[1]);
+        return 1;
+    }
+
+    std::deque<uint8_t> in;
+    Stats stats[TRACE_COUNT];
+    bool have_time = false;
+    uint32_t last_raw = 0;
+    uint64_t time_us = 0;
+    bool eof = false;
+
+    while (!eof || !in.empty())
+    {
+        // a frame start needs the whole frame in view before it can be told apart from text
+        while (!eof && in.size() < TRACE_FRAME_LEN)
+        {
+            int c = fgetc(f);
+            if (c == EOF)
+                eof = true;
+            else
+                in.push_back((uint8_t)c);
+        }
+        if (in.empty())
+            break;
+
+        trace_record_t rec;
+        if (in.front() == TRACE_FRAME_START && in.size() >= TRACE_FRAME_LEN && parseFrame(in, rec))
+        {
+            in.erase(in.begin(), in.begin() + TRACE_FRAME_LEN);
+
+            // the 32 bit timestamps wrap, records are close enough in time to unwrap them. The
+            // two cores may be slightly out of order, a big step back is a reset of the clock.
+            int32_t delta = have_time ? (int32_t)(rec.time_us - last_raw) : 0;
+            if (!have_time || delta < -1000000 || (int64_t)time_us + delta < 0)
+                time_us = rec.time_us;
+            else
+                time_us += delta;
+            last_raw = rec.time_us;
+            have_time = true;
+            printRecord(rec, time_us, delta < 0 ? 0 : delta);
+
+            Stats & s = stats[rec.id & ~TRACE_CORE1_BIT];
+            if (s.count++ == 0)
+                s.first_us = time_us;
+            s.last_us = time_us;
+        }
+        else
+        {
+            putchar(in.front());
+            at_line_start = in.front() == '\n';
+            in.pop_front();
+        }
+        if (at_line_start)
+            fflush(stdout);
+    }
+
+    printf("\n%-40s %8s %14s\n", "tracepoint", "count", "mean interval");
+    for (int id = 0; id < TRACE_COUNT; id++)
+    {
+        const Stats & s = stats[id];
+        if (!s.count)
+            continue;
+        char name[41];
+        snprintf(name, sizeof(name), "%s", trace_formats[id]);
+        if (s.count > 1)
+            printf("%-40s %8u %11llu us\n", name, s.count,
+                   (unsigned long long)((s.last_us - s.first_us) / (s.count - 1)));
+        else
+            printf("%-40s %8u %14s\n", name, s.count, "-");
+    }
+
+    if (f != stdin)
+        fclose(f);
+    return 0;
+}